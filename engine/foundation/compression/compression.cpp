@@ -0,0 +1,107 @@
+#include "foundation/compression/compression.h"
+
+#include <cstring>
+#include <limits>
+
+#ifdef MUGGLE_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace muggle
+{
+namespace compression
+{
+
+bool isCodecAvailable(Codec codec)
+{
+    switch (codec)
+    {
+        case Codec::None:
+            return true;
+        case Codec::Zlib:
+#ifdef MUGGLE_WITH_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool compress(Codec codec, const void* src, size_t srcSize, std::vector<uint8_t>& dst, int level)
+{
+    switch (codec)
+    {
+        case Codec::None:
+            dst.resize(srcSize);
+            if (srcSize > 0)
+            {
+                memcpy(dst.data(), src, srcSize);
+            }
+            return true;
+
+#ifdef MUGGLE_WITH_ZLIB
+        case Codec::Zlib:
+        {
+            if (srcSize > std::numeric_limits<uLong>::max())
+                return false;
+
+            uLongf dstSize = compressBound(static_cast<uLong>(srcSize));
+            dst.resize(dstSize);
+
+            int result = compress2(dst.data(),
+                                   &dstSize,
+                                   static_cast<const Bytef*>(src),
+                                   static_cast<uLong>(srcSize),
+                                   level < 0 ? Z_DEFAULT_COMPRESSION : level);
+            if (result != Z_OK)
+                return false;
+
+            dst.resize(dstSize);
+            return true;
+        }
+#endif
+
+        default:
+            (void)level;
+            return false;
+    }
+}
+
+bool decompress(Codec codec, const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+    switch (codec)
+    {
+        case Codec::None:
+            if (srcSize != dstSize)
+                return false;
+            if (dstSize > 0)
+            {
+                memcpy(dst, src, dstSize);
+            }
+            return true;
+
+#ifdef MUGGLE_WITH_ZLIB
+        case Codec::Zlib:
+        {
+            if (srcSize > std::numeric_limits<uLong>::max() || dstSize > std::numeric_limits<uLong>::max())
+                return false;
+
+            uLongf decompressedSize = static_cast<uLongf>(dstSize);
+            int    result           = uncompress(static_cast<Bytef*>(dst),
+                                        &decompressedSize,
+                                        static_cast<const Bytef*>(src),
+                                        static_cast<uLong>(srcSize));
+
+            return result == Z_OK && decompressedSize == dstSize;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+} // namespace compression
+} // namespace muggle
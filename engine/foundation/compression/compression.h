@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace muggle
+{
+namespace compression
+{
+
+// Compression schemes understood by the engine. The values are stored in files, do not reorder.
+enum class Codec : uint8_t
+{
+    None = 0,
+    Zlib = 1
+};
+
+// Returns false if the engine was built without support for 'codec'
+bool isCodecAvailable(Codec codec);
+
+// Compress 'srcSize' bytes into 'dst', replacing its contents.
+// Returns false on failure or if the codec is not available.
+bool compress(Codec codec, const void* src, size_t srcSize, std::vector<uint8_t>& dst, int level = -1);
+
+// Decompress 'srcSize' bytes into exactly 'dstSize' bytes at 'dst'.
+// Returns false if the data is corrupt, does not decompress to 'dstSize' bytes or the codec is not available.
+bool decompress(Codec codec, const void* src, size_t srcSize, void* dst, size_t dstSize);
+
+} // namespace compression
+} // namespace muggle
@@ -0,0 +1,430 @@
+#include "foundation/filesystem/cached_file_system.h"
+#include "foundation/hash/hash.h"
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+using namespace muggle::vfs;
+
+static std::string getCacheKey(const std::filesystem::path& name)
+{
+    return name.lexically_normal().generic_string();
+}
+
+CachedFileSystem::CachedFileSystem(std::shared_ptr<IFileSystem> fs, size_t capacityBytes, uint32_t shardCount) :
+    underlyingFS_(std::move(fs)), shardCount_(std::max(shardCount, 1u))
+{
+    shards_        = std::make_unique<Shard[]>(shardCount_);
+    shardCapacity_ = capacityBytes / shardCount_;
+}
+
+CachedFileSystem::Shard& CachedFileSystem::getShard(const std::string& key)
+{
+    return shards_[std::hash<std::string>()(key) % shardCount_];
+}
+
+std::shared_ptr<muggle::vfs::IBlob> CachedFileSystem::lookup(Shard& shard, const std::string& key, uint64_t* generation)
+{
+    checkPendingWrites();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+    {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        if (generation)
+        {
+            *generation = shard.generation;
+        }
+        return nullptr;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+
+    return it->second->blob;
+}
+
+void CachedFileSystem::insert(Shard& shard, std::string key, std::shared_ptr<IBlob> blob, uint64_t generation)
+{
+    if (blob->size() > shardCapacity_)
+        return;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // the file was written or changed since it was read, what was read may be the old contents
+    if (shard.generation != generation)
+        return;
+
+    insertLocked(shard, std::move(key), std::move(blob));
+}
+
+void CachedFileSystem::insertLocked(Shard& shard, std::string key, std::shared_ptr<IBlob> blob)
+{
+    // another reader may have inserted the same file in the meantime
+    eraseLocked(shard, key);
+
+    const size_t size = blob->size();
+    if (size > shardCapacity_)
+        return;
+
+    while (shard.bytes + size > shardCapacity_ && !shard.lru.empty())
+    {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.blob->size();
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.lru.push_front({std::move(key), std::move(blob)});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += size;
+}
+
+bool CachedFileSystem::eraseLocked(Shard& shard, const std::string& key)
+{
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+        return false;
+
+    auto entry = it->second;
+    shard.index.erase(it);
+    shard.bytes -= entry->blob->size();
+    shard.lru.erase(entry);
+    return true;
+}
+
+void CachedFileSystem::checkPendingWrites()
+{
+    if (!hasPendingWrites_.load(std::memory_order_acquire))
+        return;
+
+    std::vector<PendingWrite> failed;
+    {
+        std::lock_guard<std::mutex> lock(pendingWriteMutex_);
+
+        auto completed = std::remove_if(pendingWrites_.begin(), pendingWrites_.end(), [&failed](auto& write) {
+            if (write.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+
+            if (!write.future.get())
+            {
+                failed.push_back(std::move(write));
+            }
+            return true;
+        });
+        pendingWrites_.erase(completed, pendingWrites_.end());
+
+        hasPendingWrites_.store(!pendingWrites_.empty(), std::memory_order_release);
+    }
+
+    for (const auto& write : failed)
+    {
+        Shard&                      shard = getShard(write.key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // unless a later write replaced it
+        auto it = shard.index.find(write.key);
+        if (it != shard.index.end() && it->second->blob == write.data)
+        {
+            ++shard.generation;
+            eraseLocked(shard, write.key);
+        }
+    }
+}
+
+bool CachedFileSystem::isFolderExists(const std::filesystem::path& name)
+{
+    return underlyingFS_->isFolderExists(name);
+}
+
+bool CachedFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    return underlyingFS_->isFileExists(name);
+}
+
+FileStat CachedFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    return underlyingFS_->getFileStat(name);
+}
+
+std::vector<FileStat> CachedFileSystem::getFileStats(const std::vector<std::filesystem::path>& names)
+{
+    return underlyingFS_->getFileStats(names);
+}
+
+bool CachedFileSystem::getContentHash(const std::filesystem::path& name, uint64_t* outHash)
+{
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+
+    checkPendingWrites();
+
+    std::shared_ptr<IBlob> blob;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            if (it->second->hasContentHash)
+            {
+                *outHash = it->second->contentHash;
+                return true;
+            }
+
+            blob = it->second->blob;
+        }
+    }
+
+    // not cached: the underlying file system reads the file, which must not stall the other readers of the shard
+    if (!blob)
+        return underlyingFS_->getContentHash(name, outHash);
+
+    // hash outside of the lock, and only remember it if the entry still holds the same data
+    *outHash = muggle::hash::xxh3(blob->data(), blob->size());
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end() && it->second->blob == blob)
+    {
+        it->second->contentHash    = *outHash;
+        it->second->hasContentHash = true;
+    }
+
+    return true;
+}
+
+std::shared_ptr<IBlob> CachedFileSystem::readFile(const std::filesystem::path& name)
+{
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+
+    uint64_t generation = 0;
+    if (auto blob = lookup(shard, key, &generation))
+        return blob;
+
+    auto blob = underlyingFS_->readFile(name);
+    if (blob)
+    {
+        insert(shard, std::move(key), blob, generation);
+    }
+
+    return blob;
+}
+
+std::shared_ptr<IBlob> CachedFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+    // ranges are served from a cached copy of the file, but do not pull the whole file in on a miss
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+
+    auto blob = lookup(shard, key);
+    if (!blob)
+        return underlyingFS_->readRange(name, offset, size);
+
+    auto view = BlobView::slice(blob, static_cast<size_t>(std::min<uint64_t>(offset, SIZE_MAX)), size);
+    if (!view)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+    }
+
+    return view;
+}
+
+int64_t CachedFileSystem::readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset)
+{
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+
+    auto blob = lookup(shard, key);
+    if (!blob)
+        return underlyingFS_->readFileInto(name, buffer, size, offset);
+
+    if (offset > blob->size())
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        return static_cast<int64_t>(Status::Failed);
+    }
+
+    size = std::min<size_t>(size, blob->size() - static_cast<size_t>(offset));
+    if (size > 0)
+    {
+        memcpy(buffer, static_cast<const char*>(blob->data()) + offset, size);
+    }
+
+    return static_cast<int64_t>(size);
+}
+
+bool CachedFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    invalidate(name);
+    const bool written = underlyingFS_->writeFile(name, data, size);
+
+    // a read during the write may have cached the old contents
+    invalidate(name);
+    return written;
+}
+
+write_future_t CachedFileSystem::submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
+{
+    // cache the new contents right away, so reads do not pick up the old file while the write is pending
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        insertLocked(shard, key, data);
+    }
+
+    write_future_t future = underlyingFS_->submitWrite(name, data);
+
+    std::lock_guard<std::mutex> lock(pendingWriteMutex_);
+    pendingWrites_.push_back({std::move(key), std::move(data), future});
+    hasPendingWrites_.store(true, std::memory_order_release);
+    return future;
+}
+
+int CachedFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                     const std::vector<std::string>& extensions,
+                                     enumerate_callback_t            callback,
+                                     bool                            allowDuplicates)
+{
+    return underlyingFS_->enumerateFiles(path, extensions, callback, allowDuplicates);
+}
+
+int CachedFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                           enumerate_callback_t         callback,
+                                           bool                         allowDuplicates)
+{
+    return underlyingFS_->enumerateDirectories(path, callback, allowDuplicates);
+}
+
+int CachedFileSystem::enumerateFilesRecursive(const std::filesystem::path&    path,
+                                              const std::vector<std::string>& extensions,
+                                              enumerate_callback_t            callback,
+                                              bool                            allowDuplicates)
+{
+    return underlyingFS_->enumerateFilesRecursive(path, extensions, callback, allowDuplicates);
+}
+
+watch_id_t CachedFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    auto invalidating = [this, callback = std::move(callback)](const std::vector<FileChange>& changes) {
+        for (const auto& change : changes)
+        {
+            if (change.type == FileChange::Type::Overflow)
+            {
+                clear();
+                break;
+            }
+
+            if (change.type == FileChange::Type::Removed)
+            {
+                invalidateTree(change.path);
+            }
+            else
+            {
+                invalidate(change.path);
+            }
+        }
+        callback(changes);
+    };
+
+    return underlyingFS_->addWatch(path, std::move(invalidating), recursive);
+}
+
+bool CachedFileSystem::removeWatch(watch_id_t id)
+{
+    return underlyingFS_->removeWatch(id);
+}
+
+void CachedFileSystem::invalidate(const std::filesystem::path& name)
+{
+    std::string key   = getCacheKey(name);
+    Shard&      shard = getShard(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    ++shard.generation;
+    eraseLocked(shard, key);
+}
+
+void CachedFileSystem::invalidateTree(const std::filesystem::path& name)
+{
+    std::string key = getCacheKey(name);
+    {
+        Shard&                      shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // a cached file has nothing under it
+        ++shard.generation;
+        if (eraseLocked(shard, key))
+            return;
+    }
+
+    if (key.empty() || key.back() != '/')
+    {
+        key += '/';
+    }
+
+    for (uint32_t i = 0; i < shardCount_; ++i)
+    {
+        Shard&                      shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        ++shard.generation;
+        for (auto entry = shard.lru.begin(); entry != shard.lru.end();)
+        {
+            if (entry->key.compare(0, key.size(), key) == 0)
+            {
+                shard.index.erase(entry->key);
+                shard.bytes -= entry->blob->size();
+                entry = shard.lru.erase(entry);
+            }
+            else
+            {
+                ++entry;
+            }
+        }
+    }
+}
+
+void CachedFileSystem::clear()
+{
+    for (uint32_t i = 0; i < shardCount_; ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+
+        ++shards_[i].generation;
+        shards_[i].index.clear();
+        shards_[i].lru.clear();
+        shards_[i].bytes = 0;
+    }
+}
+
+CachedFileSystem::Statistics CachedFileSystem::getStatistics() const
+{
+    Statistics statistics;
+
+    for (uint32_t i = 0; i < shardCount_; ++i)
+    {
+        Shard& shard = shards_[i];
+
+        statistics.hits += shard.hits.load(std::memory_order_relaxed);
+        statistics.misses += shard.misses.load(std::memory_order_relaxed);
+        statistics.evictions += shard.evictions.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        statistics.bytes += shard.bytes;
+        statistics.entries += shard.lru.size();
+    }
+
+    return statistics;
+}
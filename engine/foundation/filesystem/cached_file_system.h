@@ -0,0 +1,144 @@
+#pragma once
+
+#include "foundation/filesystem/vfs.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// A layer that keeps recently read files in memory.
+// Blobs are kept in a least-recently-used cache bounded by a byte budget, split into independently locked
+// shards so concurrent readers rarely contend. Writes through this layer, and changes reported by watches added
+// through it, invalidate the cached copy; other changes are not seen until the entry is evicted or invalidated.
+// Data written with submitWrite is served from the cache while the write is pending, and dropped if it fails.
+class CachedFileSystem : public IFileSystem {
+public:
+    struct Statistics
+    {
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+        size_t   bytes     = 0; // currently cached
+        size_t   entries   = 0;
+    };
+
+    static constexpr uint32_t kDefaultShardCount = 16;
+
+    // Files larger than a shard's share of 'capacityBytes' are never cached
+    CachedFileSystem(std::shared_ptr<IFileSystem> fs, size_t capacityBytes, uint32_t shardCount = kDefaultShardCount);
+
+    std::filesystem::path getFullPath(const std::filesystem::path& name) const override
+    {
+        return underlyingFS_->getFullPath(name);
+    }
+
+    bool isImmutable() const override
+    {
+        return underlyingFS_->isImmutable();
+    }
+
+    bool                   isFolderExists(const std::filesystem::path& name) override;
+    bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::vector<FileStat>  getFileStats(const std::vector<std::filesystem::path>& names) override;
+    // Hashes the cached copy of the file if there is one, and remembers the hash along with it
+    bool                   getContentHash(const std::filesystem::path& name, uint64_t* outHash) override;
+    std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    int64_t                readFileInto(const std::filesystem::path& name,
+                                        void*                        buffer,
+                                        size_t                       size,
+                                        uint64_t                     offset /* = 0 */) override;
+    bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    write_future_t         submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data) override;
+    int                    enumerateFiles(const std::filesystem::path&    path,
+                                          const std::vector<std::string>& extensions,
+                                          enumerate_callback_t            callback,
+                                          bool                            allowDuplicates /* = false */) override;
+    int                    enumerateDirectories(const std::filesystem::path& path,
+                                                enumerate_callback_t         callback,
+                                                bool                         allowDuplicates /* = false */) override;
+    int                    enumerateFilesRecursive(const std::filesystem::path&    path,
+                                                   const std::vector<std::string>& extensions,
+                                                   enumerate_callback_t            callback,
+                                                   bool allowDuplicates /* = false */) override;
+    // Changes reported through a watch also drop the cached copies of the changed files, an overflow every copy.
+    // Remove such watches before destroying the cache.
+    watch_id_t             addWatch(const std::filesystem::path& path,
+                                    watch_callback_t             callback,
+                                    bool                         recursive /* = true */) override;
+    bool                   removeWatch(watch_id_t id) override;
+
+    // Drop the cached copy of a file, if any
+    void invalidate(const std::filesystem::path& name);
+
+    // Drop the cached copy of a file, or of every file under a directory
+    void invalidateTree(const std::filesystem::path& name);
+
+    // Drop every cached file
+    void clear();
+
+    [[nodiscard]] Statistics getStatistics() const;
+
+private:
+    struct Entry
+    {
+        std::string            key;
+        std::shared_ptr<IBlob> blob;
+        uint64_t               contentHash    = 0;
+        bool                   hasContentHash = false;
+    };
+
+    // aligned so that the counters of different shards never share a cache line
+    struct alignas(64) Shard
+    {
+        std::mutex                                                   mutex;
+        std::list<Entry>                                             lru; // most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        size_t                                                       bytes = 0;
+
+        // bumped whenever an entry is dropped or replaced, so a read that missed before does not insert old data
+        uint64_t generation = 0;
+
+        std::atomic<uint64_t> hits {0};
+        std::atomic<uint64_t> misses {0};
+        std::atomic<uint64_t> evictions {0};
+    };
+
+    struct PendingWrite
+    {
+        std::string            key;
+        std::shared_ptr<IBlob> data;
+        write_future_t         future;
+    };
+
+    Shard& getShard(const std::string& key);
+
+    // On a miss, 'generation' is that of the shard, to be given to insert
+    std::shared_ptr<IBlob> lookup(Shard& shard, const std::string& key, uint64_t* generation = nullptr);
+    void                   insert(Shard& shard, std::string key, std::shared_ptr<IBlob> blob, uint64_t generation);
+    void                   insertLocked(Shard& shard, std::string key, std::shared_ptr<IBlob> blob);
+    bool                   eraseLocked(Shard& shard, const std::string& key);
+
+    // Drop the cached data of the writes that failed
+    void checkPendingWrites();
+
+    std::shared_ptr<IFileSystem> underlyingFS_;
+    size_t                       shardCapacity_ = 0;
+    std::unique_ptr<Shard[]>     shards_;
+    uint32_t                     shardCount_ = 0;
+
+    std::mutex                pendingWriteMutex_;
+    std::vector<PendingWrite> pendingWrites_;
+    std::atomic<bool>         hasPendingWrites_ {false};
+};
+
+} // namespace vfs
+} // namespace muggle
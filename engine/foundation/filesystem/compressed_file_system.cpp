@@ -0,0 +1,521 @@
+#include "foundation/filesystem/compressed_file_system.h"
+#include "foundation/filesystem/file_pattern.h"
+#include "foundation/log/log_system.h"
+#include "foundation/thread/thread_pool.h"
+#include "foundation/utility/string_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+
+using namespace muggle::vfs;
+using namespace muggle::vfs::chunked;
+
+namespace
+{
+
+bool checkHeader(const ChunkedHeader& header)
+{
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.chunkSize == 0)
+        return false;
+
+    if (!muggle::compression::isCodecAvailable(static_cast<muggle::compression::Codec>(header.codec)))
+        return false;
+
+    return header.chunkCount == header.size / header.chunkSize + (header.size % header.chunkSize != 0);
+}
+
+bool checkOffsets(const ChunkedHeader& header, const std::vector<uint64_t>& offsets, uint64_t storedSize)
+{
+    if (offsets.size() != header.chunkCount + size_t(1))
+        return false;
+
+    if (offsets.front() != sizeof(ChunkedHeader) + offsets.size() * sizeof(uint64_t) || offsets.back() > storedSize)
+        return false;
+
+    return std::is_sorted(offsets.begin(), offsets.end());
+}
+
+std::string getTableKey(const std::filesystem::path& compressedName)
+{
+    return compressedName.lexically_normal().generic_string();
+}
+
+// decompressed size of a chunk
+size_t getChunkSize(const ChunkedHeader& header, uint32_t index)
+{
+    const uint64_t start = static_cast<uint64_t>(index) * header.chunkSize;
+    return static_cast<size_t>(std::min<uint64_t>(header.chunkSize, header.size - start));
+}
+
+bool decompressChunk(const ChunkedHeader& header, uint32_t index, const void* stored, size_t storedSize, void* dst)
+{
+    const size_t size = getChunkSize(header, index);
+
+    if (storedSize == size)
+    {
+        memcpy(dst, stored, size);
+        return true;
+    }
+
+    return muggle::compression::decompress(
+        static_cast<muggle::compression::Codec>(header.codec), stored, storedSize, dst, size);
+}
+
+// Decompress chunks 'first' to 'last' of a file whose stored bytes from offsets[first] on are at 'stored'.
+// Returns nullptr if any of them is corrupt.
+std::shared_ptr<IBlob> decompressChunks(const ChunkedHeader&         header,
+                                        const std::vector<uint64_t>& offsets,
+                                        uint32_t                     first,
+                                        uint32_t                     last,
+                                        const char*                  stored)
+{
+    const uint64_t begin = static_cast<uint64_t>(first) * header.chunkSize;
+    const uint64_t end   = std::min<uint64_t>(static_cast<uint64_t>(last + 1) * header.chunkSize, header.size);
+
+    if (end - begin > std::numeric_limits<size_t>::max())
+        return nullptr;
+
+    const size_t size = static_cast<size_t>(end - begin);
+    if (size == 0)
+        return std::make_shared<Blob>(nullptr, 0);
+
+    char* data = static_cast<char*>(malloc(size));
+    if (!data)
+        return nullptr;
+
+    auto blob = std::make_shared<Blob>(data, size);
+
+    std::atomic<bool> failed {false};
+    muggle::ThreadPool::getWorkerPool().parallelFor(last - first + 1, [&](size_t i) {
+        const uint32_t index      = first + static_cast<uint32_t>(i);
+        const char*    chunk      = stored + (offsets[index] - offsets[first]);
+        const size_t   storedSize = static_cast<size_t>(offsets[index + 1] - offsets[index]);
+
+        char* dst = data + (static_cast<uint64_t>(index) * header.chunkSize - begin);
+        if (!decompressChunk(header, index, chunk, storedSize, dst))
+        {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    return failed.load() ? nullptr : blob;
+}
+
+} // namespace
+
+bool muggle::vfs::chunked::compress(const void*           data,
+                                    size_t                size,
+                                    compression::Codec    codec,
+                                    std::vector<uint8_t>& dst,
+                                    uint32_t              chunkSize,
+                                    int                   level)
+{
+    if (chunkSize == 0 || !compression::isCodecAvailable(codec))
+        return false;
+
+    const uint64_t chunkCount = (static_cast<uint64_t>(size) + chunkSize - 1) / chunkSize;
+    if (chunkCount > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    const char* src = static_cast<const char*>(data);
+
+    // chunks that do not get smaller are stored as they are
+    std::vector<std::vector<uint8_t>> chunks(static_cast<size_t>(chunkCount));
+    muggle::ThreadPool::getWorkerPool().parallelFor(chunks.size(), [&](size_t index) {
+        const char*  chunk   = src + index * chunkSize;
+        const size_t rawSize = std::min<size_t>(chunkSize, size - index * chunkSize);
+
+        if (!compression::compress(codec, chunk, rawSize, chunks[index], level) || chunks[index].size() >= rawSize)
+        {
+            chunks[index].assign(chunk, chunk + rawSize);
+        }
+    });
+
+    ChunkedHeader header {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version    = kVersion;
+    header.size       = size;
+    header.chunkSize  = chunkSize;
+    header.chunkCount = static_cast<uint32_t>(chunkCount);
+    header.codec      = static_cast<uint8_t>(codec);
+
+    std::vector<uint64_t> offsets(chunks.size() + 1);
+    offsets[0] = sizeof(ChunkedHeader) + offsets.size() * sizeof(uint64_t);
+    for (size_t index = 0; index < chunks.size(); ++index)
+    {
+        offsets[index + 1] = offsets[index] + chunks[index].size();
+    }
+
+    dst.resize(static_cast<size_t>(offsets.back()));
+    memcpy(dst.data(), &header, sizeof(header));
+    memcpy(dst.data() + sizeof(header), offsets.data(), offsets.size() * sizeof(uint64_t));
+
+    for (size_t index = 0; index < chunks.size(); ++index)
+    {
+        if (!chunks[index].empty())
+        {
+            memcpy(dst.data() + offsets[index], chunks[index].data(), chunks[index].size());
+        }
+    }
+
+    return true;
+}
+
+CompressedFileSystem::CompressedFileSystem(std::shared_ptr<IFileSystem> fs,
+                                           compression::Codec           writeCodec,
+                                           uint32_t                     chunkSize) :
+    underlyingFS_(std::move(fs)), writeCodec_(writeCodec), chunkSize_(std::max(chunkSize, 1u))
+{}
+
+std::filesystem::path CompressedFileSystem::getCompressedName(const std::filesystem::path& name)
+{
+    std::filesystem::path compressedName = name;
+    compressedName += kExtension;
+    return compressedName;
+}
+
+bool CompressedFileSystem::isCompressed(const std::filesystem::path& compressedName)
+{
+    return underlyingFS_->getFileStat(compressedName).isFile();
+}
+
+bool CompressedFileSystem::readChunkTable(const std::filesystem::path& compressedName, ChunkTable* pTable)
+{
+    const FileStat stat = underlyingFS_->getFileStat(compressedName);
+
+    auto header = underlyingFS_->readRange(compressedName, 0, sizeof(ChunkedHeader));
+    if (!header || header->size() != sizeof(ChunkedHeader))
+        return false;
+
+    memcpy(&pTable->header, header->data(), sizeof(ChunkedHeader));
+    if (!checkHeader(pTable->header) ||
+        stat.size < sizeof(ChunkedHeader) + (pTable->header.chunkCount + uint64_t(1)) * sizeof(uint64_t))
+        return false;
+
+    pTable->offsets.resize(pTable->header.chunkCount + size_t(1));
+
+    const size_t offsetsSize = pTable->offsets.size() * sizeof(uint64_t);
+    auto         offsets     = underlyingFS_->readRange(compressedName, sizeof(ChunkedHeader), offsetsSize);
+    if (!offsets || offsets->size() != offsetsSize)
+        return false;
+
+    memcpy(pTable->offsets.data(), offsets->data(), offsetsSize);
+    return checkOffsets(pTable->header, pTable->offsets, stat.size);
+}
+
+std::shared_ptr<const CompressedFileSystem::ChunkTable>
+CompressedFileSystem::findChunkTable(const std::filesystem::path& compressedName)
+{
+    const std::string key = getTableKey(compressedName);
+
+    std::lock_guard<std::mutex> lock(tableMutex_);
+
+    auto it = tables_.find(key);
+    return it != tables_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<const CompressedFileSystem::ChunkTable>
+CompressedFileSystem::getChunkTable(const std::filesystem::path& compressedName)
+{
+    std::string key = getTableKey(compressedName);
+
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(tableMutex_);
+
+        auto it = tables_.find(key);
+        if (it != tables_.end())
+            return it->second;
+
+        generation = tableGeneration_;
+    }
+
+    auto table = std::make_shared<ChunkTable>();
+    if (!readChunkTable(compressedName, table.get()))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(tableMutex_);
+
+    // the file may have changed while the table was read
+    if (generation == tableGeneration_)
+    {
+        if (tables_.size() >= kMaxChunkTables)
+        {
+            tables_.clear();
+        }
+        tables_.emplace(std::move(key), table);
+    }
+
+    return table;
+}
+
+void CompressedFileSystem::invalidateChunkTable(const std::filesystem::path& compressedName, bool tree)
+{
+    std::string key = getTableKey(compressedName);
+
+    std::lock_guard<std::mutex> lock(tableMutex_);
+
+    ++tableGeneration_;
+    if (tables_.erase(key) > 0 || !tree)
+        return;
+
+    if (key.empty() || key.back() != '/')
+    {
+        key += '/';
+    }
+
+    for (auto it = tables_.begin(); it != tables_.end();)
+    {
+        it = it->first.compare(0, key.size(), key) == 0 ? tables_.erase(it) : std::next(it);
+    }
+}
+
+void CompressedFileSystem::clearChunkTables()
+{
+    std::lock_guard<std::mutex> lock(tableMutex_);
+
+    ++tableGeneration_;
+    tables_.clear();
+}
+
+bool CompressedFileSystem::isFolderExists(const std::filesystem::path& name)
+{
+    return underlyingFS_->isFolderExists(name);
+}
+
+bool CompressedFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    return isCompressed(getCompressedName(name)) || underlyingFS_->isFileExists(name);
+}
+
+FileStat CompressedFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    const std::filesystem::path compressedName = getCompressedName(name);
+
+    FileStat stat = underlyingFS_->getFileStat(compressedName);
+    if (!stat.isFile())
+        return underlyingFS_->getFileStat(name);
+
+    // the size is the one of the decompressed file
+    if (auto table = findChunkTable(compressedName))
+    {
+        stat.size = table->header.size;
+        return stat;
+    }
+
+    auto header = underlyingFS_->readRange(compressedName, 0, sizeof(ChunkedHeader));
+    if (header && header->size() == sizeof(ChunkedHeader))
+    {
+        ChunkedHeader chunkedHeader;
+        memcpy(&chunkedHeader, header->data(), sizeof(chunkedHeader));
+        stat.size = chunkedHeader.size;
+    }
+
+    return stat;
+}
+
+std::shared_ptr<IBlob> CompressedFileSystem::readFile(const std::filesystem::path& name)
+{
+    const std::filesystem::path compressedName = getCompressedName(name);
+
+    if (!isCompressed(compressedName))
+        return underlyingFS_->readFile(name);
+
+    auto stored = underlyingFS_->readFile(compressedName);
+    if (!stored)
+        return nullptr;
+
+    const char*           data = static_cast<const char*>(stored->data());
+    ChunkedHeader         header {};
+    std::vector<uint64_t> offsets;
+
+    if (stored->size() >= sizeof(ChunkedHeader))
+    {
+        memcpy(&header, data, sizeof(header));
+    }
+
+    if (checkHeader(header) &&
+        stored->size() >= sizeof(ChunkedHeader) + (header.chunkCount + uint64_t(1)) * sizeof(uint64_t))
+    {
+        offsets.resize(header.chunkCount + size_t(1));
+        memcpy(offsets.data(), data + sizeof(ChunkedHeader), offsets.size() * sizeof(uint64_t));
+    }
+
+    if (!checkOffsets(header, offsets, stored->size()))
+    {
+        LOG_ERROR("Read File: {} Failed! Not a valid compressed file", compressedName.string());
+        return nullptr;
+    }
+
+    if (header.chunkCount == 0)
+        return std::make_shared<Blob>(nullptr, 0);
+
+    auto blob = decompressChunks(header, offsets, 0, header.chunkCount - 1, data + offsets[0]);
+    if (!blob)
+    {
+        LOG_ERROR("Read File: {} Failed! Corrupt compressed data", compressedName.string());
+    }
+
+    return blob;
+}
+
+std::shared_ptr<IBlob> CompressedFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+    const std::filesystem::path compressedName = getCompressedName(name);
+
+    // a cached table means the file is compressed, which saves looking for it
+    auto table = findChunkTable(compressedName);
+    if (!table)
+    {
+        if (!isCompressed(compressedName))
+            return underlyingFS_->readRange(name, offset, size);
+
+        table = getChunkTable(compressedName);
+        if (!table)
+        {
+            LOG_ERROR("Read File: {} Failed! Not a valid compressed file", compressedName.string());
+            return nullptr;
+        }
+    }
+
+    const ChunkedHeader& header = table->header;
+
+    const uint64_t end = size == 0 ? header.size : offset + size;
+    if (offset > header.size || end > header.size || end < offset)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        return nullptr;
+    }
+
+    if (end == offset)
+        return std::make_shared<Blob>(nullptr, 0);
+
+    // only the chunks overlapping the range are read and decompressed
+    const uint32_t first = static_cast<uint32_t>(offset / header.chunkSize);
+    const uint32_t last  = static_cast<uint32_t>((end - 1) / header.chunkSize);
+
+    const uint64_t storedOffset = table->offsets[first];
+    const uint64_t storedSize   = table->offsets[last + 1] - storedOffset;
+
+    auto stored = underlyingFS_->readRange(compressedName, storedOffset, static_cast<size_t>(storedSize));
+    if (!stored || stored->size() != storedSize)
+        return nullptr;
+
+    auto chunks = decompressChunks(header, table->offsets, first, last, static_cast<const char*>(stored->data()));
+    if (!chunks)
+    {
+        LOG_ERROR("Read File: {} Failed! Corrupt compressed data", compressedName.string());
+        return nullptr;
+    }
+
+    const uint64_t chunksOffset = static_cast<uint64_t>(first) * header.chunkSize;
+    return BlobView::slice(chunks, static_cast<size_t>(offset - chunksOffset), static_cast<size_t>(end - offset));
+}
+
+bool CompressedFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    const std::filesystem::path compressedName = getCompressedName(name);
+
+    compression::Codec codec = writeCodec_;
+    if (codec == compression::Codec::None)
+    {
+        if (!isCompressed(compressedName))
+            return underlyingFS_->writeFile(name, data, size);
+
+        // compressed files keep their codec; one that cannot be read is replaced by uncompressed chunks
+        if (auto table = getChunkTable(compressedName))
+        {
+            codec = static_cast<compression::Codec>(table->header.codec);
+        }
+    }
+
+    std::vector<uint8_t> compressed;
+    if (!chunked::compress(data, size, codec, compressed, chunkSize_))
+    {
+        LOG_ERROR("Write File: {} Failed! Cannot compress the data", name.string());
+        return false;
+    }
+
+    invalidateChunkTable(compressedName);
+    bool result = underlyingFS_->writeFile(compressedName, compressed.data(), compressed.size());
+
+    // a read during the write may have cached the table of either version
+    invalidateChunkTable(compressedName);
+    return result;
+}
+
+int CompressedFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                         const std::vector<std::string>& extensions,
+                                         enumerate_callback_t            callback,
+                                         bool                            allowDuplicates)
+{
+    const FilePattern pattern = FilePattern::fromExtensions(extensions);
+
+    // the extensions apply to the uncompressed names, so every file is listed
+    std::vector<std::string> files;
+    int result = underlyingFS_->enumerateFiles(path, {}, enumerate_to_vector(files), allowDuplicates);
+    if (result < 0)
+        return result;
+
+    std::unordered_set<std::string_view> seen;
+    int                                  numEntries = 0;
+
+    for (const auto& file : files)
+    {
+        std::string_view fileName = file;
+        if (muggle::string_utils::ends_with(fileName, kExtension))
+        {
+            fileName.remove_suffix(strlen(kExtension));
+        }
+
+        if (!pattern.matches(fileName) || (!allowDuplicates && !seen.insert(fileName).second))
+            continue;
+
+        callback(fileName);
+        ++numEntries;
+    }
+
+    return numEntries;
+}
+
+int CompressedFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                               enumerate_callback_t         callback,
+                                               bool                         allowDuplicates)
+{
+    return underlyingFS_->enumerateDirectories(path, callback, allowDuplicates);
+}
+
+watch_id_t CompressedFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    auto renaming = [this, callback = std::move(callback)](const std::vector<FileChange>& changes) {
+        std::vector<FileChange> renamed(changes);
+        for (auto& change : renamed)
+        {
+            if (change.type == FileChange::Type::Overflow)
+            {
+                clearChunkTables();
+            }
+            else
+            {
+                invalidateChunkTable(change.path, change.type == FileChange::Type::Removed);
+            }
+
+            if (change.path.extension() == kExtension)
+            {
+                change.path.replace_extension();
+            }
+        }
+        callback(renamed);
+    };
+
+    return underlyingFS_->addWatch(path, std::move(renaming), recursive);
+}
+
+bool CompressedFileSystem::removeWatch(watch_id_t id)
+{
+    return underlyingFS_->removeWatch(id);
+}
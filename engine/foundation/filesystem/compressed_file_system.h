@@ -0,0 +1,135 @@
+#pragma once
+
+#include "foundation/compression/compression.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Layout of a chunked compressed file, all values little endian:
+//   ChunkedHeader
+//   uint64_t offsets[chunkCount + 1], from the start of the file; chunk i is stored in [offsets[i], offsets[i + 1])
+//   chunk data
+// Every chunk decompresses to 'chunkSize' bytes, except the last one which holds the rest of the file.
+// Chunks are compressed independently, so that they can be decompressed in parallel and ranges of the file can be
+// read without decompressing all of it. A chunk whose stored size is its decompressed size is stored uncompressed.
+namespace chunked
+{
+static constexpr char        kMagic[4]         = {'M', 'C', 'H', 'K'};
+static constexpr uint32_t    kVersion          = 1;
+static constexpr uint32_t    kDefaultChunkSize = 256 * 1024;
+static constexpr const char* kExtension        = ".mcz";
+
+struct ChunkedHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint64_t size; // of the file once decompressed
+    uint32_t chunkSize;
+    uint32_t chunkCount;
+    uint8_t  codec; // muggle::compression::Codec
+    uint8_t  reserved[7];
+};
+
+static_assert(sizeof(ChunkedHeader) == 32, "ChunkedHeader layout must not change");
+
+// Compress 'size' bytes into the chunked format, replacing the contents of 'dst'. The chunks are compressed
+// in parallel. Returns false if 'codec' is not available or 'chunkSize' is 0.
+bool compress(const void*           data,
+              size_t                size,
+              compression::Codec    codec,
+              std::vector<uint8_t>& dst,
+              uint32_t              chunkSize = kDefaultChunkSize,
+              int                   level     = -1);
+} // namespace chunked
+
+// A layer that transparently decompresses files stored in the chunked format.
+// A file 'name' is read from 'name' + chunked::kExtension when that exists in the underlying file system,
+// which hides an uncompressed 'name', and from 'name' itself otherwise. Enumerations list compressed files under
+// their uncompressed names. Whole files are decompressed on the worker pool, one chunk per task, and ranged reads
+// only decompress the chunks they touch.
+// The chunk tables of the compressed files are kept in memory once read, so that a ranged read costs a single read
+// of the underlying file. Writes through this layer, and changes reported by watches added through it, drop them;
+// other changes of compressed files are not seen until the tables are dropped.
+class CompressedFileSystem : public IFileSystem {
+public:
+    // Files written through this layer are compressed with 'writeCodec', unless it is Codec::None.
+    // Files that are already compressed stay so when they are written, with their own codec if 'writeCodec' is None.
+    explicit CompressedFileSystem(std::shared_ptr<IFileSystem> fs,
+                                  compression::Codec           writeCodec = compression::Codec::None,
+                                  uint32_t                     chunkSize  = chunked::kDefaultChunkSize);
+
+    std::filesystem::path getFullPath(const std::filesystem::path& name) const override
+    {
+        return underlyingFS_->getFullPath(name);
+    }
+
+    bool isImmutable() const override
+    {
+        return underlyingFS_->isImmutable();
+    }
+
+    bool                   isFolderExists(const std::filesystem::path& name) override;
+    bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    int                    enumerateFiles(const std::filesystem::path&    path,
+                                          const std::vector<std::string>& extensions,
+                                          enumerate_callback_t            callback,
+                                          bool                            allowDuplicates /* = false */) override;
+    int                    enumerateDirectories(const std::filesystem::path& path,
+                                                enumerate_callback_t         callback,
+                                                bool                         allowDuplicates /* = false */) override;
+    // Changes of compressed files are reported under their uncompressed names, and drop their chunk tables.
+    // Remove such watches before destroying this layer.
+    watch_id_t             addWatch(const std::filesystem::path& path,
+                                    watch_callback_t             callback,
+                                    bool                         recursive /* = true */) override;
+    bool                   removeWatch(watch_id_t id) override;
+
+    // Drop every chunk table
+    void clearChunkTables();
+
+private:
+    struct ChunkTable
+    {
+        chunked::ChunkedHeader header {};
+        std::vector<uint64_t>  offsets;
+    };
+
+    static std::filesystem::path getCompressedName(const std::filesystem::path& name);
+
+    bool isCompressed(const std::filesystem::path& compressedName);
+    bool readChunkTable(const std::filesystem::path& compressedName, ChunkTable* pTable);
+
+    // The chunk table of a compressed file, read and cached on a miss. Returns nullptr if the file is not valid.
+    std::shared_ptr<const ChunkTable> getChunkTable(const std::filesystem::path& compressedName);
+    std::shared_ptr<const ChunkTable> findChunkTable(const std::filesystem::path& compressedName);
+
+    // Drop the chunk table of a compressed file, or with 'tree' also those of the files under a directory
+    void invalidateChunkTable(const std::filesystem::path& compressedName, bool tree = false);
+
+    std::shared_ptr<IFileSystem> underlyingFS_;
+    compression::Codec           writeCodec_;
+    uint32_t                     chunkSize_;
+
+    // by normalized name of the compressed file, emptied at once when full
+    static constexpr size_t kMaxChunkTables = 4096;
+
+    std::mutex                                                         tableMutex_;
+    std::unordered_map<std::string, std::shared_ptr<const ChunkTable>> tables_;
+    uint64_t tableGeneration_ = 0; // bumped when tables are dropped, so that a read does not insert an old table
+};
+
+} // namespace vfs
+} // namespace muggle
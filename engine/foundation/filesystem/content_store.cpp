@@ -0,0 +1,462 @@
+#include "foundation/filesystem/content_store.h"
+#include "foundation/filesystem/file_pattern.h"
+#include "foundation/hash/hash.h"
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+using namespace muggle::vfs;
+
+static constexpr std::string_view kIndexHeader = "muggle-content-index 1";
+
+template<typename T>
+static bool parseNumber(std::string_view text, T* outValue, int base)
+{
+    auto result = std::from_chars(text.data(), text.data() + text.size(), *outValue, base);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+ContentStore::ContentStore(std::shared_ptr<IFileSystem> objectFS) : objectFS_(std::move(objectFS))
+{}
+
+std::filesystem::path ContentStore::getObjectPath(uint64_t hash)
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016" PRIx64, hash);
+    return name;
+}
+
+std::filesystem::path ContentStore::getFullPath(const std::filesystem::path& name) const
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = files_.find(path);
+    if (it == files_.end())
+        return name;
+
+    return objectFS_->getFullPath(getObjectPath(it->second.hash));
+}
+
+bool ContentStore::isFolderExists(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tree_.isDirectory(path);
+}
+
+bool ContentStore::isFileExists(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return files_.find(path) != files_.end();
+}
+
+FileStat ContentStore::getFileStat(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+    FileStat    result;
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = files_.find(path);
+    if (it != files_.end())
+    {
+        result.type = FileStat::Type::File;
+        result.size = it->second.size;
+    }
+    else if (tree_.isDirectory(path))
+    {
+        result.type = FileStat::Type::Directory;
+    }
+
+    return result;
+}
+
+bool ContentStore::getContentHash(const std::filesystem::path& name, uint64_t* outHash)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = files_.find(path);
+    if (it == files_.end())
+        return false;
+
+    *outHash = it->second.hash;
+    return true;
+}
+
+std::shared_ptr<IBlob> ContentStore::readFile(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+    FileEntry   entry;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+
+        auto it = files_.find(path);
+        if (it == files_.end())
+            return nullptr;
+
+        entry = it->second;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(objectMutex_);
+
+        auto it = residentBlobs_.find(entry.hash);
+        if (it != residentBlobs_.end())
+        {
+            if (auto blob = it->second.lock())
+                return blob;
+        }
+    }
+
+    std::shared_ptr<IBlob> blob = objectFS_->readFile(getObjectPath(entry.hash));
+    if (!blob || blob->size() != entry.size)
+    {
+        LOG_ERROR("Read File: {} Failed! Object {} is missing or damaged",
+                  name.string(),
+                  getObjectPath(entry.hash).string());
+        return nullptr;
+    }
+
+    return internBlob(entry.hash, std::move(blob));
+}
+
+std::shared_ptr<IBlob> ContentStore::internBlob(uint64_t hash, std::shared_ptr<IBlob> blob)
+{
+    std::lock_guard<std::mutex> lock(objectMutex_);
+
+    // another reader may have loaded the same contents in the meantime
+    std::weak_ptr<IBlob>& resident = residentBlobs_[hash];
+    if (auto existing = resident.lock())
+        return existing;
+
+    resident = blob;
+
+    if (residentBlobs_.size() >= residentSweepSize_)
+    {
+        for (auto it = residentBlobs_.begin(); it != residentBlobs_.end();)
+        {
+            it = it->second.expired() ? residentBlobs_.erase(it) : std::next(it);
+        }
+        residentSweepSize_ = std::max<size_t>(1024, residentBlobs_.size() * 2);
+    }
+
+    return blob;
+}
+
+bool ContentStore::matchesObject(uint64_t hash, const void* data, size_t size)
+{
+    std::shared_ptr<IBlob> stored;
+    {
+        std::lock_guard<std::mutex> lock(objectMutex_);
+
+        auto it = residentBlobs_.find(hash);
+        if (it != residentBlobs_.end())
+        {
+            stored = it->second.lock();
+        }
+    }
+
+    if (!stored)
+    {
+        stored = objectFS_->readFile(getObjectPath(hash));
+        if (!stored)
+            return false;
+    }
+
+    return stored->size() == size && (size == 0 || stored->data() == data || memcmp(stored->data(), data, size) == 0);
+}
+
+bool ContentStore::storeObject(const std::filesystem::path& name, uint64_t hash, const void* data, size_t size)
+{
+    bool stored = false;
+    {
+        std::lock_guard<std::mutex> lock(objectMutex_);
+
+        auto it = objects_.find(hash);
+        stored  = it != objects_.end() && it->second == size;
+    }
+
+    const std::filesystem::path objectPath = getObjectPath(hash);
+
+    if (!stored)
+    {
+        // the object may have been stored by an earlier session that did not save its index
+        FileStat stat = objectFS_->getFileStat(objectPath);
+        stored        = stat.isFile() && stat.size == size;
+
+        if (stat.exists() && !stored)
+        {
+            LOG_ERROR("Write File: {} Failed! Object {} has different contents with the same hash",
+                      name.string(),
+                      objectPath.string());
+            return false;
+        }
+    }
+
+    // a matching hash and size do not make the contents the same
+    if (stored && !matchesObject(hash, data, size))
+    {
+        LOG_ERROR("Write File: {} Failed! Object {} has different contents with the same hash",
+                  name.string(),
+                  objectPath.string());
+        return false;
+    }
+
+    if (!stored && !objectFS_->writeFile(objectPath, data, size))
+    {
+        LOG_ERROR("Write File: {} Failed! Cannot store object {}", name.string(), objectPath.string());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(objectMutex_);
+
+    objects_[hash] = size;
+    if (stored)
+    {
+        ++dedupedFiles_;
+        dedupedBytes_ += size;
+    }
+
+    return true;
+}
+
+bool ContentStore::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    if (isFolderExists(name))
+    {
+        LOG_ERROR("Write File: {} Failed! The path is a folder", name.string());
+        return false;
+    }
+
+    const uint64_t hash = muggle::hash::xxh3(data, size);
+
+    if (!storeObject(name, hash, data, size))
+        return false;
+
+    return addEntry(name, {hash, size});
+}
+
+bool ContentStore::addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> blob)
+{
+    if (!blob)
+    {
+        LOG_ERROR("Write File: {} Failed! No data", name.string());
+        return false;
+    }
+
+    if (isFolderExists(name))
+    {
+        LOG_ERROR("Write File: {} Failed! The path is a folder", name.string());
+        return false;
+    }
+
+    const uint64_t hash = muggle::hash::xxh3(blob->data(), blob->size());
+
+    if (!storeObject(name, hash, blob->data(), blob->size()))
+        return false;
+
+    internBlob(hash, blob);
+    return addEntry(name, {hash, blob->size()});
+}
+
+bool ContentStore::addEntry(const std::filesystem::path& name, const FileEntry& entry)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (!tree_.addFile(path, name))
+        return false;
+
+    files_.insert_or_assign(std::move(path), entry);
+    return true;
+}
+
+bool ContentStore::removeFile(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (files_.erase(path) == 0)
+        return false;
+
+    tree_.removeFile(path);
+    return true;
+}
+
+bool ContentStore::loadIndex()
+{
+    std::shared_ptr<IBlob> blob = objectFS_->readFile(kIndexFileName);
+    if (!blob)
+        return false;
+
+    std::string_view text(static_cast<const char*>(blob->data()), blob->size());
+    std::string_view line = text.substr(0, text.find('\n'));
+
+    if (line != kIndexHeader)
+    {
+        LOG_ERROR("Load Content Index: {} Failed! Unknown format", objectFS_->getFullPath(kIndexFileName).string());
+        return false;
+    }
+
+    // one "<hash> <size> <name>" line per file
+    std::unordered_map<std::string, FileEntry> files;
+    PathTree                                   tree;
+
+    for (size_t position = line.size() + 1; position < text.size();)
+    {
+        size_t end = std::min(text.find('\n', position), text.size());
+        line       = text.substr(position, end - position);
+        position   = end + 1;
+
+        if (line.empty())
+            continue;
+
+        size_t    hashEnd = line.find(' ');
+        size_t    sizeEnd = hashEnd == std::string_view::npos ? hashEnd : line.find(' ', hashEnd + 1);
+        FileEntry entry;
+
+        if (sizeEnd == std::string_view::npos || !parseNumber(line.substr(0, hashEnd), &entry.hash, 16) ||
+            !parseNumber(line.substr(hashEnd + 1, sizeEnd - hashEnd - 1), &entry.size, 10))
+        {
+            LOG_ERROR("Load Content Index: {} Failed! Malformed entry '{}'",
+                      objectFS_->getFullPath(kIndexFileName).string(),
+                      std::string(line));
+            return false;
+        }
+
+        const std::string name = std::string(line.substr(sizeEnd + 1));
+        std::string       path = PathTree::normalize(name);
+
+        if (!tree.addFile(path, name))
+        {
+            LOG_ERROR("Load Content Index: {} Failed! Conflicting entry '{}'",
+                      objectFS_->getFullPath(kIndexFileName).string(),
+                      name);
+            return false;
+        }
+
+        files.insert_or_assign(std::move(path), entry);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(objectMutex_);
+
+        for (const auto& [path, entry] : files)
+        {
+            objects_[entry.hash] = entry.size;
+        }
+    }
+
+    // the previous names are freed once unlocked
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    files_.swap(files);
+    std::swap(tree_, tree);
+
+    return true;
+}
+
+bool ContentStore::saveIndex()
+{
+    std::vector<std::pair<std::string, FileEntry>> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        entries.assign(files_.begin(), files_.end());
+    }
+
+    // sorted, so that saving the same names always gives the same file
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::string text(kIndexHeader);
+    text += '\n';
+
+    for (const auto& [path, entry] : entries)
+    {
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "%016" PRIx64 " %" PRIu64 " ", entry.hash, entry.size);
+
+        text += prefix;
+        text += path;
+        text += '\n';
+    }
+
+    return objectFS_->writeFile(kIndexFileName, text.data(), text.size());
+}
+
+ContentStore::Statistics ContentStore::getStatistics() const
+{
+    Statistics statistics;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        statistics.files = files_.size();
+    }
+
+    std::lock_guard<std::mutex> lock(objectMutex_);
+    statistics.objects      = objects_.size();
+    statistics.dedupedFiles = dedupedFiles_;
+    statistics.dedupedBytes = dedupedBytes_;
+
+    return statistics;
+}
+
+int ContentStore::enumerateFiles(const std::filesystem::path&    path,
+                                 const std::vector<std::string>& extensions,
+                                 enumerate_callback_t            callback,
+                                 bool                            allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    const FilePattern pattern = FilePattern::fromExtensions(extensions);
+    const std::string key     = PathTree::normalize(path);
+
+    // collected first so that the callback may write to this file system
+    std::vector<std::string> matches;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!tree_.listFiles(key, pattern, &matches))
+            return static_cast<int>(Status::PathNotFound);
+    }
+
+    for (const auto& fileName : matches)
+    {
+        callback(fileName);
+    }
+
+    return static_cast<int>(matches.size());
+}
+
+int ContentStore::enumerateDirectories(const std::filesystem::path& path,
+                                       enumerate_callback_t         callback,
+                                       bool                         allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    const std::string key = PathTree::normalize(path);
+
+    std::vector<std::string> subdirectories;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!tree_.listDirectories(key, &subdirectories))
+            return static_cast<int>(Status::PathNotFound);
+    }
+
+    for (const auto& directory : subdirectories)
+    {
+        callback(directory);
+    }
+
+    return static_cast<int>(subdirectories.size());
+}
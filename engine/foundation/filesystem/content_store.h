@@ -0,0 +1,101 @@
+#pragma once
+
+#include "foundation/filesystem/path_tree.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// A content-addressed file system: file names map to the muggle::hash::xxh3 of their contents, and each distinct
+// content is stored once, as an object named after its hash in the underlying file system.
+// Writing a file whose contents are already stored costs a hash and a comparison with the stored object, read
+// back unless it is in use, and no write; files with identical contents that are read at the same time share a
+// single blob in memory. Different contents with the same hash cannot both be stored, the second write fails.
+// The names are kept in an index that is persisted with saveIndex and restored with loadIndex.
+// Objects are never deleted, not even when no name refers to them any more. All methods are thread safe.
+class ContentStore : public IFileSystem {
+public:
+    static constexpr const char* kIndexFileName = "index";
+
+    struct Statistics
+    {
+        uint64_t files        = 0;
+        uint64_t objects      = 0; // known to be stored
+        uint64_t dedupedFiles = 0; // writes that found their contents already stored
+        uint64_t dedupedBytes = 0;
+    };
+
+    // Objects, and the index, are stored in the root of 'objectFS', which does not need to support directories
+    explicit ContentStore(std::shared_ptr<IFileSystem> objectFS);
+
+    std::filesystem::path getFullPath(const std::filesystem::path& name) const override;
+
+    bool                   isFolderExists(const std::filesystem::path& name) override;
+    bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    // Answered from the index, without any I/O
+    bool                   getContentHash(const std::filesystem::path& name, uint64_t* outHash) override;
+    std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    int                    enumerateFiles(const std::filesystem::path&    path,
+                                          const std::vector<std::string>& extensions,
+                                          enumerate_callback_t            callback,
+                                          bool                            allowDuplicates /* = false */) override;
+    int                    enumerateDirectories(const std::filesystem::path& path,
+                                                enumerate_callback_t         callback,
+                                                bool                         allowDuplicates /* = false */) override;
+
+    // Store 'blob' as the contents of 'name' without copying it in memory.
+    // Returns false if 'blob' is null, if 'name' is a folder or is inside a file, or if the object cannot be written.
+    bool addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> blob);
+
+    // Returns false if there was no such file. The object and the directories are kept.
+    bool removeFile(const std::filesystem::path& name);
+
+    // Replace the names with the ones saved in the index file.
+    // Returns false if there is no index or it is malformed, in which case the names are left unchanged.
+    bool loadIndex();
+    bool saveIndex();
+
+    // Path of the object holding the contents with 'hash', relative to the object file system
+    static std::filesystem::path getObjectPath(uint64_t hash);
+
+    [[nodiscard]] Statistics getStatistics() const;
+
+private:
+    struct FileEntry
+    {
+        uint64_t hash = 0;
+        uint64_t size = 0;
+    };
+
+    bool                   storeObject(const std::filesystem::path& name, uint64_t hash, const void* data, size_t size);
+    bool                   matchesObject(uint64_t hash, const void* data, size_t size);
+    std::shared_ptr<IBlob> internBlob(uint64_t hash, std::shared_ptr<IBlob> blob);
+    bool                   addEntry(const std::filesystem::path& name, const FileEntry& entry);
+
+    std::shared_ptr<IFileSystem> objectFS_;
+
+    mutable std::shared_mutex                  mutex_;
+    PathTree                                   tree_;
+    std::unordered_map<std::string, FileEntry> files_;
+
+    // sizes of the objects known to be stored, and the blobs of the objects currently in use,
+    // shared by all their readers
+    mutable std::mutex                                 objectMutex_;
+    std::unordered_map<uint64_t, uint64_t>             objects_;
+    std::unordered_map<uint64_t, std::weak_ptr<IBlob>> residentBlobs_;
+    uint64_t                                           dedupedFiles_      = 0;
+    uint64_t                                           dedupedBytes_      = 0;
+    size_t                                             residentSweepSize_ = 1024; // expired blobs are swept past this
+};
+
+} // namespace vfs
+} // namespace muggle
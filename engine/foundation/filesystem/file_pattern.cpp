@@ -0,0 +1,164 @@
+#include "foundation/filesystem/file_pattern.h"
+
+#include <cctype>
+#include <cstring>
+
+using namespace muggle::vfs;
+
+static char toLower(char c)
+{
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+FilePattern::FilePattern(std::string_view pattern, bool caseSensitive) : caseSensitive_(caseSensitive)
+{
+    addAlternative(std::string(pattern));
+}
+
+FilePattern::FilePattern(std::string_view pattern, const std::vector<std::string>& extensions, bool caseSensitive) :
+    caseSensitive_(caseSensitive)
+{
+    if (extensions.empty())
+    {
+        addAlternative(std::string(pattern));
+        return;
+    }
+
+    alternatives_.reserve(extensions.size());
+    for (const auto& ext : extensions)
+    {
+        addAlternative(std::string(pattern) + ext);
+    }
+}
+
+FilePattern FilePattern::fromExtensions(const std::vector<std::string>& extensions, bool caseSensitive)
+{
+    if (extensions.empty())
+        return FilePattern();
+
+    return FilePattern("*", extensions, caseSensitive);
+}
+
+void FilePattern::addAlternative(std::string pattern)
+{
+    const size_t wildcard = pattern.find_first_of("*?");
+
+    if (pattern == "*")
+    {
+        // matching everything makes the other alternatives irrelevant, except for the '/' rule
+        alternatives_.push_back({Kind::Any, {}});
+    }
+    else if (wildcard == std::string::npos)
+    {
+        alternatives_.push_back({Kind::Literal, std::move(pattern)});
+    }
+    else if (wildcard == 0 && pattern[0] == '*' && pattern.find_first_of("*?", 1) == std::string::npos)
+    {
+        alternatives_.push_back({Kind::Suffix, pattern.substr(1)});
+    }
+    else
+    {
+        alternatives_.push_back({Kind::Glob, std::move(pattern)});
+    }
+}
+
+bool FilePattern::equals(char a, char b) const
+{
+    return caseSensitive_ ? a == b : toLower(a) == toLower(b);
+}
+
+bool FilePattern::equals(std::string_view a, std::string_view b) const
+{
+    if (a.size() != b.size())
+        return false;
+
+    if (caseSensitive_)
+        return memcmp(a.data(), b.data(), a.size()) == 0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (toLower(a[i]) != toLower(b[i]))
+            return false;
+    }
+    return true;
+}
+
+// Iterative matching that only backtracks to the most recent '*': since a '*' cannot cross a '/',
+// an earlier '*' never needs to absorb more, which keeps this linear in practice
+bool FilePattern::matchesGlob(std::string_view pattern, std::string_view name) const
+{
+    size_t p = 0;
+    size_t n = 0;
+
+    size_t starPattern = std::string_view::npos;
+    size_t starName    = 0;
+
+    while (n < name.size())
+    {
+        if (p < pattern.size() && pattern[p] == '*')
+        {
+            starPattern = p++;
+            starName    = n;
+        }
+        else if (p < pattern.size() && name[n] != '/' && (pattern[p] == '?' || equals(pattern[p], name[n])))
+        {
+            ++p;
+            ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '/' && name[n] == '/')
+        {
+            ++p;
+            ++n;
+        }
+        else if (starPattern != std::string_view::npos && name[starName] != '/')
+        {
+            // let the last '*' absorb one more character
+            p = starPattern + 1;
+            n = ++starName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+        ++p;
+    }
+
+    return p == pattern.size();
+}
+
+bool FilePattern::matches(std::string_view name) const
+{
+    if (alternatives_.empty())
+        return true;
+
+    for (const auto& alternative : alternatives_)
+    {
+        switch (alternative.kind)
+        {
+            case Kind::Any:
+                if (name.find('/') == std::string_view::npos)
+                    return true;
+                break;
+            case Kind::Literal:
+                if (equals(name, alternative.text))
+                    return true;
+                break;
+            case Kind::Suffix:
+                if (name.size() >= alternative.text.size() &&
+                    equals(name.substr(name.size() - alternative.text.size()), alternative.text) &&
+                    name.find('/') >= name.size() - alternative.text.size())
+                    return true;
+                break;
+            case Kind::Glob:
+                if (matchesGlob(alternative.text, name))
+                    return true;
+                break;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// A glob pattern compiled once and matched without allocating.
+// '*' matches any run of characters and '?' any single character, neither of them matching '/'.
+// A pattern may have several alternatives, typically one per extension, and matches if any of them does.
+// Alternatives of the usual "*.ext" form are matched as a plain suffix comparison.
+class FilePattern {
+public:
+    // Matches everything
+    FilePattern() = default;
+
+    explicit FilePattern(std::string_view pattern, bool caseSensitive = true);
+
+    // 'pattern' followed by any of 'extensions', or just 'pattern' if there are no extensions
+    FilePattern(std::string_view pattern, const std::vector<std::string>& extensions, bool caseSensitive = true);
+
+    // File names ending with any of 'extensions', or all names if there are no extensions
+    static FilePattern fromExtensions(const std::vector<std::string>& extensions, bool caseSensitive = true);
+
+    [[nodiscard]] bool matches(std::string_view name) const;
+
+    [[nodiscard]] bool matchesEverything() const
+    {
+        return alternatives_.empty();
+    }
+
+private:
+    enum class Kind : uint8_t
+    {
+        Any,     // "*"
+        Literal, // no wildcards
+        Suffix,  // '*' followed by a literal
+        Glob
+    };
+
+    struct Alternative
+    {
+        Kind        kind;
+        std::string text; // the literal part for Literal and Suffix
+    };
+
+    void addAlternative(std::string pattern);
+    bool matchesGlob(std::string_view pattern, std::string_view name) const;
+    bool equals(char a, char b) const;
+    bool equals(std::string_view a, std::string_view b) const;
+
+    std::vector<Alternative> alternatives_;
+    bool                     caseSensitive_ = true;
+};
+
+} // namespace vfs
+} // namespace muggle
@@ -0,0 +1,432 @@
+#include "foundation/filesystem/file_watcher.h"
+#include "foundation/log/log_system.h"
+
+#if defined(__linux__)
+#define MUGGLE_HAS_INOTIFY 1
+extern "C"
+{
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+}
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <algorithm>
+
+using namespace muggle::vfs;
+
+void FileWatcher::setCoalescingDelay(std::chrono::milliseconds delay)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    coalescingDelay_ = delay;
+}
+
+void FileWatcher::recordChangeLocked(Watch& watch, const std::filesystem::path& path, FileChange::Type type)
+{
+    auto [it, inserted] = watch.pending.try_emplace(path, type);
+    if (!inserted)
+    {
+        // merge with what happened to the file earlier in the burst
+        const FileChange::Type previous = it->second;
+
+        if (previous == FileChange::Type::Added && type == FileChange::Type::Removed)
+        {
+            watch.pending.erase(it);
+        }
+        else if (previous == FileChange::Type::Removed && type == FileChange::Type::Added)
+        {
+            it->second = FileChange::Type::Modified;
+        }
+        else if (previous != FileChange::Type::Added)
+        {
+            it->second = type;
+        }
+    }
+
+    scheduleFlushLocked();
+}
+
+void FileWatcher::scheduleFlushLocked()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (!hasPending_)
+    {
+        latestFlushDeadline_ = now + coalescingDelay_ * 10;
+        hasPending_          = true;
+    }
+    flushDeadline_ = std::min(now + coalescingDelay_, latestFlushDeadline_);
+}
+
+void FileWatcher::flushPending()
+{
+    std::vector<std::pair<std::shared_ptr<watch_callback_t>, std::vector<FileChange>>> notifications;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (auto& [id, watch] : watches_)
+        {
+            if (watch.pending.empty() && !watch.overflowed)
+                continue;
+
+            std::vector<FileChange> changes;
+            changes.reserve(watch.pending.size() + 1);
+            if (watch.overflowed)
+            {
+                changes.push_back({watch.fileName.empty() ? watch.root : watch.root / watch.fileName,
+                                   FileChange::Type::Overflow});
+                watch.overflowed = false;
+            }
+            for (auto& [path, type] : watch.pending)
+            {
+                changes.push_back({path, type});
+            }
+            watch.pending.clear();
+
+            notifications.emplace_back(watch.callback, std::move(changes));
+        }
+
+        hasPending_ = false;
+    }
+
+    // callbacks run unlocked so that they can add or remove watches
+    for (auto& [callback, changes] : notifications)
+    {
+        (*callback)(changes);
+    }
+}
+
+#ifdef MUGGLE_HAS_INOTIFY
+
+static constexpr uint32_t kWatchMask =
+    IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_EXCL_UNLINK;
+
+FileWatcher::~FileWatcher()
+{
+    if (thread_.joinable())
+    {
+        stopping_.store(true);
+
+        uint64_t value = 1;
+        (void)!write(wakeFd_, &value, sizeof(value));
+
+        thread_.join();
+    }
+
+    if (wakeFd_ >= 0)
+        close(wakeFd_);
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+}
+
+bool FileWatcher::init()
+{
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+        return false;
+
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd_ < 0)
+        return false;
+
+    thread_ = std::thread([this]() { threadLoop(); });
+    return true;
+}
+
+bool FileWatcher::watchDirectoryLocked(watch_id_t id, Watch& watch, const std::filesystem::path& directory)
+{
+    int wd = inotify_add_watch(inotifyFd_, directory.c_str(), kWatchMask);
+    if (wd < 0)
+    {
+        LOG_ERROR("Watch Folder: {} Failed! {}", directory.string(), strerror(errno));
+        return false;
+    }
+
+    // watching the same directory twice yields the same descriptor
+    WatchedDirectory& watched = directories_[wd];
+    watched.path              = directory;
+
+    if (std::find(watched.watches.begin(), watched.watches.end(), id) == watched.watches.end())
+    {
+        watched.watches.push_back(id);
+        watch.descriptors.push_back(wd);
+    }
+
+    return true;
+}
+
+watch_id_t FileWatcher::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    // a file that does not exist yet can be watched as long as its directory does
+    std::error_code ec;
+    const auto      status = std::filesystem::status(path, ec);
+    if (!std::filesystem::exists(status) && !std::filesystem::is_directory(path.parent_path(), ec))
+        return kInvalidWatchId;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const watch_id_t id    = nextWatchId_++;
+    Watch&           watch = watches_[id];
+    watch.callback         = std::make_shared<watch_callback_t>(std::move(callback));
+
+    bool watching = false;
+    if (std::filesystem::is_directory(status))
+    {
+        watch.root      = path;
+        watch.recursive = recursive;
+        watching        = watchDirectoryLocked(id, watch, path);
+
+        if (watching && recursive)
+        {
+            auto options = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator it(path, options, ec), end; !ec && it != end;
+                 it.increment(ec))
+            {
+                if (it->is_directory(ec))
+                {
+                    watchDirectoryLocked(id, watch, it->path());
+                }
+            }
+        }
+    }
+    else
+    {
+        // watch the parent so that files replaced by a rename, as editors do when saving, keep being watched
+        watch.root     = path.parent_path();
+        watch.fileName = path.filename().string();
+        watching       = watchDirectoryLocked(id, watch, watch.root);
+    }
+
+    if (!watching)
+    {
+        watches_.erase(id);
+        return kInvalidWatchId;
+    }
+
+    return id;
+}
+
+bool FileWatcher::removeWatch(watch_id_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = watches_.find(id);
+    if (it == watches_.end())
+        return false;
+
+    for (int wd : it->second.descriptors)
+    {
+        auto directory = directories_.find(wd);
+        if (directory == directories_.end())
+            continue;
+
+        auto& ids = directory->second.watches;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+
+        if (ids.empty())
+        {
+            inotify_rm_watch(inotifyFd_, wd);
+            directories_.erase(directory);
+        }
+    }
+
+    watches_.erase(it);
+    return true;
+}
+
+void FileWatcher::processEventsLocked()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    for (;;)
+    {
+        ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+        if (length <= 0)
+            return;
+
+        for (char* cursor = buffer; cursor < buffer + length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(cursor);
+            cursor += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // there is no telling which files the lost events were about
+                LOG_WARN("File watcher event queue overflowed, some changes were lost");
+                for (auto& [id, watch] : watches_)
+                {
+                    watch.overflowed = true;
+                }
+                if (!watches_.empty())
+                {
+                    scheduleFlushLocked();
+                }
+                continue;
+            }
+
+            auto directory = directories_.find(event->wd);
+            if (directory == directories_.end())
+                continue;
+
+            if (event->mask & IN_IGNORED)
+            {
+                // the directory is gone, or its watch was removed
+                for (watch_id_t id : directory->second.watches)
+                {
+                    auto& descriptors = watches_[id].descriptors;
+                    descriptors.erase(std::remove(descriptors.begin(), descriptors.end(), event->wd),
+                                      descriptors.end());
+                }
+                directories_.erase(directory);
+                continue;
+            }
+
+            const std::string           name = event->len > 0 ? std::string(event->name) : std::string();
+            const std::filesystem::path path = directory->second.path / name;
+            const bool                  isDirectory = (event->mask & IN_ISDIR) != 0;
+
+            FileChange::Type type = FileChange::Type::Modified;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                type = FileChange::Type::Added;
+            }
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                type = FileChange::Type::Removed;
+            }
+
+            // copied since watching a new directory may add to it
+            const std::vector<watch_id_t> ids = directory->second.watches;
+            for (watch_id_t id : ids)
+            {
+                Watch& watch = watches_[id];
+
+                if (!watch.fileName.empty() && watch.fileName != name)
+                    continue;
+
+                // the files in a directory removed or renamed away are not all reported, the directory is
+                if (!isDirectory || type == FileChange::Type::Removed)
+                {
+                    recordChangeLocked(watch, path, type);
+                    continue;
+                }
+
+                if (!watch.recursive || type != FileChange::Type::Added)
+                    continue;
+
+                // files may have been created in the new directory before its watch was in place
+                watchDirectoryLocked(id, watch, path);
+
+                std::error_code ec;
+                auto            options = std::filesystem::directory_options::skip_permission_denied;
+                for (std::filesystem::recursive_directory_iterator it(path, options, ec), end; !ec && it != end;
+                     it.increment(ec))
+                {
+                    if (it->is_directory(ec))
+                    {
+                        watchDirectoryLocked(id, watch, it->path());
+                    }
+                    else
+                    {
+                        recordChangeLocked(watch, it->path(), FileChange::Type::Added);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FileWatcher::threadLoop()
+{
+    pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+
+    while (!stopping_.load())
+    {
+        int timeout = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (hasPending_)
+            {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    flushDeadline_ - std::chrono::steady_clock::now());
+                timeout = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+            }
+        }
+
+        int result = poll(fds, 2, timeout);
+        if (result < 0 && errno != EINTR)
+        {
+            LOG_ERROR("File watcher poll failed: {}", strerror(errno));
+            return;
+        }
+
+        if (stopping_.load())
+            return;
+
+        if (result > 0 && (fds[0].revents & POLLIN))
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            processEventsLocked();
+        }
+
+        if (result > 0 && (fds[1].revents & POLLIN))
+        {
+            uint64_t value;
+            (void)!read(wakeFd_, &value, sizeof(value));
+        }
+
+        bool flush = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flush = hasPending_ && std::chrono::steady_clock::now() >= flushDeadline_;
+        }
+
+        if (flush)
+        {
+            flushPending();
+        }
+    }
+}
+
+FileWatcher* FileWatcher::getInstance()
+{
+    static std::unique_ptr<FileWatcher> instance = []() {
+        std::unique_ptr<FileWatcher> watcher(new FileWatcher());
+        if (!watcher->init())
+        {
+            LOG_ERROR("Failed to initialize the file watcher: {}", strerror(errno));
+            return std::unique_ptr<FileWatcher>();
+        }
+        return watcher;
+    }();
+
+    return instance.get();
+}
+
+#else
+
+FileWatcher::~FileWatcher() = default;
+
+watch_id_t FileWatcher::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    (void)path;
+    (void)callback;
+    (void)recursive;
+    return kInvalidWatchId;
+}
+
+bool FileWatcher::removeWatch(watch_id_t id)
+{
+    (void)id;
+    return false;
+}
+
+FileWatcher* FileWatcher::getInstance()
+{
+    return nullptr;
+}
+
+#endif
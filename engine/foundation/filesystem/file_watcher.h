@@ -0,0 +1,86 @@
+#pragma once
+
+#include "foundation/filesystem/vfs.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Watches native files and directories for changes with inotify and reports them, coalesced, from its own thread.
+// Events for the same file are merged until no new event arrived for the coalescing delay, so an editor
+// saving a file in several steps produces a single notification.
+class FileWatcher {
+public:
+    static constexpr std::chrono::milliseconds kDefaultCoalescingDelay {100};
+
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&)            = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watch a file, or a directory and optionally its subdirectories. Changes are reported with native paths.
+    // A file that does not exist yet may be watched if its directory does.
+    // Returns kInvalidWatchId if 'path' cannot be watched.
+    watch_id_t addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive);
+    bool       removeWatch(watch_id_t id);
+
+    // Changes are reported once no new event arrived for 'delay', or at the latest after ten times 'delay'
+    void setCoalescingDelay(std::chrono::milliseconds delay);
+
+    // Returns nullptr where watching is not supported
+    static FileWatcher* getInstance();
+
+private:
+    struct Watch
+    {
+        std::filesystem::path             root;
+        std::string                       fileName; // set when watching a single file
+        bool                              recursive = false;
+        std::shared_ptr<watch_callback_t> callback;
+        std::vector<int>                  descriptors;
+
+        std::map<std::filesystem::path, FileChange::Type> pending;
+        bool                                              overflowed = false;
+    };
+
+    struct WatchedDirectory
+    {
+        std::filesystem::path   path;
+        std::vector<watch_id_t> watches;
+    };
+
+    FileWatcher() = default;
+
+    bool init();
+    bool watchDirectoryLocked(watch_id_t id, Watch& watch, const std::filesystem::path& directory);
+    void threadLoop();
+    void processEventsLocked();
+    void recordChangeLocked(Watch& watch, const std::filesystem::path& path, FileChange::Type type);
+    void scheduleFlushLocked();
+    void flushPending();
+
+    int                                       inotifyFd_ = -1;
+    int                                       wakeFd_    = -1;
+    std::thread                               thread_;
+    std::atomic<bool>                         stopping_ {false};
+    std::mutex                                mutex_;
+    std::unordered_map<watch_id_t, Watch>     watches_;
+    std::unordered_map<int, WatchedDirectory> directories_;
+    watch_id_t                                nextWatchId_ = 1;
+    std::chrono::milliseconds                 coalescingDelay_ {kDefaultCoalescingDelay};
+    std::chrono::steady_clock::time_point     flushDeadline_;
+    std::chrono::steady_clock::time_point     latestFlushDeadline_;
+    bool                                      hasPending_ = false;
+};
+
+} // namespace vfs
+} // namespace muggle
@@ -0,0 +1,492 @@
+#include "foundation/filesystem/io_uring_reader.h"
+#include "foundation/log/log_system.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MUGGLE_HAS_IO_URING 1
+#endif
+
+#ifdef MUGGLE_HAS_IO_URING
+extern "C"
+{
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+}
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace muggle::vfs;
+
+#ifdef MUGGLE_HAS_IO_URING
+
+// user_data of the no-op used to wake up the completion thread on shutdown
+static constexpr uint64_t kWakeUpUserData = 0;
+
+struct IoUringReader::Ring
+{
+    int fd = -1;
+
+    void*  sqMapping     = nullptr;
+    size_t sqMappingSize = 0;
+    void*  cqMapping     = nullptr;
+    size_t cqMappingSize = 0;
+
+    unsigned*     sqHead  = nullptr;
+    unsigned*     sqTail  = nullptr;
+    unsigned      sqMask  = 0;
+    unsigned*     sqArray = nullptr;
+    io_uring_sqe* sqes    = nullptr;
+    uint32_t      sqEntries = 0;
+
+    unsigned*     cqHead = nullptr;
+    unsigned*     cqTail = nullptr;
+    unsigned      cqMask = 0;
+    io_uring_cqe* cqes   = nullptr;
+
+    ~Ring()
+    {
+        if (sqes)
+            munmap(sqes, sqEntries * sizeof(io_uring_sqe));
+        if (cqMapping && cqMapping != sqMapping)
+            munmap(cqMapping, cqMappingSize);
+        if (sqMapping)
+            munmap(sqMapping, sqMappingSize);
+        if (fd >= 0)
+            close(fd);
+    }
+};
+
+struct IoUringReader::PendingRead
+{
+    int                                         fd       = -1;
+    uint64_t                                    offset   = 0;
+    size_t                                      size     = 0;
+    size_t                                      done     = 0;
+    char*                                       buffer   = nullptr;
+    iovec                                       iov      = {};
+    std::function<void(std::shared_ptr<IBlob>)> completion;
+};
+
+static int ioUringSetup(uint32_t entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+IoUringReader::~IoUringReader()
+{
+    if (!completionThread_.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+
+        stopping_.store(true);
+
+        unsigned      tail = *ring_->sqTail;
+        unsigned      index = tail & ring_->sqMask;
+        io_uring_sqe* sqe  = &ring_->sqes[index];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = IORING_OP_NOP;
+        sqe->user_data = kWakeUpUserData;
+
+        ring_->sqArray[index] = index;
+        __atomic_store_n(ring_->sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit_;
+
+        if (broken_.load() || !flushLocked())
+        {
+            // the completion thread may never wake up
+            completionThread_.detach();
+            return;
+        }
+    }
+
+    completionThread_.join();
+}
+
+bool IoUringReader::init(uint32_t entries)
+{
+    io_uring_params params {};
+
+    ring_     = std::make_unique<Ring>();
+    ring_->fd = ioUringSetup(entries, &params);
+
+    if (ring_->fd < 0)
+        return false;
+
+    ring_->sqMappingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring_->cqMappingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping)
+    {
+        ring_->sqMappingSize = std::max(ring_->sqMappingSize, ring_->cqMappingSize);
+        ring_->cqMappingSize = ring_->sqMappingSize;
+    }
+
+    void* sqMapping = mmap(nullptr,
+                           ring_->sqMappingSize,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE,
+                           ring_->fd,
+                           IORING_OFF_SQ_RING);
+    if (sqMapping == MAP_FAILED)
+        return false;
+    ring_->sqMapping = sqMapping;
+
+    if (singleMapping)
+    {
+        ring_->cqMapping = sqMapping;
+    }
+    else
+    {
+        void* cqMapping = mmap(nullptr,
+                               ring_->cqMappingSize,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE,
+                               ring_->fd,
+                               IORING_OFF_CQ_RING);
+        if (cqMapping == MAP_FAILED)
+            return false;
+        ring_->cqMapping = cqMapping;
+    }
+
+    void* sqes = mmap(nullptr,
+                      params.sq_entries * sizeof(io_uring_sqe),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      ring_->fd,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+
+    char* sq = static_cast<char*>(ring_->sqMapping);
+    char* cq = static_cast<char*>(ring_->cqMapping);
+
+    ring_->sqes      = static_cast<io_uring_sqe*>(sqes);
+    ring_->sqEntries = params.sq_entries;
+    ring_->sqHead    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring_->sqTail    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring_->sqMask    = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring_->sqArray   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring_->cqHead    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring_->cqTail    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring_->cqMask    = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring_->cqes      = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    completionThread_ = std::thread([this]() { completionLoop(); });
+
+    return true;
+}
+
+void IoUringReader::submit(std::vector<Read>& reads)
+{
+    using completion_t = std::function<void(std::shared_ptr<IBlob>)>;
+
+    // reads that complete without the ring are reported once the lock is released, their callbacks may submit
+    std::vector<std::pair<completion_t, std::shared_ptr<IBlob>>> finished;
+    std::vector<PendingRead*>                                     abandoned;
+
+    const bool onCompletionThread = std::this_thread::get_id() == completionThread_.get_id();
+
+    {
+        std::unique_lock<std::mutex> lock(submitMutex_);
+
+        for (auto& read : reads)
+        {
+            if (read.size == 0)
+            {
+                close(read.fd);
+                finished.emplace_back(std::move(read.completion), std::make_shared<Blob>(nullptr, 0));
+                continue;
+            }
+
+            char* buffer = broken_.load() ? nullptr : static_cast<char*>(malloc(read.size));
+            if (!buffer)
+            {
+                close(read.fd);
+                finished.emplace_back(std::move(read.completion), nullptr);
+                continue;
+            }
+
+            auto* pending       = new PendingRead();
+            pending->fd         = read.fd;
+            pending->offset     = read.offset;
+            pending->size       = read.size;
+            pending->buffer     = buffer;
+            pending->completion = std::move(read.completion);
+            pending_.insert(pending);
+
+            // the completion thread is what makes room in the ring, it cannot wait for it
+            if (onCompletionThread && inFlight_ >= ring_->sqEntries)
+            {
+                backlog_.push_back(pending);
+                continue;
+            }
+
+            // the completion queue is twice as large as the submission queue, so bounding the number of reads
+            // in flight by the submission queue size guarantees completions are never dropped
+            while (inFlight_ >= ring_->sqEntries && !broken_.load())
+            {
+                if (!flushLocked())
+                {
+                    abandonLocked(abandoned);
+                    break;
+                }
+                spaceAvailable_.wait(lock);
+            }
+
+            // failed along with the other reads when the ring broke
+            if (broken_.load())
+                continue;
+
+            ++inFlight_;
+            queueLocked(pending);
+        }
+
+        if (!broken_.load() && !flushLocked())
+        {
+            abandonLocked(abandoned);
+        }
+    }
+
+    for (auto& [completion, blob] : finished)
+    {
+        completion(std::move(blob));
+    }
+    fail(abandoned);
+}
+
+void IoUringReader::queueLocked(PendingRead* read)
+{
+    unsigned      tail  = *ring_->sqTail;
+    unsigned      index = tail & ring_->sqMask;
+    io_uring_sqe* sqe   = &ring_->sqes[index];
+
+    read->iov.iov_base = read->buffer + read->done;
+    read->iov.iov_len  = read->size - read->done;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READV;
+    sqe->fd        = read->fd;
+    sqe->off       = read->offset + read->done;
+    sqe->addr      = reinterpret_cast<uint64_t>(&read->iov);
+    sqe->len       = 1;
+    sqe->user_data = reinterpret_cast<uint64_t>(read);
+
+    ring_->sqArray[index] = index;
+    __atomic_store_n(ring_->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+}
+
+bool IoUringReader::flushLocked()
+{
+    while (toSubmit_ > 0)
+    {
+        int submitted = ioUringEnter(ring_->fd, toSubmit_, 0, 0);
+        if (submitted < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+
+            LOG_ERROR("io_uring submission failed: {}", strerror(errno));
+            return false;
+        }
+
+        toSubmit_ -= static_cast<uint32_t>(submitted);
+    }
+
+    return true;
+}
+
+void IoUringReader::abandonLocked(std::vector<PendingRead*>& abandoned)
+{
+    if (!broken_.exchange(true))
+    {
+        LOG_ERROR("io_uring stopped working, asynchronous reads use the I/O thread pool");
+    }
+
+    abandoned.insert(abandoned.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+    backlog_.clear();
+    inFlight_ = 0;
+
+    spaceAvailable_.notify_all();
+}
+
+void IoUringReader::fail(const std::vector<PendingRead*>& reads)
+{
+    // the kernel may still write into the buffers of the reads it was given, so they and their reads are leaked
+    for (PendingRead* read : reads)
+    {
+        close(read->fd);
+
+        auto completion = std::move(read->completion);
+        completion(nullptr);
+    }
+}
+
+void IoUringReader::completionLoop()
+{
+    for (;;)
+    {
+        std::vector<PendingRead*> abandoned;
+
+        if (ioUringEnter(ring_->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+        {
+            LOG_ERROR("io_uring wait failed: {}", strerror(errno));
+            {
+                std::lock_guard<std::mutex> lock(submitMutex_);
+                abandonLocked(abandoned);
+            }
+            fail(abandoned);
+            return;
+        }
+
+        unsigned head = *ring_->cqHead;
+        unsigned tail = __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE);
+
+        while (head != tail)
+        {
+            const io_uring_cqe& cqe      = ring_->cqes[head & ring_->cqMask];
+            const uint64_t      userData = cqe.user_data;
+            const int           result   = cqe.res;
+
+            ++head;
+            __atomic_store_n(ring_->cqHead, head, __ATOMIC_RELEASE);
+
+            if (userData == kWakeUpUserData)
+                continue;
+
+            auto* read = reinterpret_cast<PendingRead*>(userData);
+
+            if (result == -EINTR || result == -EAGAIN)
+            {
+                // queued again, submitted with the rest once the completions are handled
+                std::lock_guard<std::mutex> lock(submitMutex_);
+                if (pending_.count(read) != 0)
+                    queueLocked(read);
+            }
+            else if (result <= 0)
+            {
+                // an error, or the file got shorter since the read was queued
+                complete(read, false);
+            }
+            else
+            {
+                read->done += static_cast<size_t>(result);
+
+                if (read->done < read->size)
+                {
+                    // short read, queue the remainder
+                    std::lock_guard<std::mutex> lock(submitMutex_);
+                    if (pending_.count(read) != 0)
+                        queueLocked(read);
+                }
+                else
+                {
+                    complete(read, true);
+                }
+            }
+        }
+
+        bool stopped = false;
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+
+            while (!backlog_.empty() && inFlight_ < ring_->sqEntries)
+            {
+                ++inFlight_;
+                queueLocked(backlog_.front());
+                backlog_.pop_front();
+            }
+
+            if (!broken_.load() && !flushLocked())
+            {
+                abandonLocked(abandoned);
+            }
+
+            stopped = stopping_.load() && inFlight_ == 0 && backlog_.empty();
+        }
+
+        fail(abandoned);
+        if (stopped)
+            return;
+    }
+}
+
+void IoUringReader::complete(PendingRead* read, bool succeeded)
+{
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+
+        // already failed when the ring broke
+        if (pending_.erase(read) == 0)
+            return;
+
+        --inFlight_;
+    }
+    spaceAvailable_.notify_one();
+
+    close(read->fd);
+
+    std::shared_ptr<IBlob> blob;
+    if (succeeded)
+    {
+        blob = std::make_shared<Blob>(read->buffer, read->size);
+    }
+    else
+    {
+        free(read->buffer);
+    }
+
+    read->completion(std::move(blob));
+    delete read;
+}
+
+IoUringReader* IoUringReader::getInstance()
+{
+    static std::unique_ptr<IoUringReader> instance = []() {
+        std::unique_ptr<IoUringReader> reader(new IoUringReader());
+        if (!reader->init(256))
+        {
+            LOG_INFO("io_uring is not available, asynchronous reads use the I/O thread pool");
+            return std::unique_ptr<IoUringReader>();
+        }
+        return reader;
+    }();
+
+    return instance && !instance->broken_.load() ? instance.get() : nullptr;
+}
+
+#else
+
+struct IoUringReader::Ring
+{};
+
+struct IoUringReader::PendingRead
+{};
+
+IoUringReader::~IoUringReader() = default;
+
+void IoUringReader::submit(std::vector<Read>& reads)
+{
+    (void)reads;
+}
+
+IoUringReader* IoUringReader::getInstance()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "foundation/filesystem/vfs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Batched asynchronous reads through a Linux io_uring instance shared by the whole process.
+// A whole batch is queued with a single system call, completions are reaped on a dedicated thread.
+// Should the ring stop working, every read not completed yet fails and getInstance returns nullptr from then on.
+class IoUringReader {
+public:
+    struct Read
+    {
+        int      fd     = -1; // owned by the reader from submission on, closed once the read completes
+        uint64_t offset = 0;
+        size_t   size   = 0;
+
+        // Invoked from the completion thread, with nullptr if the read failed
+        std::function<void(std::shared_ptr<IBlob>)> completion;
+    };
+
+    ~IoUringReader();
+
+    IoUringReader(const IoUringReader&)            = delete;
+    IoUringReader& operator=(const IoUringReader&) = delete;
+
+    // Queue all reads and submit them to the kernel. Blocks only while the ring is full, and never on the
+    // completion thread: reads submitted from a completion wait for room in a backlog instead.
+    void submit(std::vector<Read>& reads);
+
+    // Returns nullptr when io_uring is not available (non-Linux, old kernel, blocked by seccomp...)
+    static IoUringReader* getInstance();
+
+private:
+    struct Ring;
+    struct PendingRead;
+
+    IoUringReader() = default;
+
+    bool init(uint32_t entries);
+    void queueLocked(PendingRead* read);
+    bool flushLocked();
+    void abandonLocked(std::vector<PendingRead*>& abandoned);
+    void completionLoop();
+    void complete(PendingRead* read, bool succeeded);
+
+    static void fail(const std::vector<PendingRead*>& reads);
+
+    std::unique_ptr<Ring>            ring_;
+    std::thread                      completionThread_;
+    std::mutex                       submitMutex_;
+    std::condition_variable          spaceAvailable_;
+    std::unordered_set<PendingRead*> pending_; // every read not completed yet
+    std::deque<PendingRead*>         backlog_; // submitted by completions while the ring was full
+    uint32_t                         inFlight_ = 0;
+    uint32_t                         toSubmit_ = 0;
+    std::atomic<bool>                stopping_ {false};
+    std::atomic<bool>                broken_ {false};
+};
+
+} // namespace vfs
+} // namespace muggle
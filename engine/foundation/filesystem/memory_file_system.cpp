@@ -0,0 +1,164 @@
+#include "foundation/filesystem/memory_file_system.h"
+#include "foundation/log/log_system.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+using namespace muggle::vfs;
+
+bool MemoryFileSystem::isFolderExists(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tree_.isDirectory(path);
+}
+
+bool MemoryFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return files_.find(path) != files_.end();
+}
+
+FileStat MemoryFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+    FileStat    result;
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = files_.find(path);
+    if (it != files_.end())
+    {
+        result.type = FileStat::Type::File;
+        result.size = it->second->size();
+    }
+    else if (tree_.isDirectory(path))
+    {
+        result.type = FileStat::Type::Directory;
+    }
+
+    return result;
+}
+
+std::shared_ptr<IBlob> MemoryFileSystem::readFile(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = files_.find(path);
+    if (it == files_.end())
+        return nullptr;
+
+    return it->second;
+}
+
+bool MemoryFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    void* copy = nullptr;
+    if (size > 0)
+    {
+        copy = malloc(size);
+        if (!copy)
+        {
+            LOG_ERROR("Write File: {} Failed! Out of memory", name.string());
+            return false;
+        }
+        memcpy(copy, data, size);
+    }
+
+    return addFile(name, std::make_shared<Blob>(copy, size));
+}
+
+bool MemoryFileSystem::addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> blob)
+{
+    if (!blob)
+    {
+        LOG_ERROR("Write File: {} Failed! No data", name.string());
+        return false;
+    }
+
+    std::string path = PathTree::normalize(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (!tree_.addFile(path, name))
+        return false;
+
+    files_.insert_or_assign(std::move(path), std::move(blob));
+    return true;
+}
+
+bool MemoryFileSystem::removeFile(const std::filesystem::path& name)
+{
+    std::string path = PathTree::normalize(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (files_.erase(path) == 0)
+        return false;
+
+    tree_.removeFile(path);
+    return true;
+}
+
+void MemoryFileSystem::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    files_.clear();
+    tree_.clear();
+}
+
+int MemoryFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                     const std::vector<std::string>& extensions,
+                                     enumerate_callback_t            callback,
+                                     bool                            allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    const FilePattern pattern = FilePattern::fromExtensions(extensions);
+    const std::string key     = PathTree::normalize(path);
+
+    // collected first so that the callback may write to this file system
+    std::vector<std::string> matches;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!tree_.listFiles(key, pattern, &matches))
+            return static_cast<int>(Status::PathNotFound);
+    }
+
+    for (const auto& fileName : matches)
+    {
+        callback(fileName);
+    }
+
+    return static_cast<int>(matches.size());
+}
+
+int MemoryFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                           enumerate_callback_t         callback,
+                                           bool                         allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    const std::string key = PathTree::normalize(path);
+
+    std::vector<std::string> subdirectories;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!tree_.listDirectories(key, &subdirectories))
+            return static_cast<int>(Status::PathNotFound);
+    }
+
+    for (const auto& directory : subdirectories)
+    {
+        callback(directory);
+    }
+
+    return static_cast<int>(subdirectories.size());
+}
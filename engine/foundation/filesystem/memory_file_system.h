@@ -0,0 +1,56 @@
+#pragma once
+
+#include "foundation/filesystem/path_tree.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// A file system that only lives in memory, for tests and for intermediate build products.
+// Files are immutable blobs: readFile returns the stored blob itself, and writing a file replaces its blob,
+// so readers holding the previous contents are not affected. Directories are created implicitly by
+// the files written into them. All methods are thread safe.
+class MemoryFileSystem : public IFileSystem {
+public:
+    std::filesystem::path getFullPath(const std::filesystem::path& name) const override
+    {
+        return name;
+    }
+
+    bool                   isFolderExists(const std::filesystem::path& name) override;
+    bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    int                    enumerateFiles(const std::filesystem::path&    path,
+                                          const std::vector<std::string>& extensions,
+                                          enumerate_callback_t            callback,
+                                          bool                            allowDuplicates /* = false */) override;
+    int                    enumerateDirectories(const std::filesystem::path& path,
+                                                enumerate_callback_t         callback,
+                                                bool                         allowDuplicates /* = false */) override;
+
+    // Store 'blob' as the contents of 'name' without copying it.
+    // Returns false if 'blob' is null, or if 'name' is a folder or is inside a file.
+    bool addFile(const std::filesystem::path& name, std::shared_ptr<IBlob> blob);
+
+    // Returns false if there was no such file. Directories are kept.
+    bool removeFile(const std::filesystem::path& name);
+
+    // Remove every file and directory
+    void clear();
+
+private:
+    std::shared_mutex                                       mutex_;
+    PathTree                                                tree_;
+    std::unordered_map<std::string, std::shared_ptr<IBlob>> files_;
+};
+
+} // namespace vfs
+} // namespace muggle
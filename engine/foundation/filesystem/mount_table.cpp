@@ -0,0 +1,349 @@
+#include "foundation/filesystem/mount_table.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <algorithm>
+#include <type_traits>
+
+using namespace muggle::vfs;
+
+struct MountTable::Layer
+{
+    std::shared_ptr<IFileSystem> fs;
+    int                          priority = 0;
+    uint64_t                     sequence = 0; // order of mounting
+};
+
+// A layer containing the path being resolved, 'depth' being the number of components of its mount point
+struct MountTable::Candidate
+{
+    const Layer* layer = nullptr;
+    size_t       depth = 0;
+    size_t       end   = 0; // offset just past the mount point in the path
+
+    bool ranksAbove(const Candidate& other) const
+    {
+        if (layer->priority != other.layer->priority)
+            return layer->priority > other.layer->priority;
+
+        if (depth != other.depth)
+            return depth > other.depth;
+
+        return layer->sequence > other.layer->sequence;
+    }
+};
+
+struct MountTable::Node
+{
+    std::string                        name;
+    std::vector<Layer>                 layers;   // file systems mounted at this node, top first
+    std::vector<std::unique_ptr<Node>> children; // sorted by name
+};
+
+namespace
+{
+
+template<typename CharT>
+bool isSeparator(CharT c)
+{
+#ifdef WIN32
+    return c == CharT('/') || c == CharT('\\');
+#else
+    return c == CharT('/');
+#endif
+}
+
+// Three-way comparison of a mount point component with a component of the path being resolved,
+// which may use a wider character type
+template<typename CharT>
+int compareComponent(std::string_view key, std::basic_string_view<CharT> component)
+{
+    const size_t length = std::min(key.size(), component.size());
+    for (size_t i = 0; i < length; ++i)
+    {
+        const auto a = static_cast<std::make_unsigned_t<CharT>>(static_cast<unsigned char>(key[i]));
+        const auto b = static_cast<std::make_unsigned_t<CharT>>(component[i]);
+        if (a != b)
+            return a < b ? -1 : 1;
+    }
+
+    if (key.size() == component.size())
+        return 0;
+
+    return key.size() < component.size() ? -1 : 1;
+}
+
+// Calls 'visitor(component, end)' for each component of 'path', 'end' being the offset just past it
+template<typename CharT, typename F>
+void forEachComponent(std::basic_string_view<CharT> path, F&& visitor)
+{
+    size_t position = 0;
+    while (position < path.size())
+    {
+        while (position < path.size() && isSeparator(path[position]))
+            ++position;
+
+        size_t end = position;
+        while (end < path.size() && !isSeparator(path[end]))
+            ++end;
+
+        if (end > position && !visitor(path.substr(position, end - position), end))
+            return;
+
+        position = end;
+    }
+}
+
+template<typename CharT>
+size_t skipSeparators(std::basic_string_view<CharT> path, size_t position)
+{
+    while (position < path.size() && isSeparator(path[position]))
+        ++position;
+
+    return position;
+}
+
+} // namespace
+
+MountTable::MountTable() : root_(std::make_unique<Node>())
+{}
+
+MountTable::~MountTable() = default;
+
+MountTable::Node* MountTable::findOrCreateNode(std::string_view mountPath)
+{
+    Node* node = root_.get();
+
+    forEachComponent(mountPath, [&node](std::string_view component, size_t) {
+        if (component == ".")
+            return true;
+
+        auto it = std::lower_bound(node->children.begin(),
+                                   node->children.end(),
+                                   component,
+                                   [](const std::unique_ptr<Node>& child, std::string_view value) {
+                                       return child->name < value;
+                                   });
+
+        if (it == node->children.end() || (*it)->name != component)
+        {
+            auto child  = std::make_unique<Node>();
+            child->name = std::string(component);
+            it          = node->children.insert(it, std::move(child));
+        }
+
+        node = it->get();
+        return true;
+    });
+
+    return node;
+}
+
+bool MountTable::add(std::string_view mountPath, std::shared_ptr<IFileSystem> fs, int priority)
+{
+    Node* node = findOrCreateNode(mountPath);
+
+    for (const Layer& layer : node->layers)
+    {
+        if (layer.fs == fs)
+            return false;
+    }
+
+    // layers of a node are sorted by priority, a new layer goes on top of those with the same priority
+    auto it = std::find_if(node->layers.begin(), node->layers.end(), [priority](const Layer& layer) {
+        return layer.priority <= priority;
+    });
+
+    node->layers.insert(it, Layer {std::move(fs), priority, nextSequence_++});
+    return true;
+}
+
+bool MountTable::remove(std::string_view mountPath)
+{
+    return remove(mountPath, nullptr);
+}
+
+bool MountTable::remove(std::string_view mountPath, const IFileSystem* fs)
+{
+    // remember the path from the root, so that branches left without any mount point can be pruned
+    std::vector<Node*> nodes {root_.get()};
+    bool               found = true;
+
+    forEachComponent(mountPath, [&nodes, &found](std::string_view component, size_t) {
+        if (component == ".")
+            return true;
+
+        Node* node = nodes.back();
+        auto  it   = std::lower_bound(node->children.begin(),
+                                   node->children.end(),
+                                   component,
+                                   [](const std::unique_ptr<Node>& child, std::string_view value) {
+                                       return child->name < value;
+                                   });
+
+        if (it == node->children.end() || (*it)->name != component)
+        {
+            found = false;
+            return false;
+        }
+
+        nodes.push_back(it->get());
+        return true;
+    });
+
+    if (!found)
+        return false;
+
+    auto&  layers = nodes.back()->layers;
+    size_t count  = layers.size();
+    layers.erase(std::remove_if(layers.begin(),
+                                layers.end(),
+                                [fs](const Layer& layer) { return !fs || layer.fs.get() == fs; }),
+                 layers.end());
+
+    if (layers.size() == count)
+        return false;
+
+    for (size_t i = nodes.size() - 1; i > 0; --i)
+    {
+        Node* node = nodes[i];
+        if (!node->layers.empty() || !node->children.empty())
+            break;
+
+        auto& siblings = nodes[i - 1]->children;
+        siblings.erase(std::find_if(siblings.begin(), siblings.end(), [node](const std::unique_ptr<Node>& child) {
+            return child.get() == node;
+        }));
+    }
+
+    return true;
+}
+
+// Calls 'visitor(node, depth, end)' for each node with mount points along 'path', from the root
+template<typename CharT, typename F>
+bool MountTable::forEachMountPoint(std::basic_string_view<CharT> path, bool* needsNormalization, F&& visitor) const
+{
+    const Node* node   = root_.get();
+    size_t      depth  = 0;
+    bool        dotDot = false;
+
+    if (!node->layers.empty())
+    {
+        visitor(node, depth, size_t(0));
+    }
+
+    forEachComponent(path, [&](std::basic_string_view<CharT> component, size_t end) {
+        if (component.size() == 1 && component[0] == CharT('.'))
+            return true;
+
+        if (component.size() == 2 && component[0] == CharT('.') && component[1] == CharT('.'))
+        {
+            dotDot = true;
+            return false;
+        }
+
+        auto it = std::lower_bound(node->children.begin(),
+                                   node->children.end(),
+                                   component,
+                                   [](const std::unique_ptr<Node>& child, std::basic_string_view<CharT> value) {
+                                       return compareComponent(child->name, value) < 0;
+                                   });
+
+        if (it == node->children.end() || compareComponent((*it)->name, component) != 0)
+            return false;
+
+        node = it->get();
+        ++depth;
+        if (!node->layers.empty())
+        {
+            visitor(node, depth, end);
+        }
+        return true;
+    });
+
+    if (needsNormalization)
+    {
+        *needsNormalization = dotDot;
+    }
+
+    return !dotDot;
+}
+
+template<typename CharT>
+bool MountTable::find(std::basic_string_view<CharT> path,
+                      Match*                        match,
+                      bool*                         needsNormalization,
+                      size_t*                       layerCount) const
+{
+    Candidate best;
+    size_t    count = 0;
+
+    bool walked = forEachMountPoint(path, needsNormalization, [&](const Node* node, size_t depth, size_t end) {
+        // the layers of a node are in order, only the first one can rank above the best so far
+        Candidate candidate {&node->layers.front(), depth, end};
+        if (!best.layer || candidate.ranksAbove(best))
+        {
+            best = candidate;
+        }
+
+        count += node->layers.size();
+    });
+
+    if (layerCount)
+    {
+        *layerCount = walked ? count : 0;
+    }
+
+    if (!walked || !best.layer)
+        return false;
+
+    if (match)
+    {
+        // the relative part starts after the separators following the mount point
+        match->fs             = best.layer->fs.get();
+        match->relativeOffset = skipSeparators(path, best.end);
+    }
+
+    return true;
+}
+
+template<typename CharT>
+bool MountTable::findAll(std::basic_string_view<CharT> path,
+                         std::vector<Match>*           matches,
+                         bool*                         needsNormalization) const
+{
+    std::vector<Candidate> candidates;
+
+    auto collect = [&candidates](const Node* node, size_t depth, size_t end) {
+        for (const Layer& layer : node->layers)
+        {
+            candidates.push_back({&layer, depth, end});
+        }
+    };
+
+    bool walked = forEachMountPoint(path, needsNormalization, collect);
+
+    if (!walked || candidates.empty())
+        return false;
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.ranksAbove(b);
+    });
+
+    matches->clear();
+    for (const Candidate& candidate : candidates)
+    {
+        matches->push_back({candidate.layer->fs.get(), skipSeparators(path, candidate.end)});
+    }
+
+    return true;
+}
+
+bool MountTable::isEmpty() const
+{
+    return root_->layers.empty() && root_->children.empty();
+}
+
+template bool MountTable::find(std::basic_string_view<char>, Match*, bool*, size_t*) const;
+template bool MountTable::find(std::basic_string_view<wchar_t>, Match*, bool*, size_t*) const;
+template bool MountTable::findAll(std::basic_string_view<char>, std::vector<Match>*, bool*) const;
+template bool MountTable::findAll(std::basic_string_view<wchar_t>, std::vector<Match>*, bool*) const;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+class IFileSystem;
+
+// Maps virtual path prefixes to mounted file systems.
+// Mount points are stored in a trie keyed on path components, so resolving a path is a single walk
+// over its components with longest-prefix semantics, and does not allocate.
+// Several file systems can be mounted at the same or nested paths; they form layers ordered by priority,
+// then by depth of the mount point, then with the most recently mounted one first.
+class MountTable {
+public:
+    struct Match
+    {
+        IFileSystem* fs             = nullptr;
+        size_t       relativeOffset = 0; // where the part of the path below the mount point starts
+    };
+
+    MountTable();
+    ~MountTable();
+
+    MountTable(const MountTable&)            = delete;
+    MountTable& operator=(const MountTable&) = delete;
+
+    // Returns false if 'fs' is already mounted at exactly 'mountPath'
+    bool add(std::string_view mountPath, std::shared_ptr<IFileSystem> fs, int priority = 0);
+
+    // Remove every file system mounted at exactly 'mountPath', or only 'fs'.
+    // Returns false if nothing was mounted there.
+    bool remove(std::string_view mountPath);
+    bool remove(std::string_view mountPath, const IFileSystem* fs);
+
+    // Find the top layer containing 'path'; 'layerCount' receives the number of layers that contain it.
+    // Components equal to "." are ignored. Paths with ".." components are not handled, since resolving
+    // them needs a normalized copy of the path: 'needsNormalization' is set and nothing is found.
+    template<typename CharT>
+    bool find(std::basic_string_view<CharT> path,
+              Match*                        match,
+              bool*                         needsNormalization = nullptr,
+              size_t*                       layerCount         = nullptr) const;
+
+    // Find every layer containing 'path', top first
+    template<typename CharT>
+    bool findAll(std::basic_string_view<CharT> path,
+                 std::vector<Match>*           matches,
+                 bool*                         needsNormalization = nullptr) const;
+
+    [[nodiscard]] bool isEmpty() const;
+
+private:
+    struct Node;
+    struct Layer;
+    struct Candidate;
+
+    Node* findOrCreateNode(std::string_view mountPath);
+
+    template<typename CharT, typename F>
+    bool forEachMountPoint(std::basic_string_view<CharT> path, bool* needsNormalization, F&& visitor) const;
+
+    std::unique_ptr<Node> root_;
+    uint64_t              nextSequence_ = 0;
+};
+
+extern template bool MountTable::find(std::basic_string_view<char>, Match*, bool*, size_t*) const;
+extern template bool MountTable::find(std::basic_string_view<wchar_t>, Match*, bool*, size_t*) const;
+extern template bool MountTable::findAll(std::basic_string_view<char>, std::vector<Match>*, bool*) const;
+extern template bool MountTable::findAll(std::basic_string_view<wchar_t>, std::vector<Match>*, bool*) const;
+
+} // namespace vfs
+} // namespace muggle
@@ -0,0 +1,457 @@
+#include "foundation/filesystem/pack_file_system.h"
+#include "foundation/filesystem/file_pattern.h"
+#include "foundation/log/log_system.h"
+#include "foundation/utility/string_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+
+using namespace muggle::vfs;
+using namespace muggle::vfs::pack;
+
+namespace
+{
+
+// Archive paths have no leading or trailing slash, the root directory is the empty string
+std::string normalizePackPath(const std::filesystem::path& name)
+{
+    std::string path = name.lexically_normal().generic_string();
+
+    muggle::string_utils::trim(path, '/');
+    if (path == ".")
+    {
+        path.clear();
+    }
+
+    return path;
+}
+
+std::string_view getParentPath(std::string_view path)
+{
+    size_t separator = path.rfind('/');
+    return separator == std::string_view::npos ? std::string_view() : path.substr(0, separator);
+}
+
+std::string_view getFileName(std::string_view path)
+{
+    size_t separator = path.rfind('/');
+    return separator == std::string_view::npos ? path : path.substr(separator + 1);
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+uint64_t muggle::vfs::pack::hashPath(std::string_view path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : path)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+PackFileSystem::PackFileSystem(std::shared_ptr<IBlob> archive) : archive_(std::move(archive))
+{
+    if (archive_ && !load())
+    {
+        entries_    = nullptr;
+        entryCount_ = 0;
+        paths_      = nullptr;
+        directories_.clear();
+    }
+}
+
+std::shared_ptr<PackFileSystem> PackFileSystem::open(const std::filesystem::path& archivePath)
+{
+    auto archive = MappedBlob::mapFile(archivePath, MappedBlob::AccessHint::Random);
+    if (!archive)
+        return nullptr;
+
+    auto fs = std::make_shared<PackFileSystem>(std::move(archive));
+    if (!fs->isLoaded())
+    {
+        LOG_ERROR("Pack File: {} is not a valid archive", archivePath.string());
+        return nullptr;
+    }
+
+    return fs;
+}
+
+bool PackFileSystem::load()
+{
+    const char*  data = static_cast<const char*>(archive_->data());
+    const size_t size = archive_->size();
+
+    if (size < sizeof(PackHeader))
+        return false;
+
+    PackHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.alignment == 0)
+        return false;
+
+    if (header.tocOffset > size || header.tocSize > size - header.tocOffset)
+        return false;
+
+    // the table of contents is used in place, so it must be suitably aligned in memory
+    const char* toc = data + header.tocOffset;
+    if (reinterpret_cast<uintptr_t>(toc) % alignof(PackEntry) != 0)
+        return false;
+
+    const uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(PackEntry);
+    if (entriesSize > header.tocSize)
+        return false;
+
+    entries_    = reinterpret_cast<const PackEntry*>(toc);
+    entryCount_ = header.entryCount;
+    paths_      = toc + entriesSize;
+
+    const uint64_t pathsSize = header.tocSize - entriesSize;
+
+    directories_.clear();
+    directories_[std::string_view()];
+
+    for (uint32_t index = 0; index < entryCount_; ++index)
+    {
+        const PackEntry& entry = entries_[index];
+
+        if (static_cast<uint64_t>(entry.pathOffset) + entry.pathLength > pathsSize)
+            return false;
+
+        if (entry.offset > header.tocOffset || entry.storedSize > header.tocOffset - entry.offset)
+            return false;
+
+        if (entry.codec == static_cast<uint8_t>(compression::Codec::None) && entry.storedSize != entry.size)
+            return false;
+
+        // register the file in its directory and every missing ancestor in its parent
+        std::string_view path      = getEntryPath(entry);
+        std::string_view directory = getParentPath(path);
+
+        directories_[directory].files.push_back(index);
+
+        while (!directory.empty())
+        {
+            std::string_view parent = getParentPath(directory);
+
+            auto& siblings = directories_[parent].subdirectories;
+            if (std::find(siblings.begin(), siblings.end(), getFileName(directory)) != siblings.end())
+                break;
+
+            siblings.push_back(getFileName(directory));
+            directory = parent;
+        }
+    }
+
+    return true;
+}
+
+std::string_view PackFileSystem::getEntryPath(const PackEntry& entry) const
+{
+    return std::string_view(paths_ + entry.pathOffset, entry.pathLength);
+}
+
+const PackEntry* PackFileSystem::findEntry(const std::filesystem::path& name) const
+{
+    if (!entries_)
+        return nullptr;
+
+    const std::string path = normalizePackPath(name);
+    const uint64_t    hash = hashPath(path);
+
+    const PackEntry* end = entries_ + entryCount_;
+    const PackEntry* it  = std::lower_bound(entries_, end, hash, [](const PackEntry& entry, uint64_t value) {
+        return entry.pathHash < value;
+    });
+
+    for (; it != end && it->pathHash == hash; ++it)
+    {
+        if (getEntryPath(*it) == path)
+            return it;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<IBlob> PackFileSystem::getStoredData(const PackEntry& entry) const
+{
+    return std::make_shared<BlobView>(
+        archive_, static_cast<size_t>(entry.offset), static_cast<size_t>(entry.storedSize));
+}
+
+bool PackFileSystem::isFolderExists(const std::filesystem::path& name)
+{
+    return isLoaded() && directories_.find(normalizePackPath(name)) != directories_.end();
+}
+
+bool PackFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    return findEntry(name) != nullptr;
+}
+
+FileStat PackFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    FileStat result;
+
+    if (const PackEntry* entry = findEntry(name))
+    {
+        result.type = FileStat::Type::File;
+        result.size = entry->size;
+    }
+    else if (isFolderExists(name))
+    {
+        result.type = FileStat::Type::Directory;
+    }
+
+    return result;
+}
+
+std::shared_ptr<IBlob> PackFileSystem::readFile(const std::filesystem::path& name)
+{
+    const PackEntry* entry = findEntry(name);
+
+    if (!entry)
+    {
+        LOG_ERROR("Open File: {} Failed! Not found in the archive", name.string());
+        return nullptr;
+    }
+
+    const auto codec = static_cast<compression::Codec>(entry->codec);
+    if (codec == compression::Codec::None)
+        return getStoredData(*entry);
+
+    if (!compression::isCodecAvailable(codec))
+    {
+        LOG_ERROR("Read File: {} Failed! Compression codec {} is not available", name.string(), entry->codec);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(entry->size);
+    void*        data = malloc(size);
+
+    assert(data != nullptr || size == 0);
+
+    const char* stored = static_cast<const char*>(archive_->data()) + entry->offset;
+    if (!compression::decompress(codec, stored, static_cast<size_t>(entry->storedSize), data, size))
+    {
+        LOG_ERROR("Read File: {} Failed! Corrupt compressed data", name.string());
+        free(data);
+        return nullptr;
+    }
+
+    return std::make_shared<Blob>(data, size);
+}
+
+std::shared_ptr<IBlob> PackFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+    const PackEntry* entry = findEntry(name);
+
+    // compressed entries have to be decompressed as a whole anyway
+    if (!entry || entry->codec != static_cast<uint8_t>(compression::Codec::None))
+        return IFileSystem::readRange(name, offset, size);
+
+    if (offset > entry->size || size > entry->size - offset)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        return nullptr;
+    }
+
+    return std::make_shared<BlobView>(archive_,
+                                      static_cast<size_t>(entry->offset + offset),
+                                      size != 0 ? size : static_cast<size_t>(entry->size - offset));
+}
+
+bool PackFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    (void)data;
+    (void)size;
+
+    LOG_ERROR("Write File: {} Failed! Pack file systems are read-only", name.string());
+    return false;
+}
+
+int PackFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                   const std::vector<std::string>& extensions,
+                                   enumerate_callback_t            callback,
+                                   bool                            allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    auto it = directories_.find(normalizePackPath(path));
+    if (it == directories_.end())
+        return static_cast<int>(Status::PathNotFound);
+
+    const FilePattern pattern = FilePattern::fromExtensions(extensions);
+
+    int numEntries = 0;
+    for (uint32_t index : it->second.files)
+    {
+        std::string_view fileName = getFileName(getEntryPath(entries_[index]));
+        if (pattern.matches(fileName))
+        {
+            callback(fileName);
+            ++numEntries;
+        }
+    }
+
+    return numEntries;
+}
+
+int PackFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                         enumerate_callback_t         callback,
+                                         bool                         allowDuplicates)
+{
+    (void)allowDuplicates;
+
+    auto it = directories_.find(normalizePackPath(path));
+    if (it == directories_.end())
+        return static_cast<int>(Status::PathNotFound);
+
+    for (std::string_view directory : it->second.subdirectories)
+    {
+        callback(directory);
+    }
+
+    return static_cast<int>(it->second.subdirectories.size());
+}
+
+void PackBuilder::addFile(const std::string& path, std::shared_ptr<IBlob> data, compression::Codec codec)
+{
+    entries_.push_back({normalizePackPath(path), std::move(data), codec});
+}
+
+bool PackBuilder::write(const std::filesystem::path& archivePath, uint32_t alignment) const
+{
+    if (alignment == 0)
+    {
+        alignment = 1;
+    }
+
+    // order the table of contents for binary search on the path hash
+    std::vector<const PendingEntry*> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& entry : entries_)
+    {
+        sorted.push_back(&entry);
+    }
+
+    std::vector<uint64_t> hashes(entries_.size());
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+        hashes[i] = hashPath(entries_[i].path);
+    }
+
+    auto hashOf = [this, &hashes](const PendingEntry* entry) { return hashes[entry - entries_.data()]; };
+
+    std::sort(sorted.begin(), sorted.end(), [&hashOf](const PendingEntry* a, const PendingEntry* b) {
+        return std::make_tuple(hashOf(a), std::string_view(a->path)) <
+               std::make_tuple(hashOf(b), std::string_view(b->path));
+    });
+
+    std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        LOG_ERROR("Open File: {} Failed!", archivePath.string());
+        return false;
+    }
+
+    std::vector<PackEntry> toc;
+    std::string            paths;
+    std::vector<uint8_t>   compressed;
+    const char             padding[64] = {};
+
+    auto pad = [&file, &padding](uint64_t from, uint64_t to) {
+        while (from < to)
+        {
+            uint64_t count = std::min<uint64_t>(to - from, sizeof(padding));
+            file.write(padding, static_cast<std::streamsize>(count));
+            from += count;
+        }
+    };
+
+    uint64_t offset = sizeof(PackHeader);
+    file.write(padding, sizeof(PackHeader));
+
+    for (const PendingEntry* pending : sorted)
+    {
+        if (!toc.empty() && toc.back().pathHash == hashOf(pending) &&
+            std::string_view(paths).substr(toc.back().pathOffset) == pending->path)
+        {
+            LOG_ERROR("Pack File: {} is added more than once", pending->path);
+            return false;
+        }
+
+        if (pending->path.size() > UINT16_MAX)
+        {
+            LOG_ERROR("Pack File: path {} is too long", pending->path);
+            return false;
+        }
+
+        const void* data  = pending->data ? pending->data->data() : nullptr;
+        size_t      size  = pending->data ? pending->data->size() : 0;
+        const void* store = data;
+        size_t      storedSize = size;
+        auto        codec      = compression::Codec::None;
+
+        if (pending->codec != compression::Codec::None && size > 0 &&
+            compression::compress(pending->codec, data, size, compressed) && compressed.size() < size)
+        {
+            store      = compressed.data();
+            storedSize = compressed.size();
+            codec      = pending->codec;
+        }
+
+        uint64_t entryOffset = alignUp(offset, alignment);
+        pad(offset, entryOffset);
+        if (storedSize > 0)
+        {
+            file.write(static_cast<const char*>(store), static_cast<std::streamsize>(storedSize));
+        }
+        offset = entryOffset + storedSize;
+
+        PackEntry entry {};
+        entry.pathHash   = hashOf(pending);
+        entry.offset     = entryOffset;
+        entry.storedSize = storedSize;
+        entry.size       = size;
+        entry.pathOffset = static_cast<uint32_t>(paths.size());
+        entry.pathLength = static_cast<uint16_t>(pending->path.size());
+        entry.codec      = static_cast<uint8_t>(codec);
+        toc.push_back(entry);
+
+        paths += pending->path;
+    }
+
+    PackHeader header {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version    = kVersion;
+    header.entryCount = static_cast<uint32_t>(toc.size());
+    header.alignment  = alignment;
+    header.tocOffset  = alignUp(offset, alignof(PackEntry));
+    header.tocSize    = toc.size() * sizeof(PackEntry) + paths.size();
+
+    pad(offset, header.tocOffset);
+    file.write(reinterpret_cast<const char*>(toc.data()), static_cast<std::streamsize>(toc.size() * sizeof(PackEntry)));
+    file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+
+    file.seekp(0, std::ios::beg);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!file.good())
+    {
+        LOG_ERROR("Write File: {} Failed!", archivePath.string());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "foundation/compression/compression.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <string_view>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Layout of a .mpak archive, all values little endian:
+//   PackHeader
+//   entry data, each entry starting at a multiple of PackHeader::alignment
+//   table of contents: PackEntry[entryCount] sorted by (pathHash, path), followed by the path strings
+// Paths are stored relative to the archive root, with '/' separators and without a leading slash.
+namespace pack
+{
+static constexpr char     kMagic[4]        = {'M', 'P', 'A', 'K'};
+static constexpr uint32_t kVersion         = 1;
+static constexpr uint32_t kDefaultAlignment = 4096;
+
+struct PackHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t alignment;
+    uint64_t tocOffset;
+    uint64_t tocSize;
+};
+
+struct PackEntry
+{
+    uint64_t pathHash;
+    uint64_t offset;     // from the start of the archive
+    uint64_t storedSize; // size in the archive
+    uint64_t size;       // size once decompressed
+    uint32_t pathOffset; // from the start of the path strings
+    uint16_t pathLength;
+    uint8_t  codec; // muggle::compression::Codec
+    uint8_t  reserved;
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader layout must not change");
+static_assert(sizeof(PackEntry) == 40, "PackEntry layout must not change");
+
+// FNV-1a, stable across platforms and builds since it is stored in archives
+uint64_t hashPath(std::string_view path);
+} // namespace pack
+
+// A read-only file system serving the entries of a .mpak archive.
+// The archive is kept in memory as a single blob, ideally a MappedBlob, and uncompressed entries
+// are returned as views into it without any copy or system call.
+class PackFileSystem : public IFileSystem {
+public:
+    explicit PackFileSystem(std::shared_ptr<IBlob> archive);
+
+    // Map the archive from the native file system.
+    // Returns nullptr if it cannot be read or is not a valid archive
+    static std::shared_ptr<PackFileSystem> open(const std::filesystem::path& archivePath);
+
+    [[nodiscard]] bool isLoaded() const
+    {
+        return entries_ != nullptr;
+    }
+
+    std::filesystem::path getFullPath(const std::filesystem::path& name) const override
+    {
+        return name;
+    }
+
+    bool isImmutable() const override
+    {
+        return true;
+    }
+
+    bool                   isFolderExists(const std::filesystem::path& name) override;
+    bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    int                    enumerateFiles(const std::filesystem::path&    path,
+                                          const std::vector<std::string>& extensions,
+                                          enumerate_callback_t            callback,
+                                          bool                            allowDuplicates /* = false */) override;
+    int                    enumerateDirectories(const std::filesystem::path& path,
+                                                enumerate_callback_t         callback,
+                                                bool                         allowDuplicates /* = false */) override;
+
+private:
+    struct Directory
+    {
+        std::vector<uint32_t>         files; // entry indices
+        std::vector<std::string_view> subdirectories;
+    };
+
+    bool                           load();
+    const pack::PackEntry*         findEntry(const std::filesystem::path& name) const;
+    [[nodiscard]] std::string_view getEntryPath(const pack::PackEntry& entry) const;
+    std::shared_ptr<IBlob>         getStoredData(const pack::PackEntry& entry) const;
+
+    std::shared_ptr<IBlob>                          archive_;
+    const pack::PackEntry*                          entries_    = nullptr;
+    uint32_t                                        entryCount_ = 0;
+    const char*                                     paths_      = nullptr;
+    std::unordered_map<std::string_view, Directory> directories_;
+};
+
+// Collects files and writes them as a .mpak archive
+class PackBuilder {
+public:
+    // Add a file at 'path' inside the archive. The entry is stored uncompressed if 'codec' does not make it smaller.
+    void addFile(const std::string& path,
+                 std::shared_ptr<IBlob> data,
+                 compression::Codec     codec = compression::Codec::None);
+
+    // Write the archive, returns false on I/O errors
+    bool write(const std::filesystem::path& archivePath, uint32_t alignment = pack::kDefaultAlignment) const;
+
+private:
+    struct PendingEntry
+    {
+        std::string            path;
+        std::shared_ptr<IBlob> data;
+        compression::Codec     codec;
+    };
+
+    std::vector<PendingEntry> entries_;
+};
+
+} // namespace vfs
+} // namespace muggle
@@ -0,0 +1,119 @@
+#include "foundation/filesystem/path_tree.h"
+#include "foundation/log/log_system.h"
+#include "foundation/utility/string_utils.h"
+
+using namespace muggle::vfs;
+
+static std::pair<std::string, std::string> splitPath(const std::string& path)
+{
+    size_t separator = path.rfind('/');
+    if (separator == std::string::npos)
+        return {std::string(), path};
+
+    return {path.substr(0, separator), path.substr(separator + 1)};
+}
+
+std::string PathTree::normalize(const std::filesystem::path& name)
+{
+    std::string path = name.lexically_normal().generic_string();
+
+    muggle::string_utils::trim(path, '/');
+    if (path == ".")
+    {
+        path.clear();
+    }
+
+    return path;
+}
+
+bool PathTree::addFile(const std::string& path, const std::filesystem::path& name)
+{
+    if (path.empty() || isDirectory(path))
+    {
+        LOG_ERROR("Write File: {} Failed! The path is a folder", name.string());
+        return false;
+    }
+
+    // files cannot hold other files
+    for (size_t separator = path.find('/'); separator != std::string::npos; separator = path.find('/', separator + 1))
+    {
+        if (isFile(path.substr(0, separator)))
+        {
+            LOG_ERROR("Write File: {} Failed! {} is a file", name.string(), path.substr(0, separator));
+            return false;
+        }
+    }
+
+    auto [parent, fileName] = splitPath(path);
+    addDirectories(parent);
+    directories_[parent].files.insert(fileName);
+    return true;
+}
+
+void PathTree::addDirectories(const std::string& path)
+{
+    if (directories_.find(path) != directories_.end())
+        return;
+
+    auto [parent, name] = splitPath(path);
+    addDirectories(parent);
+
+    directories_[parent].subdirectories.insert(name);
+    directories_.emplace(path, Directory());
+}
+
+bool PathTree::removeFile(const std::string& path)
+{
+    auto [parent, fileName] = splitPath(path);
+
+    auto it = directories_.find(parent);
+    return it != directories_.end() && it->second.files.erase(fileName) > 0;
+}
+
+bool PathTree::isFile(const std::string& path) const
+{
+    auto [parent, fileName] = splitPath(path);
+
+    auto it = directories_.find(parent);
+    return it != directories_.end() && it->second.files.count(fileName) > 0;
+}
+
+bool PathTree::isDirectory(const std::string& path) const
+{
+    return directories_.find(path) != directories_.end();
+}
+
+bool PathTree::listFiles(const std::string&        directory,
+                         const FilePattern&        pattern,
+                         std::vector<std::string>* outNames) const
+{
+    auto it = directories_.find(directory);
+    if (it == directories_.end())
+        return false;
+
+    for (const auto& fileName : it->second.files)
+    {
+        if (pattern.matches(fileName))
+        {
+            outNames->push_back(fileName);
+        }
+    }
+
+    return true;
+}
+
+bool PathTree::listDirectories(const std::string& directory, std::vector<std::string>* outNames) const
+{
+    auto it = directories_.find(directory);
+    if (it == directories_.end())
+        return false;
+
+    outNames->insert(outNames->end(), it->second.subdirectories.begin(), it->second.subdirectories.end());
+    return true;
+}
+
+void PathTree::clear()
+{
+    directories_.clear();
+    directories_.emplace(std::string(), Directory());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "foundation/filesystem/file_pattern.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// The directory structure of a file system that keeps its names in memory, such as MemoryFileSystem and
+// ContentStore, which keep what the files hold next to it. Paths are normalized with normalize: they have no
+// leading or trailing slash, and the root directory is the empty string. Directories are created implicitly by the
+// files added into them, and are kept when the files are removed. Not thread safe.
+class PathTree {
+public:
+    static std::string normalize(const std::filesystem::path& name);
+
+    // Add the file 'path', or keep it if it exists. Returns false, and logs why as a failed write of 'name', if
+    // 'path' is a directory or is inside a file.
+    bool addFile(const std::string& path, const std::filesystem::path& name);
+
+    // Returns false if there was no such file
+    bool removeFile(const std::string& path);
+
+    [[nodiscard]] bool isFile(const std::string& path) const;
+    [[nodiscard]] bool isDirectory(const std::string& path) const;
+
+    // The names of the files in 'directory' matching 'pattern'. Returns false if there is no such directory.
+    bool listFiles(const std::string& directory, const FilePattern& pattern, std::vector<std::string>* outNames) const;
+    bool listDirectories(const std::string& directory, std::vector<std::string>* outNames) const;
+
+    // Remove every file and directory
+    void clear();
+
+private:
+    struct Directory
+    {
+        std::unordered_set<std::string> files;
+        std::unordered_set<std::string> subdirectories;
+    };
+
+    void addDirectories(const std::string& path);
+
+    std::unordered_map<std::string, Directory> directories_ {{std::string(), Directory()}};
+};
+
+} // namespace vfs
+} // namespace muggle
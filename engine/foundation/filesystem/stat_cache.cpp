@@ -0,0 +1,122 @@
+#include "foundation/filesystem/stat_cache.h"
+
+#include <mutex>
+
+using namespace muggle::vfs;
+
+StatCache::StatCache(size_t capacity) : capacity_(capacity)
+{}
+
+std::filesystem::path::string_type StatCache::getKey(const std::filesystem::path& name)
+{
+    std::filesystem::path path = name.lexically_normal();
+    if (!path.has_filename() && path.has_relative_path())
+    {
+        path = path.parent_path();
+    }
+
+    return path.native();
+}
+
+bool StatCache::find(const std::filesystem::path& name, FileStat* outStat) const
+{
+    const auto key = getKey(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+        return false;
+
+    *outStat = it->second;
+    return true;
+}
+
+void StatCache::insert(const std::filesystem::path& name, const FileStat& stat, uint64_t generation)
+{
+    auto key = getKey(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (generation_.load(std::memory_order_relaxed) != generation)
+        return;
+
+    if (entries_.size() >= capacity_)
+    {
+        entries_.clear();
+    }
+
+    entries_[std::move(key)] = stat;
+}
+
+void StatCache::invalidate(const std::filesystem::path& name)
+{
+    const auto key = getKey(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    invalidateLocked(key);
+}
+
+void StatCache::invalidateTree(const std::filesystem::path& name)
+{
+    const auto key = getKey(name);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // nothing can be under a file
+    auto       it     = entries_.find(key);
+    const bool isFile = it != entries_.end() && it->second.isFile();
+
+    invalidateLocked(key);
+    if (isFile)
+        return;
+
+    auto prefix = key;
+    if (prefix.empty() || prefix.back() != std::filesystem::path::preferred_separator)
+    {
+        prefix += std::filesystem::path::preferred_separator;
+    }
+
+    for (auto entry = entries_.begin(); entry != entries_.end();)
+    {
+        if (entry->first.compare(0, prefix.size(), prefix) == 0)
+        {
+            entry = entries_.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+void StatCache::invalidateLocked(const std::filesystem::path::string_type& key)
+{
+    // even when nothing is cached, a stat being taken may have to be kept out
+    generation_.fetch_add(1, std::memory_order_release);
+
+    if (entries_.empty())
+        return;
+
+    for (std::filesystem::path path = key; !path.empty(); path = path.parent_path())
+    {
+        entries_.erase(path.native());
+
+        if (path == path.parent_path())
+            break;
+    }
+}
+
+void StatCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    generation_.fetch_add(1, std::memory_order_release);
+    entries_.clear();
+}
+
+size_t StatCache::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
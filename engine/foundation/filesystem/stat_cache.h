@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Type, size and last modification time of a path
+struct FileStat
+{
+    enum class Type : uint8_t
+    {
+        None, // the path does not exist
+        File,
+        Directory
+    };
+
+    Type     type         = Type::None;
+    uint64_t size         = 0; // of files only
+    int64_t  modifiedTime = 0; // nanoseconds since the Unix epoch, 0 if unknown
+
+    [[nodiscard]] bool exists() const
+    {
+        return type != Type::None;
+    }
+
+    [[nodiscard]] bool isFile() const
+    {
+        return type == Type::File;
+    }
+
+    [[nodiscard]] bool isDirectory() const
+    {
+        return type == Type::Directory;
+    }
+};
+
+// Remembers the FileStat of paths, including the paths that do not exist, by normalized path.
+// Thread safe. Entries stay until they are invalidated, or until the cache is full and is emptied at once.
+class StatCache {
+public:
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    explicit StatCache(size_t capacity = kDefaultCapacity);
+
+    bool find(const std::filesystem::path& name, FileStat* outStat) const;
+
+    // 'generation' is getGeneration from before the stat was taken: if the cache was invalidated since, the stat
+    // may predate the change and is not inserted
+    void insert(const std::filesystem::path& name, const FileStat& stat, uint64_t generation);
+
+    [[nodiscard]] uint64_t getGeneration() const
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    // Drop 'name', and its parent directories which may have been created along with it
+    void invalidate(const std::filesystem::path& name);
+
+    // Also drop everything under 'name', for directories that were removed or renamed
+    void invalidateTree(const std::filesystem::path& name);
+
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+
+    // The normal form of 'name' without a trailing separator, so that every spelling of a path has the same key
+    static std::filesystem::path::string_type getKey(const std::filesystem::path& name);
+
+private:
+    void invalidateLocked(const std::filesystem::path::string_type& key);
+
+    mutable std::shared_mutex                                        mutex_;
+    std::unordered_map<std::filesystem::path::string_type, FileStat> entries_;
+    size_t                                                           capacity_;
+    std::atomic<uint64_t>                                            generation_ {0};
+};
+
+} // namespace vfs
+} // namespace muggle
@@ -1,11 +1,23 @@
 #include "foundation/filesystem/vfs.h"
+#include "foundation/filesystem/file_pattern.h"
+#include "foundation/filesystem/file_watcher.h"
+#include "foundation/filesystem/io_uring_reader.h"
+#include "foundation/filesystem/write_queue.h"
+#include "foundation/hash/hash.h"
 #include "foundation/log/log_system.h"
-#include "foundation/utility/string_utils.h"
+#include "foundation/thread/thread_pool.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <limits>
-#include <sstream>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #ifdef WIN32
@@ -18,8 +30,13 @@
 #else
 extern "C"
 {
-#include <glob.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 }
+#include <climits>
 #endif
 
 using namespace muggle::vfs;
@@ -43,326 +60,2158 @@ size_t Blob::size() const
     return size_;
 }
 
+BlobView::BlobView(std::shared_ptr<IBlob> parent, size_t offset, size_t size) :
+    parent_(std::move(parent)), offset_(offset), size_(size)
+{
+    assert(offset <= parent_->size() && size <= parent_->size() - offset);
+}
+
+const void* BlobView::data() const
+{
+    return static_cast<const char*>(parent_->data()) + offset_;
+}
+
+size_t BlobView::size() const
+{
+    return size_;
+}
+
+std::shared_ptr<BlobView> BlobView::slice(const std::shared_ptr<IBlob>& blob, size_t offset, size_t size)
+{
+    if (!blob || offset > blob->size() || size > blob->size() - offset)
+        return nullptr;
+
+    if (size == 0)
+    {
+        size = blob->size() - offset;
+    }
+
+    if (auto view = std::dynamic_pointer_cast<BlobView>(blob))
+    {
+        return std::make_shared<BlobView>(view->parent_, view->offset_ + offset, size);
+    }
+
+    return std::make_shared<BlobView>(blob, offset, size);
+}
+
+void* AlignedBlobAllocator::allocate(size_t size, size_t alignment)
+{
+    alignment = std::max(alignment, alignof(std::max_align_t));
+
+#ifdef WIN32
+    return _aligned_malloc(std::max<size_t>(size, 1), alignment);
+#else
+    void* data = nullptr;
+    if (posix_memalign(&data, alignment, std::max<size_t>(size, 1)) != 0)
+        return nullptr;
+    return data;
+#endif
+}
+
+void AlignedBlobAllocator::deallocate(void* data, size_t size)
+{
+    (void)size;
+
+#ifdef WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+std::shared_ptr<AlignedBlobAllocator> AlignedBlobAllocator::getInstance()
+{
+    static auto instance = std::make_shared<AlignedBlobAllocator>();
+    return instance;
+}
+
+AllocatedBlob::AllocatedBlob(std::shared_ptr<IBlobAllocator> allocator, void* data, size_t size, size_t capacity) :
+    allocator_(std::move(allocator)), data_(data), size_(size), capacity_(capacity)
+{}
+
+AllocatedBlob::~AllocatedBlob()
+{
+    if (data_)
+    {
+        allocator_->deallocate(data_, capacity_);
+    }
+}
+
+const void* AllocatedBlob::data() const
+{
+    return data_;
+}
+
+size_t AllocatedBlob::size() const
+{
+    return size_;
+}
+
+MappedBlob::MappedBlob(void* mapping, size_t size) : MappedBlob(mapping, size, 0, size)
+{}
+
+MappedBlob::MappedBlob(void* mapping, size_t mappingSize, size_t offset, size_t size) :
+    mapping_(mapping), mappingSize_(mappingSize), data_(static_cast<const char*>(mapping) + offset), size_(size)
+{}
+
+MappedBlob::~MappedBlob()
+{
+    if (mapping_)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(mapping_);
+#else
+        munmap(mapping_, mappingSize_);
+#endif
+    }
+}
+
+const void* MappedBlob::data() const
+{
+    return data_;
+}
+
+size_t MappedBlob::size() const
+{
+    return size_;
+}
+
+void MappedBlob::advise(AccessHint hint, size_t offset, size_t size) const
+{
+#ifdef WIN32
+    (void)hint;
+    (void)offset;
+    (void)size;
+#else
+    if (!mapping_ || offset >= size_)
+        return;
+
+    // madvise wants a page aligned start address, the mapping itself always is
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    const size_t dataOffset = static_cast<size_t>(data_ - static_cast<const char*>(mapping_));
+
+    size_t begin = (dataOffset + offset) & ~(pageSize - 1);
+    size_t end   = dataOffset + (size > size_ - offset ? size_ : offset + size);
+
+    int advice = MADV_NORMAL;
+    switch (hint)
+    {
+        case AccessHint::Sequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case AccessHint::Random:
+            advice = MADV_RANDOM;
+            break;
+        case AccessHint::WillNeed:
+            advice = MADV_WILLNEED;
+            break;
+        default:
+            break;
+    }
+
+    madvise(static_cast<char*>(mapping_) + begin, end - begin, advice);
+#endif
+}
+
+#ifndef WIN32
+static std::shared_ptr<MappedBlob> mapNativeFile(int fd, uint64_t offset, size_t size, MappedBlob::AccessHint hint)
+{
+    // the mapping has to start on a page boundary, the blob then skips the head of the first page
+    static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+    const uint64_t mappingOffset = offset & ~(pageSize - 1);
+    const size_t   head          = static_cast<size_t>(offset - mappingOffset);
+
+    void* mapping = mmap(nullptr, head + size, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(mappingOffset));
+
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    auto blob = std::make_shared<MappedBlob>(mapping, head + size, head, size);
+    if (hint != MappedBlob::AccessHint::Normal)
+    {
+        blob->advise(hint);
+    }
+
+    return blob;
+}
+
+// Returns the number of bytes read, which is less than 'size' only at the end of the file, or -1 on errors
+static ssize_t preadAll(int fd, void* buffer, size_t size, uint64_t offset)
+{
+    size_t bytesRead = 0;
+    while (bytesRead < size)
+    {
+        ssize_t result =
+            pread(fd, static_cast<char*>(buffer) + bytesRead, size - bytesRead, static_cast<off_t>(offset + bytesRead));
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (result == 0)
+            break;
+        bytesRead += static_cast<size_t>(result);
+    }
+
+    return static_cast<ssize_t>(bytesRead);
+}
+
+// Read a range of an open file, memory-mapping it when it is large enough
+static std::shared_ptr<IBlob> readNativeRange(int fd, uint64_t offset, size_t size, size_t mappingThreshold)
+{
+    if (size >= mappingThreshold && size > 0)
+    {
+        auto blob = mapNativeFile(fd, offset, size, MappedBlob::AccessHint::Sequential);
+        if (blob)
+            return blob;
+
+        // mapping can fail on special file systems, fall back to a plain read
+    }
+
+    char* data = static_cast<char*>(malloc(size));
+
+    assert(data != nullptr || size == 0);
+
+    if (preadAll(fd, data, size, offset) != static_cast<ssize_t>(size))
+    {
+        free(data);
+        return nullptr;
+    }
+
+    return std::make_shared<Blob>(data, size);
+}
+
+// Read 'size' bytes from 'offset' into 'buffer', bypassing the page cache for the aligned part of the
+// transfer if it is at least 'directIoThreshold' bytes. Returns the number of bytes read, or -1 on errors.
+static ssize_t readNativeInto(int                          fd,
+                              const std::filesystem::path& name,
+                              void*                        buffer,
+                              size_t                       size,
+                              uint64_t                     offset,
+                              size_t                       directIoThreshold)
+{
+    size_t bytesRead = 0;
+
+#ifdef O_DIRECT
+    constexpr size_t kAlignment = NativeFileSystem::kDirectIoAlignment;
+
+    const size_t directSize = size & ~(kAlignment - 1);
+    const bool   aligned    = reinterpret_cast<uintptr_t>(buffer) % kAlignment == 0 && offset % kAlignment == 0;
+
+    if (directSize >= directIoThreshold && directSize > 0 && aligned)
+    {
+        // toggling O_DIRECT with fcntl is not reliable, use a separate descriptor.
+        // Not every file system supports direct I/O, the plain read below works everywhere.
+        int directFd = open(name.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+        if (directFd >= 0)
+        {
+            ssize_t result = preadAll(directFd, buffer, directSize, offset);
+            close(directFd);
+
+            if (result > 0)
+                bytesRead = static_cast<size_t>(result);
+        }
+    }
+#else
+    (void)name;
+    (void)directIoThreshold;
+#endif
+
+    if (bytesRead < size)
+    {
+        ssize_t result = preadAll(fd, static_cast<char*>(buffer) + bytesRead, size - bytesRead, offset + bytesRead);
+        if (result < 0)
+            return -1;
+
+        bytesRead += static_cast<size_t>(result);
+    }
+
+    return static_cast<ssize_t>(bytesRead);
+}
+
+// Stream reading an open file through a small buffer, so that parsing headers field by field stays cheap
+class NativeFileStream : public IFileStream {
+public:
+    static constexpr size_t kBufferSize = 64 * 1024;
+
+    NativeFileStream(int fd, uint64_t size) : fd_(fd), size_(size)
+    {}
+
+    ~NativeFileStream() override
+    {
+        close(fd_);
+    }
+
+    int64_t read(void* buffer, size_t size) override
+    {
+        char*  dst       = static_cast<char*>(buffer);
+        size_t remaining = static_cast<size_t>(std::min<uint64_t>(size, size_ - position_));
+        size_t copied    = 0;
+
+        while (remaining > 0)
+        {
+            // serve what the buffer already holds
+            if (position_ >= bufferStart_ && position_ < bufferStart_ + bufferSize_)
+            {
+                size_t available = static_cast<size_t>(bufferStart_ + bufferSize_ - position_);
+                size_t count     = std::min(available, remaining);
+
+                memcpy(dst + copied, buffer_.get() + (position_ - bufferStart_), count);
+                position_ += count;
+                copied += count;
+                remaining -= count;
+                continue;
+            }
+
+            // large reads bypass the buffer
+            if (remaining >= kBufferSize)
+            {
+                ssize_t result = pread(fd_, dst + copied, remaining, static_cast<off_t>(position_));
+                if (result < 0 && errno == EINTR)
+                    continue;
+                if (result <= 0)
+                    return copied > 0 ? static_cast<int64_t>(copied) : static_cast<int64_t>(Status::Failed);
+
+                position_ += static_cast<uint64_t>(result);
+                copied += static_cast<size_t>(result);
+                remaining -= static_cast<size_t>(result);
+                continue;
+            }
+
+            if (!buffer_)
+            {
+                buffer_.reset(new char[kBufferSize]);
+            }
+
+            ssize_t result = pread(fd_, buffer_.get(), kBufferSize, static_cast<off_t>(position_));
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                return copied > 0 ? static_cast<int64_t>(copied) : static_cast<int64_t>(Status::Failed);
+
+            bufferStart_ = position_;
+            bufferSize_  = static_cast<size_t>(result);
+        }
+
+        return static_cast<int64_t>(copied);
+    }
+
+    bool seek(uint64_t position) override
+    {
+        if (position > size_)
+            return false;
+
+        position_ = position;
+        return true;
+    }
+
+    [[nodiscard]] uint64_t tell() const override
+    {
+        return position_;
+    }
+
+    [[nodiscard]] uint64_t size() const override
+    {
+        return size_;
+    }
+
+private:
+    int                     fd_          = -1;
+    uint64_t                size_        = 0;
+    uint64_t                position_    = 0;
+    std::unique_ptr<char[]> buffer_;
+    uint64_t                bufferStart_ = 0;
+    size_t                  bufferSize_  = 0;
+};
+#endif
+
+std::shared_ptr<MappedBlob> MappedBlob::mapFile(const std::filesystem::path& name, AccessHint hint)
+{
+#ifdef WIN32
+    (void)hint;
+
+    HANDLE file = CreateFileW(name.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (!mapping)
+    {
+        LOG_ERROR("Map File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (!view)
+    {
+        LOG_ERROR("Map File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    return std::make_shared<MappedBlob>(view, static_cast<size_t>(fileSize.QuadPart));
+#else
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // the mapping keeps its own reference to the file, the descriptor is no longer needed
+    auto blob = mapNativeFile(fd, 0, static_cast<size_t>(st.st_size), hint);
+    close(fd);
+
+    if (!blob)
+    {
+        LOG_ERROR("Map File: {} Failed!", name.string());
+    }
+
+    return blob;
+#endif
+}
+
+bool IFileSystem::isImmutable() const
+{
+    return false;
+}
+
+FileStat IFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    FileStat result;
+
+    if (isFileExists(name))
+    {
+        result.type = FileStat::Type::File;
+    }
+    else if (isFolderExists(name))
+    {
+        result.type = FileStat::Type::Directory;
+    }
+
+    return result;
+}
+
+std::vector<FileStat> IFileSystem::getFileStats(const std::vector<std::filesystem::path>& names)
+{
+    std::vector<FileStat> results;
+    results.reserve(names.size());
+
+    for (const auto& name : names)
+    {
+        results.push_back(getFileStat(name));
+    }
+
+    return results;
+}
+
+bool IFileSystem::getContentHash(const std::filesystem::path& name, uint64_t* outHash)
+{
+    std::shared_ptr<IBlob> blob = readFile(name);
+
+    if (!blob)
+        return false;
+
+    *outHash = hash::xxh3(blob->data(), blob->size());
+    return true;
+}
+
+std::shared_ptr<IBlob> IFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+    std::shared_ptr<IBlob> blob = readFile(name);
+
+    if (!blob || (offset == 0 && size == 0))
+        return blob;
+
+    auto view = BlobView::slice(blob, static_cast<size_t>(std::min<uint64_t>(offset, SIZE_MAX)), size);
+    if (!view)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+    }
+
+    return view;
+}
+
+std::unique_ptr<IFileStream> IFileSystem::openStream(const std::filesystem::path& name)
+{
+    std::shared_ptr<IBlob> blob = readFile(name);
+
+    if (!blob)
+        return nullptr;
+
+    return std::make_unique<BlobFileStream>(std::move(blob));
+}
+
+int64_t IFileSystem::readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset)
+{
+    std::unique_ptr<IFileStream> stream = openStream(name);
+
+    if (!stream)
+        return static_cast<int64_t>(Status::PathNotFound);
+
+    if (!stream->seek(offset))
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        return static_cast<int64_t>(Status::Failed);
+    }
+
+    size_t bytesRead = 0;
+    while (bytesRead < size)
+    {
+        int64_t result = stream->read(static_cast<char*>(buffer) + bytesRead, size - bytesRead);
+        if (result < 0)
+            return result;
+        if (result == 0)
+            break;
+        bytesRead += static_cast<size_t>(result);
+    }
+
+    return static_cast<int64_t>(bytesRead);
+}
+
+std::shared_ptr<IBlob> IFileSystem::readFileWithAllocator(const std::filesystem::path&    name,
+                                                          std::shared_ptr<IBlobAllocator> allocator)
+{
+    std::unique_ptr<IFileStream> stream = openStream(name);
+
+    if (!stream)
+        return nullptr;
+
+    const size_t size = static_cast<size_t>(stream->size());
+    void*        data = allocator->allocate(size, alignof(std::max_align_t));
+
+    if (!data)
+    {
+        LOG_ERROR("Read File: {} Failed! Cannot allocate {} bytes", name.string(), size);
+        return nullptr;
+    }
+
+    auto blob = std::make_shared<AllocatedBlob>(std::move(allocator), data, size, size);
+
+    size_t bytesRead = 0;
+    while (bytesRead < size)
+    {
+        int64_t result = stream->read(static_cast<char*>(data) + bytesRead, size - bytesRead);
+        if (result <= 0)
+        {
+            LOG_ERROR("Read File: {} Failed!", name.string());
+            return nullptr;
+        }
+        bytesRead += static_cast<size_t>(result);
+    }
+
+    return blob;
+}
+
+void IFileSystem::submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback)
+{
+    auto sharedCallback = std::make_shared<read_callback_t>(std::move(callback));
+
+    for (size_t index = 0; index < requests.size(); ++index)
+    {
+        muggle::ThreadPool::getIoPool().post([this, request = requests[index], index, sharedCallback]() {
+            (*sharedCallback)(index, readRange(request.path, request.offset, request.size));
+        });
+    }
+}
+
+static write_future_t makeReadyWriteFuture(bool result)
+{
+    std::promise<bool> promise;
+    promise.set_value(result);
+    return promise.get_future().share();
+}
+
+write_future_t IFileSystem::submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
+{
+    return muggle::ThreadPool::getIoPool()
+        .enqueue([this, name, data = std::move(data)]() { return writeFile(name, data->data(), data->size()); })
+        .share();
+}
+
+write_future_t IFileSystem::writeFileAsync(const std::filesystem::path& name, const void* data, size_t size)
+{
+    void* copy = nullptr;
+    if (size > 0)
+    {
+        copy = malloc(size);
+        if (!copy)
+        {
+            LOG_ERROR("Write File: {} Failed! Out of memory", name.string());
+            return makeReadyWriteFuture(false);
+        }
+        memcpy(copy, data, size);
+    }
+
+    return submitWrite(name, std::make_shared<Blob>(copy, size));
+}
+
+std::vector<std::future<std::shared_ptr<IBlob>>> IFileSystem::readFilesAsync(const std::vector<ReadRequest>& requests)
+{
+    using promise_t = std::promise<std::shared_ptr<IBlob>>;
+
+    auto promises = std::make_shared<std::vector<promise_t>>(requests.size());
+
+    std::vector<std::future<std::shared_ptr<IBlob>>> futures;
+    futures.reserve(requests.size());
+    for (auto& promise : *promises)
+    {
+        futures.push_back(promise.get_future());
+    }
+
+    submitReads(requests, [promises](size_t index, std::shared_ptr<IBlob> blob) {
+        (*promises)[index].set_value(std::move(blob));
+    });
+
+    return futures;
+}
+
+static int enumerateFilesRecursive(IFileSystem&                    fs,
+                                   const std::filesystem::path&    path,
+                                   const std::string&              prefix,
+                                   const std::vector<std::string>& extensions,
+                                   enumerate_callback_t            callback,
+                                   bool                            allowDuplicates)
+{
+    int numEntries = fs.enumerateFiles(
+        path, extensions, [&](std::string_view name) { callback(prefix + std::string(name)); }, allowDuplicates);
+
+    if (numEntries < 0)
+        return numEntries;
+
+    std::vector<std::string> directories;
+    fs.enumerateDirectories(path, enumerate_to_vector(directories), allowDuplicates);
+
+    for (const auto& directory : directories)
+    {
+        int result = enumerateFilesRecursive(
+            fs, path / directory, prefix + directory + '/', extensions, callback, allowDuplicates);
+
+        if (result > 0)
+            numEntries += result;
+    }
+
+    return numEntries;
+}
+
+int IFileSystem::enumerateFilesRecursive(const std::filesystem::path&    path,
+                                         const std::vector<std::string>& extensions,
+                                         enumerate_callback_t            callback,
+                                         bool                            allowDuplicates)
+{
+    return ::enumerateFilesRecursive(*this, path, {}, extensions, callback, allowDuplicates);
+}
+
+watch_id_t IFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    (void)path;
+    (void)callback;
+    (void)recursive;
+    return kInvalidWatchId;
+}
+
+bool IFileSystem::removeWatch(watch_id_t id)
+{
+    (void)id;
+    return false;
+}
+
+// Re-express a changed path, given below 'from', relative to 'to'
+static std::filesystem::path rebaseChangedPath(const std::filesystem::path& path,
+                                               const std::filesystem::path& from,
+                                               const std::filesystem::path& to)
+{
+    std::filesystem::path relativePath = path.relative_path().lexically_relative(from.relative_path());
+
+    if (relativePath.empty() || relativePath == ".")
+        return to;
+
+    return to / relativePath;
+}
+
+// Whether the normalized path 'path' is 'root' or inside it
+static bool isSameOrUnder(const std::filesystem::path::string_type& path,
+                          const std::filesystem::path::string_type& root)
+{
+    if (path.compare(0, root.size(), root) != 0)
+        return false;
+
+    return path.size() == root.size() || root.empty() || root.back() == std::filesystem::path::preferred_separator ||
+           path[root.size()] == std::filesystem::path::preferred_separator;
+}
+
+BlobFileStream::BlobFileStream(std::shared_ptr<IBlob> blob) : blob_(std::move(blob))
+{}
+
+int64_t BlobFileStream::read(void* buffer, size_t size)
+{
+    size_t count = static_cast<size_t>(std::min<uint64_t>(size, blob_->size() - position_));
+
+    if (count > 0)
+    {
+        memcpy(buffer, static_cast<const char*>(blob_->data()) + position_, count);
+        position_ += count;
+    }
+
+    return static_cast<int64_t>(count);
+}
+
+bool BlobFileStream::seek(uint64_t position)
+{
+    if (position > blob_->size())
+        return false;
+
+    position_ = position;
+    return true;
+}
+
+uint64_t BlobFileStream::tell() const
+{
+    return position_;
+}
+
+uint64_t BlobFileStream::size() const
+{
+    return blob_->size();
+}
+
 bool NativeFileSystem::isFolderExists(const std::filesystem::path& name)
 {
-    return std::filesystem::exists(name) && std::filesystem::is_directory(name);
+    return getFileStat(name).isDirectory();
+}
+
+bool NativeFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    return getFileStat(name).isFile();
+}
+
+FileStat NativeFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    FileStat result;
+
+#ifdef WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(name.c_str(), GetFileExInfoStandard, &data))
+        return result;
+
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+    {
+        result.type = FileStat::Type::Directory;
+    }
+    else
+    {
+        result.type = FileStat::Type::File;
+        result.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    // FILETIME counts 100 ns intervals since 1601
+    const uint64_t ticks = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                           data.ftLastWriteTime.dwLowDateTime;
+    result.modifiedTime  = (static_cast<int64_t>(ticks) - 116444736000000000LL) * 100;
+#else
+    // a single stat gives the type, where std::filesystem needs one call per question
+    struct stat st;
+    if (::stat(name.c_str(), &st) != 0)
+        return result;
+
+    if (S_ISREG(st.st_mode))
+    {
+        result.type = FileStat::Type::File;
+        result.size = static_cast<uint64_t>(st.st_size);
+    }
+    else if (S_ISDIR(st.st_mode))
+    {
+        result.type = FileStat::Type::Directory;
+    }
+    else
+    {
+        return result;
+    }
+
+#ifdef __APPLE__
+    result.modifiedTime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    result.modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+
+    return result;
+}
+
+std::shared_ptr<IBlob> NativeFileSystem::readFile(const std::filesystem::path& name)
+{
+#ifndef WIN32
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("Stat File: {} Failed!", name.string());
+        close(fd);
+        return nullptr;
+    }
+
+    auto blob = readNativeRange(fd, 0, static_cast<size_t>(st.st_size), mappingThreshold_);
+    close(fd);
+
+    if (!blob)
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+    }
+
+    return blob;
+#else
+    std::ifstream file(name, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string().c_str());
+        return nullptr;
+    }
+
+    file.seekg(0, std::ios::end);
+    uint64_t size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    char* data = static_cast<char*>(malloc(size));
+
+    assert(data != nullptr);
+
+    file.read(data, size);
+
+    if (!file.good())
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+        assert(0);
+        return nullptr;
+    }
+
+    return std::make_shared<Blob>(data, size);
+#endif
+}
+
+std::shared_ptr<IBlob> NativeFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+#ifndef WIN32
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("Stat File: {} Failed!", name.string());
+        close(fd);
+        return nullptr;
+    }
+
+    const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+    if (offset > fileSize || size > fileSize - offset)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        close(fd);
+        return nullptr;
+    }
+
+    auto blob = readNativeRange(fd, offset, size != 0 ? size : static_cast<size_t>(fileSize - offset), mappingThreshold_);
+    close(fd);
+
+    if (!blob)
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+    }
+
+    return blob;
+#else
+    std::ifstream file(name, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = file.tellg();
+
+    if (offset > fileSize || size > fileSize - offset)
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        return nullptr;
+    }
+
+    size_t rangeSize = size != 0 ? size : static_cast<size_t>(fileSize - offset);
+    char*  data      = static_cast<char*>(malloc(rangeSize));
+
+    assert(data != nullptr || rangeSize == 0);
+
+    file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file.read(data, static_cast<std::streamsize>(rangeSize));
+
+    if (!file.good())
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+        free(data);
+        return nullptr;
+    }
+
+    return std::make_shared<Blob>(data, rangeSize);
+#endif
+}
+
+int64_t NativeFileSystem::readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset)
+{
+#ifdef WIN32
+    return IFileSystem::readFileInto(name, buffer, size, offset);
+#else
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return static_cast<int64_t>(Status::PathNotFound);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || offset > static_cast<uint64_t>(st.st_size))
+    {
+        LOG_ERROR("Read File: {} Failed! Range is out of bounds", name.string());
+        close(fd);
+        return static_cast<int64_t>(Status::Failed);
+    }
+
+    size = static_cast<size_t>(std::min<uint64_t>(size, static_cast<uint64_t>(st.st_size) - offset));
+
+    ssize_t bytesRead = readNativeInto(fd, name, buffer, size, offset, directIoThreshold_);
+    close(fd);
+
+    if (bytesRead < 0)
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+        return static_cast<int64_t>(Status::Failed);
+    }
+
+    return bytesRead;
+#endif
+}
+
+std::shared_ptr<IBlob> NativeFileSystem::readFileWithAllocator(const std::filesystem::path&    name,
+                                                               std::shared_ptr<IBlobAllocator> allocator)
+{
+#ifdef WIN32
+    return IFileSystem::readFileWithAllocator(name, std::move(allocator));
+#else
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("Stat File: {} Failed!", name.string());
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+
+    // large files get a buffer suitable for direct I/O, rounded up so that the tail is read directly too
+    const bool   direct    = size >= directIoThreshold_;
+    const size_t alignment = direct ? kDirectIoAlignment : alignof(std::max_align_t);
+    const size_t capacity  = direct ? (size + kDirectIoAlignment - 1) & ~(kDirectIoAlignment - 1) : size;
+
+    void* data = allocator->allocate(capacity, alignment);
+    if (!data)
+    {
+        LOG_ERROR("Read File: {} Failed! Cannot allocate {} bytes", name.string(), capacity);
+        close(fd);
+        return nullptr;
+    }
+
+    auto blob = std::make_shared<AllocatedBlob>(std::move(allocator), data, size, capacity);
+
+    ssize_t bytesRead = readNativeInto(fd, name, data, capacity, 0, directIoThreshold_);
+    close(fd);
+
+    if (bytesRead != static_cast<ssize_t>(size))
+    {
+        LOG_ERROR("Read File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    return blob;
+#endif
+}
+
+std::unique_ptr<IFileStream> NativeFileSystem::openStream(const std::filesystem::path& name)
+{
+#ifndef WIN32
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed!", name.string());
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("Stat File: {} Failed!", name.string());
+        close(fd);
+        return nullptr;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    return std::make_unique<NativeFileStream>(fd, static_cast<uint64_t>(st.st_size));
+#else
+    return IFileSystem::openStream(name);
+#endif
+}
+
+bool NativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    return WriteQueue::writeAtomically(name, data, size, false);
+}
+
+write_future_t NativeFileSystem::submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
+{
+    return WriteQueue::getInstance().enqueue(name, std::move(data));
+}
+
+void NativeFileSystem::submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback)
+{
+    if (!IoUringReader::getInstance())
+    {
+        IFileSystem::submitReads(requests, std::move(callback));
+        return;
+    }
+
+#ifndef WIN32
+    auto sharedCallback = std::make_shared<read_callback_t>(std::move(callback));
+
+    // opening the files is I/O as well: it is done on an I/O thread, which also reports the requests that fail
+    ThreadPool::getIoPool().post([this, requests, sharedCallback]() {
+        IoUringReader* reader = IoUringReader::getInstance();
+        if (!reader)
+        {
+            IFileSystem::submitReads(requests, *sharedCallback);
+            return;
+        }
+
+        std::vector<IoUringReader::Read> reads;
+        reads.reserve(requests.size());
+
+        for (size_t index = 0; index < requests.size(); ++index)
+        {
+            const ReadRequest& request = requests[index];
+
+            int fd = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                LOG_ERROR("Open File: {} Failed!", request.path.string());
+                (*sharedCallback)(index, nullptr);
+                continue;
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                LOG_ERROR("Stat File: {} Failed!", request.path.string());
+                close(fd);
+                (*sharedCallback)(index, nullptr);
+                continue;
+            }
+
+            const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+            if (request.offset > fileSize || request.size > fileSize - request.offset)
+            {
+                LOG_ERROR("Read File: {} Failed! Range is out of bounds", request.path.string());
+                close(fd);
+                (*sharedCallback)(index, nullptr);
+                continue;
+            }
+
+            IoUringReader::Read read;
+            read.fd         = fd;
+            read.offset     = request.offset;
+            read.size       = request.size != 0 ? request.size : static_cast<size_t>(fileSize - request.offset);
+            read.completion = [sharedCallback, index](std::shared_ptr<IBlob> blob) {
+                (*sharedCallback)(index, std::move(blob));
+            };
+            reads.push_back(std::move(read));
+        }
+
+        reader->submit(reads);
+    });
+#endif
+}
+
+#ifdef WIN32
+static int enumerateNativeFiles(const std::filesystem::path& path,
+                                bool                         directories,
+                                const FilePattern&           pattern,
+                                enumerate_callback_t         callback)
+{
+    std::string      search = (path / "*").generic_string();
+    WIN32_FIND_DATAA findData;
+    HANDLE           hFind = FindFirstFileA(search.c_str(), &findData);
+
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        if (GetLastError() == ERROR_FILE_NOT_FOUND)
+        {
+            return 0;
+        }
+        return static_cast<int>(Status::Failed);
+    }
+
+    int numEntries = 0;
+
+    do
+    {
+        const bool isDirectory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        const bool isDot       = strcmp(findData.cFileName, ".") == 0;
+        const bool isDotDot    = strcmp(findData.cFileName, "..") == 0;
+
+        if (isDirectory == directories && !isDot && !isDotDot && pattern.matches(findData.cFileName))
+        {
+            callback(findData.cFileName);
+            ++numEntries;
+        }
+
+    } while (FindNextFileA(hFind, &findData) != 0);
+
+    FindClose(hFind);
+
+    return numEntries;
+}
+#else
+struct NativeDirectoryEntry
+{
+    const char* name;
+    bool        isDirectory;
+    bool        isSymlink;
+};
+
+// Read all entries of a directory in a single pass, without a stat per entry unless the file system
+// does not report entry types. Returns false, with errno set, if the directory cannot be opened.
+template<typename Visitor>
+static bool scanNativeDirectory(const char* path, Visitor&& visitor)
+{
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    auto visit = [fd, &visitor](const char* name, unsigned char type) {
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            return;
+
+        NativeDirectoryEntry entry {name, type == DT_DIR, type == DT_LNK};
+
+        // symlinks are reported as what they point to
+        if (type == DT_UNKNOWN || type == DT_LNK)
+        {
+            struct stat st;
+            if (fstatat(fd, name, &st, 0) != 0)
+                return;
+            entry.isDirectory = S_ISDIR(st.st_mode);
+        }
+
+        visitor(entry);
+    };
+
+#ifdef __linux__
+    alignas(struct dirent64) char buffer[32 * 1024];
+
+    for (;;)
+    {
+        ssize_t length = getdents64(fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t position = 0; position < length;)
+        {
+            const auto* dirent = reinterpret_cast<const struct dirent64*>(buffer + position);
+            position += dirent->d_reclen;
+
+            visit(dirent->d_name, dirent->d_type);
+        }
+    }
+
+    close(fd);
+#else
+    DIR* dir = fdopendir(fd);
+    if (!dir)
+    {
+        close(fd);
+        return false;
+    }
+
+    while (const struct dirent* dirent = readdir(dir))
+    {
+        visit(dirent->d_name, dirent->d_type);
+    }
+
+    closedir(dir);
+#endif
+
+    return true;
+}
+
+static int enumerateNativeFiles(const std::filesystem::path& path,
+                                bool                         directories,
+                                const FilePattern&           pattern,
+                                enumerate_callback_t         callback)
+{
+    int numEntries = 0;
+
+    bool scanned = scanNativeDirectory(path.c_str(), [&](const NativeDirectoryEntry& entry) {
+        if (entry.isDirectory == directories && pattern.matches(entry.name))
+        {
+            callback(entry.name);
+            ++numEntries;
+        }
+    });
+
+    if (!scanned)
+    {
+        // a missing directory simply has no files
+        return errno == ENOENT || errno == ENOTDIR ? 0 : static_cast<int>(Status::Failed);
+    }
+
+    return numEntries;
+}
+
+// Directories waiting to be scanned by a parallel recursive enumeration, and what was found so far
+struct RecursiveScan
+{
+    std::filesystem::path root;
+    FilePattern           pattern;
+
+    std::mutex               mutex;
+    std::condition_variable  condition;
+    std::vector<std::string> directories; // relative to 'root', "" for the root itself
+    std::vector<std::string> files;
+    size_t                   activeScans = 0;
+};
+
+static void runRecursiveScan(RecursiveScan& scan)
+{
+    std::vector<std::string> subdirectories;
+    std::vector<std::string> files;
+
+    std::unique_lock<std::mutex> lock(scan.mutex);
+
+    for (;;)
+    {
+        scan.condition.wait(lock, [&scan]() { return !scan.directories.empty() || scan.activeScans == 0; });
+
+        if (scan.directories.empty())
+            return;
+
+        std::string directory = std::move(scan.directories.back());
+        scan.directories.pop_back();
+        ++scan.activeScans;
+        lock.unlock();
+
+        const std::string prefix = directory.empty() ? std::string() : directory + '/';
+        const std::string native = directory.empty() ? scan.root.native() : (scan.root / directory).native();
+
+        scanNativeDirectory(native.c_str(), [&](const NativeDirectoryEntry& entry) {
+            if (entry.isDirectory)
+            {
+                // do not follow links to directories, they may form cycles
+                if (!entry.isSymlink)
+                    subdirectories.push_back(prefix + entry.name);
+            }
+            else if (scan.pattern.matches(entry.name))
+            {
+                files.push_back(prefix + entry.name);
+            }
+        });
+
+        lock.lock();
+        --scan.activeScans;
+
+        const bool foundWork = !subdirectories.empty();
+        for (auto& subdirectory : subdirectories)
+        {
+            scan.directories.push_back(std::move(subdirectory));
+        }
+        for (auto& file : files)
+        {
+            scan.files.push_back(std::move(file));
+        }
+        subdirectories.clear();
+        files.clear();
+
+        if (foundWork || scan.activeScans == 0)
+        {
+            scan.condition.notify_all();
+        }
+    }
+}
+#endif
+
+int NativeFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                     const std::vector<std::string>& extensions,
+                                     enumerate_callback_t            callback,
+                                     bool                            allowDuplicates)
+{
+    (void)allowDuplicates;
+
+#ifdef WIN32
+    // matched like FindFirstFile would
+    return enumerateNativeFiles(path, false, FilePattern::fromExtensions(extensions, false), callback);
+#else
+    return enumerateNativeFiles(path, false, FilePattern::fromExtensions(extensions), callback);
+#endif
 }
 
-bool NativeFileSystem::isFileExists(const std::filesystem::path& name)
+int NativeFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                           enumerate_callback_t         callback,
+                                           bool                         allowDuplicates)
 {
-    return std::filesystem::exists(name) && std::filesystem::is_regular_file(name);
+    (void)allowDuplicates;
+
+    return enumerateNativeFiles(path, true, FilePattern(), callback);
 }
 
-std::shared_ptr<IBlob> NativeFileSystem::readFile(const std::filesystem::path& name)
+int NativeFileSystem::enumerateFilesRecursive(const std::filesystem::path&    path,
+                                              const std::vector<std::string>& extensions,
+                                              enumerate_callback_t            callback,
+                                              bool                            allowDuplicates)
 {
-    std::ifstream file(name, std::ios::binary);
+#ifdef WIN32
+    return IFileSystem::enumerateFilesRecursive(path, extensions, callback, allowDuplicates);
+#else
+    (void)allowDuplicates;
 
-    if (!file.is_open())
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return errno == ENOENT || errno == ENOTDIR ? 0 : static_cast<int>(Status::Failed);
+
+    if (!S_ISDIR(st.st_mode))
+        return 0;
+
+    // Directories are scanned by the I/O pool and the calling thread together; the scan is shared
+    // because helpers may only get to run after the caller has finished the whole tree.
+    auto scan        = std::make_shared<RecursiveScan>();
+    scan->root       = path;
+    scan->pattern    = FilePattern::fromExtensions(extensions);
+    scan->directories.push_back({});
+
+    ThreadPool& pool = ThreadPool::getIoPool();
+    for (uint32_t i = 0; i < pool.getThreadCount(); ++i)
     {
-        LOG_ERROR("Open File: {} Failed!", name.string().c_str());
-        return nullptr;
+        pool.post([scan]() { runRecursiveScan(*scan); });
     }
 
-    file.seekg(0, std::ios::end);
-    uint64_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    runRecursiveScan(*scan);
 
-    char* data = static_cast<char*>(malloc(size));
+    std::lock_guard<std::mutex> lock(scan->mutex);
+    for (const auto& file : scan->files)
+    {
+        callback(file);
+    }
 
-    assert(data != nullptr);
+    return static_cast<int>(scan->files.size());
+#endif
+}
 
-    file.read(data, size);
+watch_id_t NativeFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    FileWatcher* watcher = FileWatcher::getInstance();
+    if (!watcher)
+        return kInvalidWatchId;
 
-    if (!file.good())
+    return watcher->addWatch(path, std::move(callback), recursive);
+}
+
+bool NativeFileSystem::removeWatch(watch_id_t id)
+{
+    FileWatcher* watcher = FileWatcher::getInstance();
+    return watcher && watcher->removeWatch(id);
+}
+
+RelativeFileSystem::RelativeFileSystem(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& basePath) :
+    underlyingFS_(std::move(fs)), basePath_(basePath.lexically_normal())
+{}
+
+bool RelativeFileSystem::isFolderExists(const std::filesystem::path& name)
+{
+    return underlyingFS_->isFolderExists(basePath_ / name.relative_path());
+}
+
+bool RelativeFileSystem::isFileExists(const std::filesystem::path& name)
+{
+    return underlyingFS_->isFileExists(basePath_ / name.relative_path());
+}
+
+FileStat RelativeFileSystem::getFileStat(const std::filesystem::path& name)
+{
+    return underlyingFS_->getFileStat(basePath_ / name.relative_path());
+}
+
+std::vector<FileStat> RelativeFileSystem::getFileStats(const std::vector<std::filesystem::path>& names)
+{
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(names.size());
+
+    for (const auto& name : names)
     {
-        LOG_ERROR("Read File: {} Failed!", name.string());
-        assert(0);
-        return nullptr;
+        paths.push_back(basePath_ / name.relative_path());
     }
 
-    return std::make_shared<Blob>(data, size);
+    return underlyingFS_->getFileStats(paths);
 }
 
-bool NativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+bool RelativeFileSystem::getContentHash(const std::filesystem::path& name, uint64_t* outHash)
 {
-    std::ofstream file(name, std::ios::binary);
+    return underlyingFS_->getContentHash(basePath_ / name.relative_path(), outHash);
+}
 
-    if (!file.is_open())
+std::shared_ptr<IBlob> RelativeFileSystem::readFile(const std::filesystem::path& name)
+{
+    return underlyingFS_->readFile(basePath_ / name.relative_path());
+}
+
+std::shared_ptr<IBlob> RelativeFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
+{
+    return underlyingFS_->readRange(basePath_ / name.relative_path(), offset, size);
+}
+
+std::unique_ptr<IFileStream> RelativeFileSystem::openStream(const std::filesystem::path& name)
+{
+    return underlyingFS_->openStream(basePath_ / name.relative_path());
+}
+
+int64_t RelativeFileSystem::readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset)
+{
+    return underlyingFS_->readFileInto(basePath_ / name.relative_path(), buffer, size, offset);
+}
+
+std::shared_ptr<IBlob> RelativeFileSystem::readFileWithAllocator(const std::filesystem::path&    name,
+                                                                 std::shared_ptr<IBlobAllocator> allocator)
+{
+    return underlyingFS_->readFileWithAllocator(basePath_ / name.relative_path(), std::move(allocator));
+}
+
+bool RelativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+{
+    return underlyingFS_->writeFile(basePath_ / name.relative_path(), data, size);
+}
+
+write_future_t RelativeFileSystem::submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
+{
+    return underlyingFS_->submitWrite(basePath_ / name.relative_path(), std::move(data));
+}
+
+void RelativeFileSystem::submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback)
+{
+    std::vector<ReadRequest> underlyingRequests(requests);
+    for (auto& request : underlyingRequests)
     {
-        LOG_ERROR("Open File: {} Failed!", name.string());
-        return false;
+        request.path = basePath_ / request.path.relative_path();
     }
 
-    if (size > 0)
+    underlyingFS_->submitReads(underlyingRequests, std::move(callback));
+}
+
+int RelativeFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                       const std::vector<std::string>& extensions,
+                                       enumerate_callback_t            callback,
+                                       bool                            allowDuplicates)
+{
+    return underlyingFS_->enumerateFiles(basePath_ / path.relative_path(), extensions, callback, allowDuplicates);
+}
+
+int RelativeFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                             enumerate_callback_t         callback,
+                                             bool                         allowDuplicates)
+{
+    return underlyingFS_->enumerateDirectories(basePath_ / path.relative_path(), callback, allowDuplicates);
+}
+
+int RelativeFileSystem::enumerateFilesRecursive(const std::filesystem::path&    path,
+                                                const std::vector<std::string>& extensions,
+                                                enumerate_callback_t            callback,
+                                                bool                            allowDuplicates)
+{
+    return underlyingFS_->enumerateFilesRecursive(
+        basePath_ / path.relative_path(), extensions, callback, allowDuplicates);
+}
+
+watch_id_t RelativeFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    // report paths rooted the same way as the watched one, so they match what callers read with
+    std::filesystem::path root = path.root_path();
+
+    auto translate = [basePath = basePath_, root, callback = std::move(callback)](
+                         const std::vector<FileChange>& changes) {
+        std::vector<FileChange> translated;
+        translated.reserve(changes.size());
+        for (const auto& change : changes)
+        {
+            translated.push_back({rebaseChangedPath(change.path, basePath, root), change.type});
+        }
+        callback(translated);
+    };
+
+    return underlyingFS_->addWatch(basePath_ / path.relative_path(), std::move(translate), recursive);
+}
+
+bool RelativeFileSystem::removeWatch(watch_id_t id)
+{
+    return underlyingFS_->removeWatch(id);
+}
+
+void VFileSystem::mount(const std::filesystem::path& path, std::shared_ptr<IFileSystem> fs, int priority)
+{
+    if (!mountTable_.add(path.lexically_normal().generic_string(), std::move(fs), priority))
     {
-        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        LOG_ERROR("Cannot mount a filesystem at {}: it is already mounted there", path.string());
+        return;
     }
 
-    if (!file.good())
     {
-        LOG_ERROR("Write File: {} Failed!", name.string());
-        assert(0);
+        // the new layer is not watched, the changes to the paths it overlaps are no longer all reported
+        const auto mountKey = StatCache::getKey(path);
+
+        std::unique_lock<std::shared_mutex> lock(watchedPathMutex_);
+        mountKeys_.push_back(mountKey);
+        watchedPaths_.erase(std::remove_if(watchedPaths_.begin(),
+                                           watchedPaths_.end(),
+                                           [&mountKey](const WatchedPath& watched) {
+                                               return isSameOrUnder(watched.path, mountKey) ||
+                                                      isSameOrUnder(mountKey, watched.path);
+                                           }),
+                            watchedPaths_.end());
+        hasWatchedPaths_.store(!watchedPaths_.empty(), std::memory_order_release);
+    }
+
+    clearMetadataCache();
+}
+
+void VFileSystem::mount(const std::filesystem::path& path, const std::filesystem::path& nativePath, int priority)
+{
+    mount(path, std::make_shared<RelativeFileSystem>(std::make_shared<NativeFileSystem>(), nativePath), priority);
+}
+
+bool VFileSystem::unmount(const std::filesystem::path& path)
+{
+    return unmount(path, nullptr);
+}
+
+bool VFileSystem::unmount(const std::filesystem::path& path, const std::shared_ptr<IFileSystem>& fs)
+{
+    std::vector<MountTable::Match> layers;
+    std::filesystem::path          resolvedPath;
+    std::vector<IFileSystem*>      unmounted;
+
+    if (findLayers(path, &layers, &resolvedPath))
+    {
+        for (const auto& layer : layers)
+        {
+            // layers mounted exactly at 'path' have nothing left of it
+            if (layer.relativeOffset == resolvedPath.native().size() && (!fs || layer.fs == fs.get()))
+            {
+                unmounted.push_back(layer.fs);
+            }
+        }
+    }
+
+    if (!mountTable_.remove(path.lexically_normal().generic_string(), fs.get()))
         return false;
+
+    {
+        const auto mountKey = StatCache::getKey(path);
+
+        std::unique_lock<std::shared_mutex> lock(watchedPathMutex_);
+        auto it = std::find(mountKeys_.begin(), mountKeys_.end(), mountKey);
+        if (fs && it != mountKeys_.end())
+        {
+            mountKeys_.erase(it);
+        }
+        else
+        {
+            mountKeys_.erase(std::remove(mountKeys_.begin(), mountKeys_.end(), mountKey), mountKeys_.end());
+        }
+    }
+
+    {
+        // the watches of the file systems go away with them
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        removeWatchesLocked(unmounted);
     }
 
+    clearMetadataCache();
     return true;
 }
 
-static int enumerateNativeFiles(const char* pattern, bool directories, enumerate_callback_t callback)
+void VFileSystem::clearMetadataCache()
 {
-#ifdef WIN32
-    WIN32_FIND_DATAA findData;
-    HANDLE           hFind = FindFirstFileA(pattern, &findData);
+    {
+        std::unique_lock<std::shared_mutex> lock(resolveMutex_);
+        resolvedFiles_.clear();
+        ++resolveGeneration_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(contentHashMutex_);
+        contentHashes_.clear();
+    }
+
+    statCache_.clear();
+}
+
+void VFileSystem::invalidateMetadata(const std::filesystem::path& name, bool tree) const
+{
+    const auto key = StatCache::getKey(name);
 
-    if (hFind == INVALID_HANDLE_VALUE)
     {
-        if (GetLastError() == ERROR_FILE_NOT_FOUND)
+        std::unique_lock<std::shared_mutex> lock(resolveMutex_);
+        ++resolveGeneration_;
+
+        // only the files are remembered, a path that was one has nothing under it
+        if (resolvedFiles_.erase(key) == 0 && tree)
         {
-            return 0;
+            auto prefix = key + std::filesystem::path::string_type(1, std::filesystem::path::preferred_separator);
+            for (auto it = resolvedFiles_.begin(); it != resolvedFiles_.end();)
+            {
+                if (it->first.compare(0, prefix.size(), prefix) == 0)
+                {
+                    it = resolvedFiles_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
         }
-        return static_cast<int>(Status::Failed);
+    }
+    {
+        // the hashes are checked against the stats, those of the files under a directory can stay
+        std::lock_guard<std::mutex> lock(contentHashMutex_);
+        contentHashes_.erase(key);
     }
 
-    int numEntries = 0;
+    if (tree)
+    {
+        statCache_.invalidateTree(name);
+    }
+    else
+    {
+        statCache_.invalidate(name);
+    }
+}
 
-    do
+bool VFileSystem::findContentHash(const std::filesystem::path& name, const FileStat& stat, uint64_t* outHash) const
+{
+    std::lock_guard<std::mutex> lock(contentHashMutex_);
+
+    auto it = contentHashes_.find(StatCache::getKey(name));
+    if (it == contentHashes_.end() || it->second.stat.size != stat.size ||
+        it->second.stat.modifiedTime != stat.modifiedTime)
+        return false;
+
+    *outHash = it->second.hash;
+    return true;
+}
+
+void VFileSystem::recordContentHash(const std::filesystem::path& name, const FileStat& stat, uint64_t hash) const
+{
+    std::lock_guard<std::mutex> lock(contentHashMutex_);
+
+    if (contentHashes_.size() >= kMaxContentHashes)
     {
-        const bool isDirectory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-        const bool isDot       = strcmp(findData.cFileName, ".") == 0;
-        const bool isDotDot    = strcmp(findData.cFileName, "..") == 0;
+        contentHashes_.clear();
+    }
+
+    contentHashes_[StatCache::getKey(name)] = {stat, hash};
+}
+
+void VFileSystem::invalidateCompletedWrites() const
+{
+    if (!hasPendingWrites_.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(pendingWriteMutex_);
+
+    auto completed = std::remove_if(pendingWrites_.begin(), pendingWrites_.end(), [this](const auto& write) {
+        if (write.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        invalidateMetadata(write.first);
+        return true;
+    });
+    pendingWrites_.erase(completed, pendingWrites_.end());
 
-        if (isDirectory == directories && !isDot && !isDotDot)
+    hasPendingWrites_.store(!pendingWrites_.empty(), std::memory_order_release);
+}
+
+void VFileSystem::removeWatchesLocked(const std::vector<IFileSystem*>& fileSystems)
+{
+    for (auto it = watches_.begin(); it != watches_.end();)
+    {
+        auto& fsWatches = it->second;
+        for (auto watch = fsWatches.begin(); watch != fsWatches.end();)
         {
-            callback(findData.cFileName);
-            ++numEntries;
+            if (std::find(fileSystems.begin(), fileSystems.end(), watch->first) != fileSystems.end())
+            {
+                watch->first->removeWatch(watch->second);
+                watch = fsWatches.erase(watch);
+            }
+            else
+            {
+                ++watch;
+            }
         }
 
-    } while (FindNextFileA(hFind, &findData) != 0);
+        if (fsWatches.empty())
+        {
+            forgetWatchedPath(it->first);
+            it = watches_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
 
-    FindClose(hFind);
+bool VFileSystem::findMountPoint(const std::filesystem::path& path,
+                                 std::filesystem::path*       pRelativePath,
+                                 IFileSystem**                ppFS,
+                                 bool                         resolveFile) const
+{
+    using native_view_t = std::basic_string_view<std::filesystem::path::value_type>;
 
-    return numEntries;
-#else
-    glob64_t globMatches;
-    int      globResult = glob64(pattern, 0, nullptr, &globMatches);
+    MountTable::Match match;
+    bool              needsNormalization = false;
+    size_t            layerCount         = 0;
+    native_view_t     spath              = path.native();
+
+    std::filesystem::path normalized;
+    if (!mountTable_.find(spath, &match, &needsNormalization, &layerCount))
+    {
+        if (!needsNormalization)
+            return false;
+
+        // rare case of ".." in the path, resolve it on a normalized copy
+        normalized = path.lexically_normal();
+        spath      = normalized.native();
+
+        if (!mountTable_.find(spath, &match, nullptr, &layerCount))
+            return false;
+    }
 
-    if (globResult == 0)
+    // only the paths covered by several layers need to look for the file
+    if (resolveFile && layerCount > 1)
     {
-        int numEntries = 0;
-
-        for (int i = 0; i < globMatches.gl_pathc; ++i)
+        // the layers are remembered by normalized path, so that every spelling of a path is invalidated together
+        if (normalized.empty())
         {
-            const char*                      globentry = (glob_matches.gl_pathv)[i];
-            std::error_code                  ec, ec2;
-            std::filesystem::directory_entry entry(globentry, ec);
-            if (!ec)
-            {
-                if (directory_entry == entry.is_directory(ec2) && !ec2)
-                {
-                    callback(entry.path().filename().native());
-                    ++numEntries;
-                }
-            }
+            normalized = path.lexically_normal();
+            spath      = normalized.native();
         }
 
-        globfree64(&globMatches);
-
-        return numEntries;
+        invalidateCompletedWrites();
+        match = resolveLayer(normalized.native());
+        if (!match.fs)
+            return false;
     }
 
-    if (globResult == GLOB_NOMATCH)
-        return 0;
+    if (pRelativePath)
+    {
+        *pRelativePath = spath.substr(match.relativeOffset);
+    }
 
-    return static_cast<int>(Status::Failed);
+    if (ppFS)
+    {
+        *ppFS = match.fs;
+    }
 
-#endif
+    return true;
 }
 
-int NativeFileSystem::enumerateFiles(const std::filesystem::path&    path,
-                                     const std::vector<std::string>& extensions,
-                                     enumerate_callback_t            callback,
-                                     bool                            allowDuplicates)
+bool VFileSystem::findLayers(const std::filesystem::path&    path,
+                             std::vector<MountTable::Match>* pLayers,
+                             std::filesystem::path*          pResolvedPath) const
 {
-    (void)allowDuplicates;
+    using native_view_t = std::basic_string_view<std::filesystem::path::value_type>;
 
-    if (extensions.empty())
+    bool needsNormalization = false;
+    if (mountTable_.findAll(native_view_t(path.native()), pLayers, &needsNormalization))
     {
-        std::string patten = (path / "*").generic_string();
-        return enumerateNativeFiles(patten.c_str(), false, callback);
+        *pResolvedPath = path;
+        return true;
     }
 
-    int numEntries = 0;
-    for (const auto& ext : extensions)
+    if (!needsNormalization)
+        return false;
+
+    *pResolvedPath = path.lexically_normal();
+    return mountTable_.findAll(native_view_t(pResolvedPath->native()), pLayers);
+}
+
+MountTable::Match VFileSystem::resolveLayer(std::filesystem::path::string_type path) const
+{
+    using native_view_t = std::basic_string_view<std::filesystem::path::value_type>;
+
+    uint64_t generation = 0;
     {
-        std::string pattern = (path / ("*" + ext)).generic_string();
-        int         result  = enumerateNativeFiles(pattern.c_str(), false, callback);
+        std::shared_lock<std::shared_mutex> lock(resolveMutex_);
 
-        if (result < 0)
-            return result;
+        auto it = resolvedFiles_.find(path);
+        if (it != resolvedFiles_.end())
+            return it->second;
 
-        numEntries += result;
+        generation = resolveGeneration_;
     }
 
-    return numEntries;
-}
+    std::vector<MountTable::Match> layers;
+    if (!mountTable_.findAll(native_view_t(path), &layers))
+        return {};
 
-int NativeFileSystem::enumerateDirectories(const std::filesystem::path& path,
-                                           enumerate_callback_t         callback,
-                                           bool                         allowDuplicates)
-{
-    (void)allowDuplicates;
+    for (auto layer = layers.begin(); layer != layers.end(); ++layer)
+    {
+        if (layer->fs->isFileExists(native_view_t(path).substr(layer->relativeOffset)))
+        {
+            // elsewhere nothing would tell when the file is removed from this layer or added to one above it
+            const bool remember = isWatched(path) || std::all_of(layers.begin(), layer + 1, [](const auto& match) {
+                                      return match.fs->isImmutable();
+                                  });
+            if (!remember)
+                return *layer;
 
-    std::string pattern = (path / "*").generic_string();
-    return enumerateNativeFiles(pattern.c_str(), true, callback);
-}
+            std::unique_lock<std::shared_mutex> lock(resolveMutex_);
 
-RelativeFileSystem::RelativeFileSystem(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& basePath) :
-    underlyingFS_(std::move(fs)), basePath_(basePath.lexically_normal())
-{}
+            // a file added or removed meanwhile may have moved the path to another layer
+            if (resolveGeneration_ != generation)
+                return *layer;
 
-bool RelativeFileSystem::isFolderExists(const std::filesystem::path& name)
-{
-    return underlyingFS_->isFolderExists(basePath_ / name.relative_path());
-}
+            if (resolvedFiles_.size() >= kMaxResolvedFiles)
+            {
+                resolvedFiles_.clear();
+            }
 
-bool RelativeFileSystem::isFileExists(const std::filesystem::path& name)
-{
-    return underlyingFS_->isFileExists(basePath_ / name.relative_path());
-}
+            resolvedFiles_.emplace(std::move(path), *layer);
+            return *layer;
+        }
+    }
 
-std::shared_ptr<IBlob> RelativeFileSystem::readFile(const std::filesystem::path& name)
-{
-    return underlyingFS_->readFile(basePath_ / name.relative_path());
+    // missing files are not remembered, they may be created later
+    return layers.front();
 }
 
-bool RelativeFileSystem::writeFile(const std::filesystem::path& name, const void* data, size_t size)
+bool VFileSystem::isFolderExists(const std::filesystem::path& name)
 {
-    return underlyingFS_->writeFile(basePath_ / name.relative_path(), data, size);
+    return getFileStat(name).isDirectory();
 }
 
-int RelativeFileSystem::enumerateFiles(const std::filesystem::path&    path,
-                                       const std::vector<std::string>& extensions,
-                                       enumerate_callback_t            callback,
-                                       bool                            allowDuplicates)
+bool VFileSystem::isFileExists(const std::filesystem::path& name)
 {
-    return underlyingFS_->enumerateFiles(basePath_ / path.relative_path(), extensions, callback, allowDuplicates);
+    return getFileStat(name).isFile();
 }
 
-int RelativeFileSystem::enumerateDirectories(const std::filesystem::path& path,
-                                             enumerate_callback_t         callback,
-                                             bool                         allowDuplicates)
+bool VFileSystem::isWatched(const std::filesystem::path& name) const
 {
-    return underlyingFS_->enumerateDirectories(basePath_ / path.relative_path(), callback, allowDuplicates);
-}
+    if (!hasWatchedPaths_.load(std::memory_order_acquire))
+        return false;
 
-void VFileSystem::mount(const std::filesystem::path& path, std::shared_ptr<IFileSystem> fs)
-{
-    if (findMountPoint(path, nullptr, nullptr))
+    const auto key = StatCache::getKey(name);
+
+    std::shared_lock<std::shared_mutex> lock(watchedPathMutex_);
+    for (const auto& watched : watchedPaths_)
     {
-        LOG_ERROR("Cannot mount a filesystem at {}: there is another FS that includes this path", path.string());
-        return;
+        if (!isSameOrUnder(key, watched.path))
+            continue;
+
+        if (watched.recursive || key.size() == watched.path.size())
+            return true;
+
+        // without recursion only the entries of the directory itself are watched
+        size_t start = watched.path.size();
+        if (watched.path.empty() || watched.path.back() != std::filesystem::path::preferred_separator)
+        {
+            ++start;
+        }
+        if (key.find(std::filesystem::path::preferred_separator, start) == std::filesystem::path::string_type::npos)
+            return true;
     }
 
-    mountPoints_.push_back(std::make_pair(path.lexically_normal().generic_string(), fs));
+    return false;
 }
 
-void VFileSystem::mount(const std::filesystem::path& path, const std::filesystem::path& nativePath)
+void VFileSystem::forgetWatchedPath(watch_id_t id)
 {
-    mount(path, std::make_shared<RelativeFileSystem>(std::make_shared<NativeFileSystem>(), nativePath));
+    std::unique_lock<std::shared_mutex> lock(watchedPathMutex_);
+
+    watchedPaths_.erase(std::remove_if(watchedPaths_.begin(),
+                                       watchedPaths_.end(),
+                                       [id](const WatchedPath& watched) { return watched.id == id; }),
+                        watchedPaths_.end());
+    hasWatchedPaths_.store(!watchedPaths_.empty(), std::memory_order_release);
 }
 
-bool VFileSystem::unmount(const std::filesystem::path& path)
+FileStat VFileSystem::getFileStat(const std::filesystem::path& name)
 {
-    std::string spath = path.lexically_normal().generic_string();
+    invalidateCompletedWrites();
+
+    // elsewhere nothing would tell when the stat changes
+    const bool     cached     = isWatched(name);
+    const uint64_t generation = statCache_.getGeneration();
+
+    FileStat result;
+    if (cached && statCache_.find(name, &result))
+        return result;
+
+    // files are looked for in the layer that holds them, which is remembered where it cannot change unseen
+    std::filesystem::path relativePath;
+    IFileSystem*          fs = nullptr;
 
-    for (size_t index = 0; index < mountPoints_.size(); index++)
+    if (findMountPoint(name, &relativePath, &fs, true))
     {
-        if (mountPoints_[index].first == spath)
+        result = fs->getFileStat(relativePath);
+    }
+
+    // no layer holds a file, the path may still be a directory of a lower layer
+    std::vector<MountTable::Match> layers;
+    std::filesystem::path          resolvedPath;
+
+    if (!result.isFile() && findLayers(name, &layers, &resolvedPath))
+    {
+        for (const auto& layer : layers)
         {
-            mountPoints_.erase(mountPoints_.begin() + index);
-            return true;
+            if (result.exists())
+                break;
+
+            if (layer.fs != fs)
+            {
+                result = layer.fs->getFileStat(resolvedPath.native().substr(layer.relativeOffset));
+            }
         }
     }
 
-    return false;
+    if (cached)
+    {
+        statCache_.insert(name, result, generation);
+    }
+    return result;
 }
 
-bool VFileSystem::findMountPoint(const std::filesystem::path& path,
-                                 std::filesystem::path*       pRelativePath,
-                                 IFileSystem**                ppFS) const
+bool VFileSystem::getContentHash(const std::filesystem::path& name, uint64_t* outHash)
+{
+    FileStat stat = getFileStat(name);
+    if (!stat.isFile())
+        return false;
+
+    if (findContentHash(name, stat, outHash))
+        return true;
+
+    std::filesystem::path relativePath;
+    IFileSystem*          fs = nullptr;
+
+    if (!findMountPoint(name, &relativePath, &fs, true) || !fs->getContentHash(relativePath, outHash))
+        return false;
+
+    recordContentHash(name, stat, *outHash);
+    return true;
+}
+
+std::vector<FileStat> VFileSystem::getFileStats(const std::vector<std::filesystem::path>& names)
 {
-    std::string spath = path.lexically_normal().generic_string();
+    struct MountBatch
+    {
+        std::vector<std::filesystem::path> paths;
+        std::vector<size_t>                indices; // index of each path in 'names'
+    };
+
+    invalidateCompletedWrites();
 
-    for (auto mp : mountPoints_)
+    const uint64_t generation = statCache_.getGeneration();
+
+    std::vector<FileStat>                        results(names.size());
+    std::vector<bool>                            cached(names.size());
+    std::unordered_map<IFileSystem*, MountBatch> batches;
+    std::vector<MountTable::Match>               layers;
+    std::filesystem::path                        resolvedPath;
+
+    for (size_t index = 0; index < names.size(); ++index)
     {
-        if (spath.find(mp.first, 0) == 0 &&
-            ((spath.length() == mp.first.length()) || (spath[mp.first.length()] == '/')))
+        cached[index] = isWatched(names[index]);
+        if (cached[index] && statCache_.find(names[index], &results[index]))
+            continue;
+
+        if (!findLayers(names[index], &layers, &resolvedPath))
         {
-            if (pRelativePath)
+            if (cached[index])
             {
-                std::string relative = spath.substr(mp.first.size() + 1);
-                *pRelativePath       = relative;
+                statCache_.insert(names[index], results[index], generation);
             }
+        }
+        else if (layers.size() > 1)
+        {
+            results[index] = getFileStat(names[index]);
+        }
+        else
+        {
+            // the misses under a single layer are looked up with one call per file system
+            MountBatch& batch = batches[layers[0].fs];
+            batch.paths.emplace_back(resolvedPath.native().substr(layers[0].relativeOffset));
+            batch.indices.push_back(index);
+        }
+    }
+
+    for (auto& [fs, batch] : batches)
+    {
+        std::vector<FileStat> stats = fs->getFileStats(batch.paths);
+
+        for (size_t i = 0; i < batch.indices.size() && i < stats.size(); ++i)
+        {
+            const size_t index = batch.indices[i];
 
-            if (ppFS)
+            results[index] = stats[i];
+            if (cached[index])
             {
-                *ppFS = mp.second.get();
+                statCache_.insert(names[index], stats[i], generation);
             }
-            return true;
         }
     }
 
-    return false;
+    return results;
 }
 
-bool VFileSystem::isFolderExists(const std::filesystem::path& name)
+std::filesystem::path VFileSystem::getFullPath(const std::filesystem::path& name) const
 {
     std::filesystem::path relativePath;
     IFileSystem*          fs = nullptr;
 
-    if (findMountPoint(name, &relativePath, &fs))
+    if (findMountPoint(name, &relativePath, &fs, true))
     {
-        return fs->isFolderExists(relativePath);
+        return fs->getFullPath(relativePath);
     }
 
-    return false;
+    return name;
 }
 
-bool VFileSystem::isFileExists(const std::filesystem::path& name)
+std::shared_ptr<IBlob> VFileSystem::readFile(const std::filesystem::path& name)
 {
     std::filesystem::path relativePath;
     IFileSystem*          fs = nullptr;
 
-    if (findMountPoint(name, &relativePath, &fs))
+    if (!findMountPoint(name, &relativePath, &fs, true))
+        return nullptr;
+
+    std::shared_ptr<IBlob> blob = fs->readFile(relativePath);
+
+    if (blob && hashOnRead_.load(std::memory_order_relaxed))
     {
-        return fs->isFileExists(relativePath);
+        FileStat stat  = getFileStat(name);
+        uint64_t known = 0;
+
+        if (stat.isFile() && stat.size == blob->size() && !findContentHash(name, stat, &known))
+        {
+            recordContentHash(name, stat, hash::xxh3(blob->data(), blob->size()));
+        }
     }
 
-    return false;
+    return blob;
 }
 
-std::filesystem::path VFileSystem::getFullPath(const std::filesystem::path& name) const
+std::shared_ptr<IBlob> VFileSystem::readRange(const std::filesystem::path& name, uint64_t offset, size_t size)
 {
     std::filesystem::path relativePath;
     IFileSystem*          fs = nullptr;
 
-    if (findMountPoint(name, &relativePath, &fs))
+    if (findMountPoint(name, &relativePath, &fs, true))
     {
-        auto fullPath = fs->getFullPath(relativePath);
-        return fs->getFullPath(relativePath);
+        return fs->readRange(relativePath, offset, size);
     }
 
-    return name;
+    return nullptr;
 }
 
-std::shared_ptr<IBlob> VFileSystem::readFile(const std::filesystem::path& name)
+std::unique_ptr<IFileStream> VFileSystem::openStream(const std::filesystem::path& name)
 {
     std::filesystem::path relativePath;
     IFileSystem*          fs = nullptr;
 
-    if (findMountPoint(name, &relativePath, &fs))
+    if (findMountPoint(name, &relativePath, &fs, true))
+    {
+        return fs->openStream(relativePath);
+    }
+
+    return nullptr;
+}
+
+int64_t VFileSystem::readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset)
+{
+    std::filesystem::path relativePath;
+    IFileSystem*          fs = nullptr;
+
+    if (findMountPoint(name, &relativePath, &fs, true))
+    {
+        return fs->readFileInto(relativePath, buffer, size, offset);
+    }
+
+    return static_cast<int64_t>(Status::PathNotFound);
+}
+
+std::shared_ptr<IBlob> VFileSystem::readFileWithAllocator(const std::filesystem::path&    name,
+                                                          std::shared_ptr<IBlobAllocator> allocator)
+{
+    std::filesystem::path relativePath;
+    IFileSystem*          fs = nullptr;
+
+    if (findMountPoint(name, &relativePath, &fs, true))
     {
-        return fs->readFile(name);
+        return fs->readFileWithAllocator(relativePath, std::move(allocator));
     }
 
     return nullptr;
@@ -375,91 +2224,249 @@ bool VFileSystem::writeFile(const std::filesystem::path& name, const void* data,
 
     if (findMountPoint(name, &relativePath, &fs))
     {
-        return fs->writeFile(name, data, size);
+        // the file is now in the top layer
+        bool written = fs->writeFile(relativePath, data, size);
+        invalidateMetadata(name);
+
+        // the data is at hand, hashing it now saves reading the file back for getContentHash
+        if (written)
+        {
+            FileStat stat = getFileStat(name);
+            if (stat.isFile() && stat.size == size)
+            {
+                recordContentHash(name, stat, hash::xxh3(data, size));
+            }
+        }
+
+        return written;
     }
 
     return false;
 }
 
-int VFileSystem::enumerateFiles(const std::filesystem::path&    path,
-                                const std::vector<std::string>& extensions,
-                                enumerate_callback_t            callback,
-                                bool                            allowDuplicates)
+write_future_t VFileSystem::submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
 {
     std::filesystem::path relativePath;
     IFileSystem*          fs = nullptr;
 
-    if (findMountPoint(path, &relativePath, &fs))
+    if (findMountPoint(name, &relativePath, &fs))
     {
-        return fs->enumerateFiles(path, extensions, callback, allowDuplicates);
+        invalidateMetadata(name);
+        write_future_t future = fs->submitWrite(relativePath, std::move(data));
+
+        std::lock_guard<std::mutex> lock(pendingWriteMutex_);
+        pendingWrites_.emplace_back(name, future);
+        hasPendingWrites_.store(true, std::memory_order_release);
+        return future;
     }
 
-    return static_cast<int>(Status::PathNotFound);
+    return makeReadyWriteFuture(false);
 }
 
-int VFileSystem::enumerateDirectories(const std::filesystem::path& path,
-                                      enumerate_callback_t         callback,
-                                      bool                         allowDuplicates)
+void VFileSystem::submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback)
 {
-    std::filesystem::path relativePath;
-    IFileSystem*          fs = nullptr;
+    struct MountBatch
+    {
+        std::vector<ReadRequest> requests;
+        std::vector<size_t>      indices; // index of each request in the original batch
+    };
+
+    auto sharedCallback = std::make_shared<read_callback_t>(std::move(callback));
 
-    if (findMountPoint(path, &relativePath, &fs))
+    std::unordered_map<IFileSystem*, MountBatch> batches;
+
+    for (size_t index = 0; index < requests.size(); ++index)
     {
-        return fs->enumerateDirectories(path, callback, allowDuplicates);
+        std::filesystem::path relativePath;
+        IFileSystem*          fs = nullptr;
+
+        if (findMountPoint(requests[index].path, &relativePath, &fs, true))
+        {
+            MountBatch& batch = batches[fs];
+            batch.requests.push_back({relativePath, requests[index].offset, requests[index].size});
+            batch.indices.push_back(index);
+        }
+        else
+        {
+            // reported from an I/O thread like the other requests
+            ThreadPool::getIoPool().post([sharedCallback, index]() { (*sharedCallback)(index, nullptr); });
+        }
     }
 
-    return static_cast<int>(Status::PathNotFound);
+    for (auto& [fs, batch] : batches)
+    {
+        fs->submitReads(batch.requests,
+                        [sharedCallback, indices = std::move(batch.indices)](size_t index, std::shared_ptr<IBlob> blob) {
+                            (*sharedCallback)(indices[index], std::move(blob));
+                        });
+    }
 }
 
-static void appendPatternToRegex(const std::string& pattern, std::stringstream& regex)
+template<typename F>
+int VFileSystem::enumerateLayers(const std::filesystem::path& path,
+                                 bool                         allowDuplicates,
+                                 enumerate_callback_t         callback,
+                                 F&&                          enumerate)
 {
-    for (char c : pattern)
+    std::vector<MountTable::Match> layers;
+    std::filesystem::path          resolvedPath;
+
+    if (!findLayers(path, &layers, &resolvedPath))
+        return static_cast<int>(Status::PathNotFound);
+
+    if (layers.size() == 1)
+        return enumerate(layers[0].fs, resolvedPath.native().substr(layers[0].relativeOffset), callback);
+
+    // unless duplicates are allowed, a name found in a layer hides the same name in the layers below
+    std::unordered_set<std::string> names;
+    int                             found  = 0;
+    int                             status = static_cast<int>(Status::PathNotFound);
+
+    auto merge = [&](std::string_view name) {
+        if (allowDuplicates || names.emplace(name).second)
+        {
+            ++found;
+            callback(name);
+        }
+    };
+
+    for (const auto& layer : layers)
     {
-        switch (c)
+        int result = enumerate(layer.fs, resolvedPath.native().substr(layer.relativeOffset), merge);
+        if (result >= 0)
         {
-            case '?':
-                regex << "[^/]?";
-                break;
-            case '*':
-                regex << "[^/]+";
-                break;
-            case '.':
-                regex << "\\.";
-                break;
-            default:
-                regex << c;
+            status = 0;
         }
     }
+
+    return status < 0 ? status : found;
+}
+
+int VFileSystem::enumerateFiles(const std::filesystem::path&    path,
+                                const std::vector<std::string>& extensions,
+                                enumerate_callback_t            callback,
+                                bool                            allowDuplicates)
+{
+    return enumerateLayers(path,
+                           allowDuplicates,
+                           callback,
+                           [&](IFileSystem* fs, const std::filesystem::path& relativePath, enumerate_callback_t cb) {
+                               return fs->enumerateFiles(relativePath, extensions, cb, allowDuplicates);
+                           });
+}
+
+int VFileSystem::enumerateDirectories(const std::filesystem::path& path,
+                                      enumerate_callback_t         callback,
+                                      bool                         allowDuplicates)
+{
+    return enumerateLayers(path,
+                           allowDuplicates,
+                           callback,
+                           [&](IFileSystem* fs, const std::filesystem::path& relativePath, enumerate_callback_t cb) {
+                               return fs->enumerateDirectories(relativePath, cb, allowDuplicates);
+                           });
 }
 
-std::string muggle::vfs::getFileSearchRegex(const std::filesystem::path&    path,
-                                            const std::vector<std::string>& extensions)
+int VFileSystem::enumerateFilesRecursive(const std::filesystem::path&    path,
+                                         const std::vector<std::string>& extensions,
+                                         enumerate_callback_t            callback,
+                                         bool                            allowDuplicates)
 {
-    std::filesystem::path normalizedPath    = path.lexically_normal();
-    std::string           normalizedPathStr = normalizedPath.generic_string();
+    return enumerateLayers(path,
+                           allowDuplicates,
+                           callback,
+                           [&](IFileSystem* fs, const std::filesystem::path& relativePath, enumerate_callback_t cb) {
+                               return fs->enumerateFilesRecursive(relativePath, extensions, cb, allowDuplicates);
+                           });
+}
+
+watch_id_t VFileSystem::addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive)
+{
+    std::vector<MountTable::Match> layers;
+    std::filesystem::path          resolvedPath;
+
+    if (!findLayers(path, &layers, &resolvedPath))
+        return kInvalidWatchId;
+
+    auto sharedCallback = std::make_shared<watch_callback_t>(std::move(callback));
+    auto virtualPath    = path.lexically_normal();
+
+    std::vector<fs_watch_t> fsWatches;
+    for (const auto& layer : layers)
+    {
+        std::filesystem::path relativePath = resolvedPath.native().substr(layer.relativeOffset);
+
+        auto translate = [this, relativePath, virtualPath, sharedCallback](const std::vector<FileChange>& changes) {
+            std::vector<FileChange> translated;
+            translated.reserve(changes.size());
+            for (const auto& change : changes)
+            {
+                translated.push_back({rebaseChangedPath(change.path, relativePath, virtualPath), change.type});
+
+                // a file added or removed in any layer may change the layer that holds it
+                if (change.type == FileChange::Type::Overflow)
+                {
+                    clearMetadataCache();
+                }
+                else
+                {
+                    invalidateMetadata(translated.back().path, change.type == FileChange::Type::Removed);
+                }
+            }
+            (*sharedCallback)(translated);
+        };
+
+        watch_id_t fsWatchId = layer.fs->addWatch(relativePath, std::move(translate), recursive);
+        if (fsWatchId != kInvalidWatchId)
+        {
+            fsWatches.push_back({layer.fs, fsWatchId});
+        }
+    }
+
+    if (fsWatches.empty())
+        return kInvalidWatchId;
 
-    std::stringstream regex;
-    appendPatternToRegex(normalizedPathStr, regex);
-    if (!muggle::string_utils::ends_with(normalizedPathStr, "/") && !normalizedPath.empty())
-        regex << '/';
-    regex << "[^/]+";
+    const bool allLayersWatched = fsWatches.size() == layers.size();
 
-    if (!extensions.empty())
+    std::lock_guard<std::mutex> lock(watchMutex_);
+    watch_id_t                  id = nextWatchId_++;
+    watches_[id]                   = std::move(fsWatches);
+
+    if (allLayersWatched)
     {
-        regex << '(';
-        bool first = true;
-        for (const auto& ext : extensions)
+        const auto watchKey = StatCache::getKey(virtualPath);
+
+        std::unique_lock<std::shared_mutex> watchedLock(watchedPathMutex_);
+
+        // the file systems mounted under the path are not watched
+        const bool hasNestedMounts = std::any_of(mountKeys_.begin(), mountKeys_.end(), [&watchKey](const auto& key) {
+            return key != watchKey && isSameOrUnder(key, watchKey);
+        });
+        if (!hasNestedMounts)
         {
-            if (!first)
-                regex << '|';
-            appendPatternToRegex(ext, regex);
-            first = false;
+            watchedPaths_.push_back({watchKey, recursive, id});
+            hasWatchedPaths_.store(true, std::memory_order_release);
         }
-        regex << ')';
     }
+    return id;
+}
+
+bool VFileSystem::removeWatch(watch_id_t id)
+{
+    std::lock_guard<std::mutex> lock(watchMutex_);
+
+    auto it = watches_.find(id);
+    if (it == watches_.end())
+        return false;
+
+    for (const auto& [fs, fsWatchId] : it->second)
+    {
+        fs->removeWatch(fsWatchId);
+    }
+    watches_.erase(it);
 
-    return regex.str();
+    forgetWatchedPath(id);
+    return true;
 }
 
 std::filesystem::path muggle::vfs::getCurrentProcessDirectory()
@@ -476,5 +2483,6 @@ std::filesystem::path muggle::vfs::getCurrentProcessDirectory()
         buf[len] = '\0';
         return std::filesystem::path(buf).parent_path();
     }
+    return {};
 #endif
 }
\ No newline at end of file
@@ -1,9 +1,18 @@
 #pragma once
 
+#include "foundation/filesystem/mount_table.h"
+#include "foundation/filesystem/stat_cache.h"
+
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace muggle
@@ -47,6 +56,116 @@ private:
     size_t size_ = 0;
 };
 
+// A range of another blob, which it keeps alive, so that parts of a file can be handed out without copying.
+// Slicing a view references the original blob directly instead of chaining views.
+class BlobView : public IBlob {
+public:
+    // 'offset' and 'size' must be within 'parent'
+    BlobView(std::shared_ptr<IBlob> parent, size_t offset, size_t size);
+
+    [[nodiscard]] const void* data() const override;
+    [[nodiscard]] size_t      size() const override;
+
+    [[nodiscard]] const std::shared_ptr<IBlob>& getParent() const
+    {
+        return parent_;
+    }
+
+    // Offset of the view in its parent
+    [[nodiscard]] size_t getOffset() const
+    {
+        return offset_;
+    }
+
+    // A view of 'size' bytes of 'blob' starting at 'offset'; size 0 means up to the end.
+    // Returns nullptr if the range is out of bounds.
+    static std::shared_ptr<BlobView> slice(const std::shared_ptr<IBlob>& blob, size_t offset, size_t size = 0);
+
+private:
+    std::shared_ptr<IBlob> parent_;
+    size_t                 offset_ = 0;
+    size_t                 size_   = 0;
+};
+
+// Blob implementation backed by a read-only memory mapping of a file.
+// Pages are faulted in lazily by the OS and are shared with every other process mapping the same file,
+// so no copy of the file contents is ever made. The file must not be truncated while the blob is alive.
+class MappedBlob : public IBlob {
+public:
+    enum class AccessHint
+    {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed
+    };
+
+    // Takes ownership of a mapping of 'size' bytes starting at 'mapping'
+    MappedBlob(void* mapping, size_t size);
+
+    // Takes ownership of a mapping of 'mappingSize' bytes, exposing only 'size' bytes from 'offset' on.
+    // Used when the requested range does not start on an allocation granularity boundary.
+    MappedBlob(void* mapping, size_t mappingSize, size_t offset, size_t size);
+    ~MappedBlob() override;
+
+    MappedBlob(const MappedBlob&)            = delete;
+    MappedBlob& operator=(const MappedBlob&) = delete;
+
+    [[nodiscard]] const void* data() const override;
+    [[nodiscard]] size_t      size() const override;
+
+    // Tell the OS how the given range is going to be accessed. Ignored where unsupported.
+    void advise(AccessHint hint, size_t offset = 0, size_t size = SIZE_MAX) const;
+
+    // Map the whole file read-only.
+    // Returns nullptr if the file cannot be opened or mapped, or if it is empty
+    static std::shared_ptr<MappedBlob> mapFile(const std::filesystem::path& name,
+                                               AccessHint                   hint = AccessHint::Sequential);
+
+private:
+    void*       mapping_     = nullptr;
+    size_t      mappingSize_ = 0;
+    const char* data_        = nullptr;
+    size_t      size_        = 0;
+};
+
+// Provides the memory of blobs, so that file data can be read straight into its final home,
+// e.g. GPU staging memory, a frame arena or buffers aligned for direct I/O. Must be thread safe.
+class IBlobAllocator {
+public:
+    virtual ~IBlobAllocator() = default;
+
+    // Returns nullptr if the memory cannot be allocated. 'alignment' is a power of two.
+    virtual void* allocate(size_t size, size_t alignment) = 0;
+    virtual void  deallocate(void* data, size_t size)     = 0;
+};
+
+// Heap allocations with any alignment
+class AlignedBlobAllocator : public IBlobAllocator {
+public:
+    void* allocate(size_t size, size_t alignment) override;
+    void  deallocate(void* data, size_t size) override;
+
+    static std::shared_ptr<AlignedBlobAllocator> getInstance();
+};
+
+// Blob implementation owning memory from an IBlobAllocator, and keeping the allocator alive
+class AllocatedBlob : public IBlob {
+public:
+    // 'capacity' bytes were allocated, of which the first 'size' hold the data
+    AllocatedBlob(std::shared_ptr<IBlobAllocator> allocator, void* data, size_t size, size_t capacity);
+    ~AllocatedBlob() override;
+
+    [[nodiscard]] const void* data() const override;
+    [[nodiscard]] size_t      size() const override;
+
+private:
+    std::shared_ptr<IBlobAllocator> allocator_;
+    void*                           data_     = nullptr;
+    size_t                          size_     = 0;
+    size_t                          capacity_ = 0;
+};
+
 using enumerate_callback_t = const std::function<void(std::string_view)>&;
 
 inline std::function<void(std::string_view)> enumerate_to_vector(std::vector<std::string>& v)
@@ -54,6 +173,78 @@ inline std::function<void(std::string_view)> enumerate_to_vector(std::vector<std
     return [&v](std::string_view s) { v.push_back(std::string(s)); };
 }
 
+// Pull-style sequential reader over a file
+class IFileStream {
+public:
+    virtual ~IFileStream() = default;
+
+    // Copy up to 'size' bytes to 'buffer' and advance the read position.
+    // Returns the number of bytes read, 0 at the end of the stream, or a negative number on errors -
+    // see muggle::vfs::Status.
+    virtual int64_t read(void* buffer, size_t size) = 0;
+
+    // Move the read position. Returns false if 'position' is past the end of the stream
+    virtual bool seek(uint64_t position) = 0;
+
+    [[nodiscard]] virtual uint64_t tell() const = 0;
+    [[nodiscard]] virtual uint64_t size() const = 0;
+
+    [[nodiscard]] bool isEnd() const
+    {
+        return tell() >= size();
+    }
+};
+
+// Stream over data that is already in memory
+class BlobFileStream : public IFileStream {
+public:
+    explicit BlobFileStream(std::shared_ptr<IBlob> blob);
+
+    int64_t                read(void* buffer, size_t size) override;
+    bool                   seek(uint64_t position) override;
+    [[nodiscard]] uint64_t tell() const override;
+    [[nodiscard]] uint64_t size() const override;
+
+private:
+    std::shared_ptr<IBlob> blob_;
+    uint64_t               position_ = 0;
+};
+
+// One read of an asynchronous batch.
+// A zero 'size' reads from 'offset' to the end of the file. Ranges past the end of the file fail.
+struct ReadRequest
+{
+    std::filesystem::path path;
+    uint64_t              offset = 0;
+    size_t                size   = 0;
+};
+
+// Receives the index of a request in its batch and the data read, or nullptr if the read failed
+using read_callback_t = std::function<void(size_t index, std::shared_ptr<IBlob> blob)>;
+
+// Becomes true once an asynchronous write is complete, or false if it failed
+using write_future_t = std::shared_future<bool>;
+
+// A change to a watched file, with its path in the namespace of the file system that was watched
+struct FileChange
+{
+    enum class Type
+    {
+        Added,
+        Modified,
+        Removed,
+        Overflow // changes were lost, anything under 'path', the watched path, may have changed
+    };
+
+    std::filesystem::path path;
+    Type                  type;
+};
+
+using watch_id_t       = uint64_t;
+using watch_callback_t = std::function<void(const std::vector<FileChange>& changes)>;
+
+static constexpr watch_id_t kInvalidWatchId = 0;
+
 // Basic interface for the virtual file system
 class IFileSystem {
 public:
@@ -61,22 +252,84 @@ public:
 
     virtual std::filesystem::path getFullPath(const std::filesystem::path& name) const = 0;
 
+    // True if the files never change, so that what is known about them can be remembered without watching them.
+    // The default implementation returns false.
+    virtual bool isImmutable() const;
+
     // Test if a folder exists
     virtual bool isFolderExists(const std::filesystem::path& name) = 0;
 
     // Test if a file exists
     virtual bool isFileExists(const std::filesystem::path& name) = 0;
 
+    // Get the type, size and modification time of 'name'; the type is FileStat::Type::None if it does not exist.
+    // The default implementation only finds the type, with isFileExists and isFolderExists.
+    virtual FileStat getFileStat(const std::filesystem::path& name);
+
+    // Same as getFileStat for each of 'names', in order, so that a whole list of files can be checked at once.
+    // The default implementation calls getFileStat for each of them.
+    virtual std::vector<FileStat> getFileStats(const std::vector<std::filesystem::path>& names);
+
+    // Get the muggle::hash::xxh3 of the contents of the file, so that unchanged or identical files can be
+    // recognized without comparing them. Returns false if the file cannot be read.
+    // The default implementation reads the entire file and hashes it.
+    virtual bool getContentHash(const std::filesystem::path& name, uint64_t* outHash);
+
     // Read the entire file.
     // Returns nullptr if the file cannot be read
     virtual std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) = 0;
 
+    // Read 'size' bytes of the file starting at 'offset'. A zero 'size' reads to the end of the file.
+    // Returns nullptr if the file cannot be read or the range is out of bounds.
+    // The default implementation reads the entire file and returns a BlobView of the range.
+    virtual std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size);
+
+    // Open the file for sequential reading.
+    // Returns nullptr if the file cannot be opened.
+    // The default implementation reads the entire file up front.
+    virtual std::unique_ptr<IFileStream> openStream(const std::filesystem::path& name);
+
+    // Read up to 'size' bytes of the file, starting at 'offset', into 'buffer'.
+    // Returns the number of bytes read, or a negative number on errors - see muggle::vfs::Status.
+    // The default implementation reads through openStream.
+    virtual int64_t readFileInto(const std::filesystem::path& name, void* buffer, size_t size, uint64_t offset = 0);
+
+    // Read the entire file into memory provided by 'allocator'.
+    // Returns nullptr if the file cannot be read or the memory cannot be allocated.
+    // The default implementation reads through openStream.
+    virtual std::shared_ptr<IBlob> readFileWithAllocator(const std::filesystem::path&    name,
+                                                         std::shared_ptr<IBlobAllocator> allocator);
+
     // Write the entire file
     // Returns false if the file cannot be written
     virtual bool writeFile(const std::filesystem::path& name, const void* data, size_t size) = 0;
 
+    // Queue writing the entire file and return immediately. 'data' must not change until the write completes.
+    // Wait on the returned future only when the data has to be safely stored, e.g. before exiting.
+    // Until then, reads of the file may return its previous contents, and a synchronous writeFile
+    // of the same file may be overwritten. The default implementation runs writeFile on the I/O thread pool.
+    virtual write_future_t submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data);
+
+    // Same as submitWrite
+    write_future_t writeFileAsync(const std::filesystem::path& name, std::shared_ptr<IBlob> data)
+    {
+        return submitWrite(name, std::move(data));
+    }
+
+    // Same as submitWrite, with a copy of 'data'
+    write_future_t writeFileAsync(const std::filesystem::path& name, const void* data, size_t size);
+
+    // Start reading a batch of files or file ranges and return immediately.
+    // 'callback' is invoked exactly once per request, in no particular order, from an I/O thread,
+    // so it must be thread safe and should not block. The file system must outlive the batch.
+    // The default implementation runs readFile on the shared I/O thread pool.
+    virtual void submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback);
+
+    // Same as submitReads, but returns one future per request instead of invoking a callback
+    std::vector<std::future<std::shared_ptr<IBlob>>> readFilesAsync(const std::vector<ReadRequest>& requests);
+
     // Search for files with any of the provided 'extensions' in 'path'.
-    // Extensions should not include any wildcard characters.
+    // Extensions may contain the wildcards '*' and '?', see muggle::vfs::FilePattern.
     // Returns the number of files found, or a negative number on errors - see muggle::vfs::Status.
     // The file names, relative to the 'path', are passed to 'callback' in no particular order.
     virtual int enumerateFiles(const std::filesystem::path&    path,
@@ -90,11 +343,62 @@ public:
     virtual int enumerateDirectories(const std::filesystem::path& path,
                                      enumerate_callback_t         callback,
                                      bool                         allowDuplicates = false) = 0;
+
+    // Search for files with any of the provided 'extensions' in 'path' and all of its subdirectories.
+    // Returns the number of files found, or a negative number on errors - see muggle::vfs::Status.
+    // The file paths, relative to 'path' and with '/' separators, are passed to 'callback' in no particular order.
+    // The default implementation walks the tree with enumerateFiles and enumerateDirectories.
+    virtual int enumerateFilesRecursive(const std::filesystem::path&    path,
+                                        const std::vector<std::string>& extensions,
+                                        enumerate_callback_t            callback,
+                                        bool                            allowDuplicates = false);
+
+    // Get notified when the file 'path', or the files in the directory 'path', change.
+    // Bursts of events are coalesced: 'callback' receives each changed file once, after things settle down.
+    // When changes were lost, a FileChange::Type::Overflow change for 'path' is reported instead of them.
+    // A directory removed or renamed away is reported as a Removed change of the directory.
+    // It runs on a watcher thread. Returns kInvalidWatchId if the file system does not support watching
+    // or 'path' cannot be watched.
+    virtual watch_id_t addWatch(const std::filesystem::path& path, watch_callback_t callback, bool recursive = true);
+
+    // Stop a watch. A notification already being delivered may still complete after this returns.
+    virtual bool removeWatch(watch_id_t id);
 };
 
 // An implementation of virtual file system that directly maps to the OS files
 class NativeFileSystem : public IFileSystem {
 public:
+    // Files of at least this many bytes are returned by readFile as a MappedBlob instead of being copied.
+    // Small files are cheaper to read than to map. Pass SIZE_MAX to always copy.
+    static constexpr size_t kDefaultMappingThreshold = 64 * 1024;
+
+    void setMappingThreshold(size_t bytes)
+    {
+        mappingThreshold_ = bytes;
+    }
+
+    [[nodiscard]] size_t getMappingThreshold() const
+    {
+        return mappingThreshold_;
+    }
+
+    // readFileInto and readFileWithAllocator bypass the page cache with O_DIRECT for reads of at least
+    // this many bytes, where supported. Large assets read once are not worth caching, and reading them
+    // directly into their destination saves a copy. Pass SIZE_MAX to always go through the page cache.
+    static constexpr size_t kDefaultDirectIoThreshold = 8 * 1024 * 1024;
+
+    // O_DIRECT transfers need buffers, offsets and sizes aligned to this
+    static constexpr size_t kDirectIoAlignment = 4096;
+
+    void setDirectIoThreshold(size_t bytes)
+    {
+        directIoThreshold_ = bytes;
+    }
+
+    [[nodiscard]] size_t getDirectIoThreshold() const
+    {
+        return directIoThreshold_;
+    }
 
     std::filesystem::path getFullPath(const std::filesystem::path& name) const override
     {
@@ -103,8 +407,19 @@ public:
 
     bool                   isFolderExists(const std::filesystem::path& name) override;
     bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
     std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    std::unique_ptr<IFileStream> openStream(const std::filesystem::path& name) override;
+    int64_t                readFileInto(const std::filesystem::path& name,
+                                        void*                        buffer,
+                                        size_t                       size,
+                                        uint64_t                     offset /* = 0 */) override;
+    std::shared_ptr<IBlob> readFileWithAllocator(const std::filesystem::path&    name,
+                                                 std::shared_ptr<IBlobAllocator> allocator) override;
     bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    write_future_t         submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data) override;
+    void                   submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback) override;
     int                    enumerateFiles(const std::filesystem::path&    path,
                                           const std::vector<std::string>& extensions,
                                           enumerate_callback_t            callback,
@@ -112,6 +427,22 @@ public:
     int                    enumerateDirectories(const std::filesystem::path& path,
                                                 enumerate_callback_t         callback,
                                                 bool                         allowDuplicates /* = false */) override;
+    int                    enumerateFilesRecursive(const std::filesystem::path&    path,
+                                                   const std::vector<std::string>& extensions,
+                                                   enumerate_callback_t            callback,
+                                                   bool allowDuplicates /* = false */) override;
+    watch_id_t             addWatch(const std::filesystem::path& path,
+                                    watch_callback_t             callback,
+                                    bool                         recursive /* = true */) override;
+    bool                   removeWatch(watch_id_t id) override;
+
+private:
+#ifdef WIN32
+    size_t mappingThreshold_ = SIZE_MAX;
+#else
+    size_t mappingThreshold_ = kDefaultMappingThreshold;
+#endif
+    size_t directIoThreshold_ = kDefaultDirectIoThreshold;
 };
 
 // A layer that represents some path in the underlying file system as an entire FS.
@@ -131,10 +462,28 @@ public:
         return basePath_ / name.relative_path();
     }
 
+    bool isImmutable() const override
+    {
+        return underlyingFS_->isImmutable();
+    }
+
     bool                   isFolderExists(const std::filesystem::path& name) override;
     bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::vector<FileStat>  getFileStats(const std::vector<std::filesystem::path>& names) override;
+    bool                   getContentHash(const std::filesystem::path& name, uint64_t* outHash) override;
     std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    std::unique_ptr<IFileStream> openStream(const std::filesystem::path& name) override;
+    int64_t                readFileInto(const std::filesystem::path& name,
+                                        void*                        buffer,
+                                        size_t                       size,
+                                        uint64_t                     offset /* = 0 */) override;
+    std::shared_ptr<IBlob> readFileWithAllocator(const std::filesystem::path&    name,
+                                                 std::shared_ptr<IBlobAllocator> allocator) override;
     bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    write_future_t         submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data) override;
+    void                   submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback) override;
     int                    enumerateFiles(const std::filesystem::path&    path,
                                           const std::vector<std::string>& extensions,
                                           enumerate_callback_t            callback,
@@ -142,6 +491,14 @@ public:
     int                    enumerateDirectories(const std::filesystem::path& path,
                                                 enumerate_callback_t         callback,
                                                 bool                         allowDuplicates /* = false */) override;
+    int                    enumerateFilesRecursive(const std::filesystem::path&    path,
+                                                   const std::vector<std::string>& extensions,
+                                                   enumerate_callback_t            callback,
+                                                   bool allowDuplicates /* = false */) override;
+    watch_id_t             addWatch(const std::filesystem::path& path,
+                                    watch_callback_t             callback,
+                                    bool                         recursive /* = true */) override;
+    bool                   removeWatch(watch_id_t id) override;
 
 private:
     std::shared_ptr<IFileSystem> underlyingFS_;
@@ -150,18 +507,50 @@ private:
 
 // A virtual file system that allows mounting, or attaching, other VFS objects to paths.
 // Does not have any file systems by default, all of them must be mounted first.
+// File systems mounted at the same or nested paths are overlaid: a file is read from the layer with the highest
+// priority that contains it, then from the deepest mount point, then from the most recently mounted one.
+// Writes go to the top layer, and enumerations merge all layers.
+// Which layer holds a file and the content hashes of files are cached, and so are the stats of the paths under a
+// watch added through this VFS and covering every layer; changes to the layers made outside of this VFS, and not
+// reported by such a watch, are not seen until clearMetadataCache is called.
 class VFileSystem : public IFileSystem {
 public:
     std::filesystem::path getFullPath(const std::filesystem::path& name) const;
 
-    void mount(const std::filesystem::path& path, std::shared_ptr<IFileSystem> fs);
-    void mount(const std::filesystem::path& path, const std::filesystem::path& nativePath);
+    void mount(const std::filesystem::path& path, std::shared_ptr<IFileSystem> fs, int priority = 0);
+    void mount(const std::filesystem::path& path, const std::filesystem::path& nativePath, int priority = 0);
+
+    // Unmount every file system mounted at exactly 'path', or only 'fs'
     bool unmount(const std::filesystem::path& path);
+    bool unmount(const std::filesystem::path& path, const std::shared_ptr<IFileSystem>& fs);
+
+    // Forget which layers hold the files, their stats and content hashes
+    void clearMetadataCache();
+
+    // Also hash the files read with readFile, so that a later getContentHash of them is free.
+    // Off by default: most reads never need the hash, and hashing a mapped file pulls all of it in.
+    void setHashOnRead(bool enable)
+    {
+        hashOnRead_ = enable;
+    }
 
     bool                   isFolderExists(const std::filesystem::path& name) override;
     bool                   isFileExists(const std::filesystem::path& name) override;
+    FileStat               getFileStat(const std::filesystem::path& name) override;
+    std::vector<FileStat>  getFileStats(const std::vector<std::filesystem::path>& names) override;
+    bool                   getContentHash(const std::filesystem::path& name, uint64_t* outHash) override;
     std::shared_ptr<IBlob> readFile(const std::filesystem::path& name) override;
+    std::shared_ptr<IBlob> readRange(const std::filesystem::path& name, uint64_t offset, size_t size) override;
+    std::unique_ptr<IFileStream> openStream(const std::filesystem::path& name) override;
+    int64_t                readFileInto(const std::filesystem::path& name,
+                                        void*                        buffer,
+                                        size_t                       size,
+                                        uint64_t                     offset /* = 0 */) override;
+    std::shared_ptr<IBlob> readFileWithAllocator(const std::filesystem::path&    name,
+                                                 std::shared_ptr<IBlobAllocator> allocator) override;
     bool                   writeFile(const std::filesystem::path& name, const void* data, size_t size) override;
+    write_future_t         submitWrite(const std::filesystem::path& name, std::shared_ptr<IBlob> data) override;
+    void                   submitReads(const std::vector<ReadRequest>& requests, read_callback_t callback) override;
     int                    enumerateFiles(const std::filesystem::path&    path,
                                           const std::vector<std::string>& extensions,
                                           enumerate_callback_t            callback,
@@ -169,15 +558,93 @@ public:
     int                    enumerateDirectories(const std::filesystem::path& path,
                                                 enumerate_callback_t         callback,
                                                 bool                         allowDuplicates /* = false */) override;
+    int                    enumerateFilesRecursive(const std::filesystem::path&    path,
+                                                   const std::vector<std::string>& extensions,
+                                                   enumerate_callback_t            callback,
+                                                   bool allowDuplicates /* = false */) override;
+    // Watches every layer containing 'path'. Remove the watch before destroying the VFS.
+    watch_id_t             addWatch(const std::filesystem::path& path,
+                                    watch_callback_t             callback,
+                                    bool                         recursive /* = true */) override;
+    bool                   removeWatch(watch_id_t id) override;
 
 private:
-    bool findMountPoint(const std::filesystem::path& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS) const;
-
-    std::vector<std::pair<std::string, std::shared_ptr<IFileSystem>>> mountPoints_;
+    using fs_watch_t = std::pair<IFileSystem*, watch_id_t>;
+
+    // Find the top layer containing 'path', or with 'resolveFile' the layer that holds the file 'path',
+    // which is the top layer if none does
+    bool findMountPoint(const std::filesystem::path& path,
+                        std::filesystem::path*       pRelativePath,
+                        IFileSystem**                ppFS,
+                        bool                         resolveFile = false) const;
+    bool findLayers(const std::filesystem::path&    path,
+                    std::vector<MountTable::Match>* pLayers,
+                    std::filesystem::path*          pResolvedPath) const;
+
+    MountTable::Match resolveLayer(std::filesystem::path::string_type path) const;
+    bool              findContentHash(const std::filesystem::path& name, const FileStat& stat, uint64_t* outHash) const;
+    void              recordContentHash(const std::filesystem::path& name, const FileStat& stat, uint64_t hash) const;
+    // With 'tree', also the metadata of everything under 'name'
+    void              invalidateMetadata(const std::filesystem::path& name, bool tree = false) const;
+    bool              isWatched(const std::filesystem::path& name) const;
+    void              forgetWatchedPath(watch_id_t id);
+    void              invalidateCompletedWrites() const;
+    void              removeWatchesLocked(const std::vector<IFileSystem*>& fileSystems);
+
+    template<typename F>
+    int enumerateLayers(const std::filesystem::path& path,
+                        bool                         allowDuplicates,
+                        enumerate_callback_t         callback,
+                        F&&                          enumerate);
+
+    static constexpr size_t kMaxResolvedFiles = 64 * 1024;
+    static constexpr size_t kMaxContentHashes = 64 * 1024;
+
+    MountTable mountTable_;
+
+    // layer holding each file by normalized path, for the paths covered by several layers, when it cannot change
+    // behind the VFS's back: under watched paths, or when that layer and those above it are immutable
+    mutable std::shared_mutex                                                          resolveMutex_;
+    mutable std::unordered_map<std::filesystem::path::string_type, MountTable::Match> resolvedFiles_;
+    mutable uint64_t resolveGeneration_ = 0; // bumped by every invalidation, so that no stale layer is remembered
+
+    mutable StatCache statCache_;
+
+    // content hash of each file, valid as long as the file keeps the size and modification time it had
+    struct ContentHash
+    {
+        FileStat stat;
+        uint64_t hash = 0;
+    };
+
+    mutable std::mutex                                                           contentHashMutex_;
+    mutable std::unordered_map<std::filesystem::path::string_type, ContentHash> contentHashes_;
+    std::atomic<bool>                                                            hashOnRead_ {false};
+
+    // asynchronous writes, the metadata of their files is invalidated again once they complete
+    mutable std::mutex                                                    pendingWriteMutex_;
+    mutable std::vector<std::pair<std::filesystem::path, write_future_t>> pendingWrites_;
+    mutable std::atomic<bool>                                             hasPendingWrites_ {false};
+
+    // watches are forwarded to the mounted file systems, which have their own ids
+    std::mutex                                              watchMutex_;
+    std::unordered_map<watch_id_t, std::vector<fs_watch_t>> watches_;
+    watch_id_t                                              nextWatchId_ = 1;
+
+    // the paths whose changes are reported in every layer, only their stats are cached
+    struct WatchedPath
+    {
+        std::filesystem::path::string_type path; // as a StatCache key
+        bool                               recursive = false;
+        watch_id_t                         id        = kInvalidWatchId;
+    };
+
+    mutable std::shared_mutex                       watchedPathMutex_;
+    std::vector<WatchedPath>                        watchedPaths_;
+    std::atomic<bool>                               hasWatchedPaths_ {false};
+    std::vector<std::filesystem::path::string_type> mountKeys_; // one per mounted file system
 };
 
-std::string getFileSearchRegex(const std::filesystem::path& path, const std::vector<std::string>& extensions);
-
 // utility function to get the path to the executable
 std::filesystem::path getCurrentProcessDirectory();
 
@@ -0,0 +1,324 @@
+#include "foundation/filesystem/write_queue.h"
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unordered_set>
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+extern "C"
+{
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+#endif
+
+using namespace muggle::vfs;
+
+// Files are written in groups of at most this many, to bound the number of open descriptors
+static constexpr size_t kMaxOpenFiles = 64;
+
+static std::filesystem::path makeTemporaryPath(const std::filesystem::path& path)
+{
+    static std::atomic<uint64_t> counter {0};
+
+#ifdef WIN32
+    const unsigned long processId = GetCurrentProcessId();
+#else
+    const long processId = static_cast<long>(getpid());
+#endif
+
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp" + std::to_string(processId) + "_" + std::to_string(counter.fetch_add(1));
+    return temporaryPath;
+}
+
+#ifndef WIN32
+static bool writeAll(int fd, const void* data, size_t size)
+{
+    const char* cursor = static_cast<const char*>(data);
+
+    while (size > 0)
+    {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return true;
+}
+
+// Gives the temporary file the permissions of the file it replaces, which it would otherwise reset
+static bool copyMode(int fd, const std::filesystem::path& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return errno == ENOENT;
+
+    return fchmod(fd, st.st_mode & 07777) == 0;
+}
+
+// Makes a rename in the directory durable
+static void syncDirectory(const std::filesystem::path& directory)
+{
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+#endif
+
+bool WriteQueue::writeAtomically(const std::filesystem::path& path, const void* data, size_t size, bool durable)
+{
+    const std::filesystem::path temporaryPath = makeTemporaryPath(path);
+
+#ifdef WIN32
+    HANDLE file = CreateFileW(
+        temporaryPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Open File: {} Failed!", temporaryPath.string());
+        return false;
+    }
+
+    bool        ok     = true;
+    const char* cursor = static_cast<const char*>(data);
+    while (ok && size > 0)
+    {
+        DWORD chunk   = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        ok            = WriteFile(file, cursor, chunk, &written, nullptr) != 0;
+        cursor += written;
+        size -= written;
+    }
+
+    if (ok && durable)
+    {
+        ok = FlushFileBuffers(file) != 0;
+    }
+    CloseHandle(file);
+
+    const DWORD flags = MOVEFILE_REPLACE_EXISTING | (durable ? MOVEFILE_WRITE_THROUGH : 0);
+    if (!ok || !MoveFileExW(temporaryPath.c_str(), path.c_str(), flags))
+    {
+        DeleteFileW(temporaryPath.c_str());
+        LOG_ERROR("Write File: {} Failed!", path.string());
+        return false;
+    }
+
+    return true;
+#else
+    int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0)
+    {
+        LOG_ERROR("Open File: {} Failed! {}", temporaryPath.string(), strerror(errno));
+        return false;
+    }
+
+    bool ok = copyMode(fd, path) && writeAll(fd, data, size) && (!durable || fdatasync(fd) == 0);
+    ok      = close(fd) == 0 && ok;
+    ok      = ok && rename(temporaryPath.c_str(), path.c_str()) == 0;
+
+    if (!ok)
+    {
+        int error = errno;
+        unlink(temporaryPath.c_str());
+        LOG_ERROR("Write File: {} Failed! {}", path.string(), strerror(error));
+        return false;
+    }
+
+    if (durable)
+    {
+        syncDirectory(path.parent_path());
+    }
+
+    return true;
+#endif
+}
+
+WriteQueue::WriteQueue()
+{
+    thread_ = std::thread([this]() { threadLoop(); });
+}
+
+WriteQueue::~WriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_one();
+
+    thread_.join();
+}
+
+write_future_t WriteQueue::enqueue(const std::filesystem::path& path, std::shared_ptr<IBlob> data)
+{
+    std::string key = path.lexically_normal().generic_string();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = queuedPaths_.find(key);
+    if (it != queuedPaths_.end())
+    {
+        // not written yet, only the latest contents matter
+        PendingWrite& pending = queue_[it->second];
+        pending.data          = std::move(data);
+        return pending.future;
+    }
+
+    PendingWrite pending;
+    pending.path    = path;
+    pending.data    = std::move(data);
+    pending.promise = std::make_shared<std::promise<bool>>();
+    pending.future  = pending.promise->get_future().share();
+
+    queuedPaths_.emplace(std::move(key), queue_.size());
+    queue_.push_back(pending);
+
+    condition_.notify_one();
+
+    return pending.future;
+}
+
+void WriteQueue::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCondition_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+}
+
+void WriteQueue::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;)
+    {
+        condition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+
+        if (queue_.empty())
+            return;
+
+        std::vector<PendingWrite> batch;
+        batch.swap(queue_);
+        queuedPaths_.clear();
+        busy_ = true;
+
+        lock.unlock();
+        for (size_t first = 0; first < batch.size(); first += kMaxOpenFiles)
+        {
+            std::vector<PendingWrite> group(batch.begin() + first,
+                                            batch.begin() + std::min(batch.size(), first + kMaxOpenFiles));
+            writeBatch(group);
+        }
+        lock.lock();
+
+        busy_ = false;
+        idleCondition_.notify_all();
+    }
+}
+
+void WriteQueue::writeBatch(std::vector<PendingWrite>& batch)
+{
+#ifdef WIN32
+    for (auto& pending : batch)
+    {
+        pending.promise->set_value(writeAtomically(pending.path, pending.data->data(), pending.data->size(), true));
+    }
+#else
+    struct StagedWrite
+    {
+        std::filesystem::path temporaryPath;
+        int                   fd    = -1;
+        int                   error = 0;
+    };
+
+    std::vector<StagedWrite> staged(batch.size());
+
+    // write every temporary file and start their writeback, so the device works on all of them at once
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        staged[i].temporaryPath = makeTemporaryPath(batch[i].path);
+        staged[i].fd = open(staged[i].temporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+
+        if (staged[i].fd < 0 || !copyMode(staged[i].fd, batch[i].path) ||
+            !writeAll(staged[i].fd, batch[i].data->data(), batch[i].data->size()))
+        {
+            staged[i].error = errno;
+            continue;
+        }
+
+#ifdef __linux__
+        sync_file_range(staged[i].fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+    }
+
+    // by now most of the data is on its way, so these mostly wait on the same writeback
+    for (auto& write : staged)
+    {
+        if (write.error == 0 && fdatasync(write.fd) != 0)
+        {
+            write.error = errno;
+        }
+    }
+
+    std::unordered_set<std::string> directories;
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        StagedWrite& write = staged[i];
+
+        if (write.fd >= 0 && close(write.fd) != 0 && write.error == 0)
+        {
+            write.error = errno;
+        }
+
+        if (write.error == 0 && rename(write.temporaryPath.c_str(), batch[i].path.c_str()) != 0)
+        {
+            write.error = errno;
+        }
+
+        if (write.error != 0)
+        {
+            if (write.fd >= 0)
+                unlink(write.temporaryPath.c_str());
+            LOG_ERROR("Write File: {} Failed! {}", batch[i].path.string(), strerror(write.error));
+            continue;
+        }
+
+        directories.insert(batch[i].path.parent_path().string());
+    }
+
+    for (const auto& directory : directories)
+    {
+        syncDirectory(directory);
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        batch[i].promise->set_value(staged[i].error == 0);
+    }
+#endif
+}
+
+WriteQueue& WriteQueue::getInstance()
+{
+    static WriteQueue queue;
+    return queue;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "foundation/filesystem/vfs.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace muggle
+{
+namespace vfs
+{
+
+// Writes native files behind the caller's back, on its own thread.
+// Every file is written to a temporary file next to it, given the original's permissions, and renamed over the
+// original, so a crash leaves either the old or the new contents, never a torn file. Queued writes are handled in
+// batches: the data of the whole batch is flushed to the device together, then the files are renamed and their
+// folders synced, which costs little more than a single fsync. A write queued while an earlier write of the same
+// file is still waiting replaces it, and both callers get the same result.
+class WriteQueue {
+public:
+    WriteQueue();
+
+    // Finishes every queued write
+    ~WriteQueue();
+
+    WriteQueue(const WriteQueue&)            = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    // The future becomes true once the file is durably written, or false if writing failed
+    write_future_t enqueue(const std::filesystem::path& path, std::shared_ptr<IBlob> data);
+
+    // Wait for every write queued so far
+    void flush();
+
+    // Write 'data' to 'path' through a temporary file and an atomic rename, on the calling thread.
+    // With 'durable', the data and the rename are flushed to the device before returning.
+    static bool writeAtomically(const std::filesystem::path& path, const void* data, size_t size, bool durable);
+
+    // Shared by the native file systems
+    static WriteQueue& getInstance();
+
+private:
+    struct PendingWrite
+    {
+        std::filesystem::path               path;
+        std::shared_ptr<IBlob>              data;
+        std::shared_ptr<std::promise<bool>> promise;
+        write_future_t                      future;
+    };
+
+    void threadLoop();
+    void writeBatch(std::vector<PendingWrite>& batch);
+
+    std::thread                             thread_;
+    std::mutex                              mutex_;
+    std::condition_variable                 condition_;     // wakes the writer thread
+    std::condition_variable                 idleCondition_; // signaled when a batch is done
+    std::vector<PendingWrite>               queue_;
+    std::unordered_map<std::string, size_t> queuedPaths_; // index of each path in queue_
+    bool                                    busy_     = false; // the writer thread is handling a batch
+    bool                                    stopping_ = false;
+};
+
+} // namespace vfs
+} // namespace muggle
@@ -0,0 +1,440 @@
+#include "foundation/hash/hash.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define MUGGLE_HASH_X64
+#endif
+
+#if defined(MUGGLE_HASH_X64) && (defined(__GNUC__) || defined(__clang__)) && !defined(__AVX2__)
+// AVX2 is compiled separately and selected at run time
+#define MUGGLE_HASH_AVX2_TARGET __attribute__((target("avx2")))
+#define MUGGLE_HASH_AVX2_DISPATCH
+#elif defined(__AVX2__)
+#define MUGGLE_HASH_AVX2_TARGET
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+constexpr uint32_t kPrime32_1 = 0x9E3779B1U;
+constexpr uint32_t kPrime32_2 = 0x85EBCA77U;
+constexpr uint32_t kPrime32_3 = 0xC2B2AE3DU;
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t kPrimeMx1  = 0x165667919E3779F9ULL;
+constexpr uint64_t kPrimeMx2  = 0x9FB21C651E98DF25ULL;
+
+constexpr size_t kSecretSize          = 192;
+constexpr size_t kSecretSizeMin       = 136;
+constexpr size_t kStripeLength        = 64;
+constexpr size_t kSecretConsumeRate   = 8; // secret bytes consumed per stripe
+constexpr size_t kAccumulatorCount    = kStripeLength / sizeof(uint64_t);
+constexpr size_t kMidSizeMax          = 240;
+constexpr size_t kMidSizeStartOffset  = 3;
+constexpr size_t kMidSizeLastOffset   = 17;
+constexpr size_t kSecretLastAccStart  = 7;
+constexpr size_t kSecretMergeAccStart = 11;
+
+// The default secret of XXH3, from FARSH
+alignas(64) constexpr uint8_t kSecret[kSecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// The engine only targets little endian CPUs
+inline uint32_t readLE32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t readLE64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void writeLE64(uint8_t* p, uint64_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+inline uint32_t swap32(uint32_t x)
+{
+    return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) | ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+}
+
+inline uint64_t swap64(uint64_t x)
+{
+    return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) | swap32(static_cast<uint32_t>(x >> 32));
+}
+
+inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Low and high halves of the 128-bit product, xor-ed together
+inline uint64_t mul128Fold64(uint64_t lhs, uint64_t rhs)
+{
+#if defined(__SIZEOF_INT128__)
+    const __uint128_t product = static_cast<__uint128_t>(lhs) * rhs;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    uint64_t low = _umul128(lhs, rhs, &high);
+    return low ^ high;
+#else
+    const uint64_t loLo  = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+    const uint64_t hiLo  = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+    const uint64_t loHi  = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+    const uint64_t hiHi  = (lhs >> 32) * (rhs >> 32);
+    const uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+    const uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+    const uint64_t lower = (cross << 32) | (loLo & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+inline uint64_t xorShift64(uint64_t value, int shift)
+{
+    return value ^ (value >> shift);
+}
+
+uint64_t xxh64Avalanche(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= kPrime64_2;
+    hash ^= hash >> 29;
+    hash *= kPrime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t avalanche(uint64_t hash)
+{
+    hash = xorShift64(hash, 37);
+    hash *= kPrimeMx1;
+    hash = xorShift64(hash, 32);
+    return hash;
+}
+
+uint64_t rrmxmx(uint64_t hash, uint64_t length)
+{
+    hash ^= rotl64(hash, 49) ^ rotl64(hash, 24);
+    hash *= kPrimeMx2;
+    hash ^= (hash >> 35) + length;
+    hash *= kPrimeMx2;
+    return xorShift64(hash, 28);
+}
+
+uint64_t hashLength0To16(const uint8_t* input, size_t length, const uint8_t* secret, uint64_t seed)
+{
+    if (length > 8)
+    {
+        const uint64_t bitflip1 = (readLE64(secret + 24) ^ readLE64(secret + 32)) + seed;
+        const uint64_t bitflip2 = (readLE64(secret + 40) ^ readLE64(secret + 48)) - seed;
+        const uint64_t inputLo  = readLE64(input) ^ bitflip1;
+        const uint64_t inputHi  = readLE64(input + length - 8) ^ bitflip2;
+        const uint64_t acc      = length + swap64(inputLo) + inputHi + mul128Fold64(inputLo, inputHi);
+        return avalanche(acc);
+    }
+
+    if (length >= 4)
+    {
+        seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32;
+        const uint32_t input1  = readLE32(input);
+        const uint32_t input2  = readLE32(input + length - 4);
+        const uint64_t bitflip = (readLE64(secret + 8) ^ readLE64(secret + 16)) - seed;
+        const uint64_t input64 = input2 + (static_cast<uint64_t>(input1) << 32);
+        return rrmxmx(input64 ^ bitflip, length);
+    }
+
+    if (length > 0)
+    {
+        const uint8_t  c1       = input[0];
+        const uint8_t  c2       = input[length >> 1];
+        const uint8_t  c3       = input[length - 1];
+        const uint32_t combined = (static_cast<uint32_t>(c1) << 16) | (static_cast<uint32_t>(c2) << 24) |
+                                  (static_cast<uint32_t>(c3) << 0) | (static_cast<uint32_t>(length) << 8);
+        const uint64_t bitflip  = (readLE32(secret) ^ readLE32(secret + 4)) + seed;
+        return xxh64Avalanche(static_cast<uint64_t>(combined) ^ bitflip);
+    }
+
+    return xxh64Avalanche(seed ^ (readLE64(secret + 56) ^ readLE64(secret + 64)));
+}
+
+inline uint64_t mix16B(const uint8_t* input, const uint8_t* secret, uint64_t seed)
+{
+    const uint64_t inputLo = readLE64(input);
+    const uint64_t inputHi = readLE64(input + 8);
+    return mul128Fold64(inputLo ^ (readLE64(secret) + seed), inputHi ^ (readLE64(secret + 8) - seed));
+}
+
+uint64_t hashLength17To128(const uint8_t* input, size_t length, const uint8_t* secret, uint64_t seed)
+{
+    uint64_t acc = length * kPrime64_1;
+
+    if (length > 32)
+    {
+        if (length > 64)
+        {
+            if (length > 96)
+            {
+                acc += mix16B(input + 48, secret + 96, seed);
+                acc += mix16B(input + length - 64, secret + 112, seed);
+            }
+            acc += mix16B(input + 32, secret + 64, seed);
+            acc += mix16B(input + length - 48, secret + 80, seed);
+        }
+        acc += mix16B(input + 16, secret + 32, seed);
+        acc += mix16B(input + length - 32, secret + 48, seed);
+    }
+    acc += mix16B(input + 0, secret + 0, seed);
+    acc += mix16B(input + length - 16, secret + 16, seed);
+
+    return avalanche(acc);
+}
+
+uint64_t hashLength129To240(const uint8_t* input, size_t length, const uint8_t* secret, uint64_t seed)
+{
+    const size_t roundCount = length / 16;
+
+    uint64_t acc = length * kPrime64_1;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        acc += mix16B(input + 16 * i, secret + 16 * i, seed);
+    }
+    acc = avalanche(acc);
+
+    uint64_t accEnd = mix16B(input + length - 16, secret + kSecretSizeMin - kMidSizeLastOffset, seed);
+    for (size_t i = 8; i < roundCount; ++i)
+    {
+        accEnd += mix16B(input + 16 * i, secret + 16 * (i - 8) + kMidSizeStartOffset, seed);
+    }
+
+    return avalanche(acc + accEnd);
+}
+
+// Long inputs are processed in 64-byte stripes by 8 accumulators; the SIMD versions below compute the same
+// thing on 2 or 4 accumulators at a time
+
+#ifndef MUGGLE_HASH_X64
+void accumulateScalar(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount)
+{
+    for (size_t n = 0; n < stripeCount; ++n)
+    {
+        const uint8_t* stripe = input + n * kStripeLength;
+        const uint8_t* key    = secret + n * kSecretConsumeRate;
+
+        for (size_t lane = 0; lane < kAccumulatorCount; ++lane)
+        {
+            const uint64_t dataValue = readLE64(stripe + lane * 8);
+            const uint64_t dataKey   = dataValue ^ readLE64(key + lane * 8);
+            acc[lane ^ 1] += dataValue; // swap adjacent lanes
+            acc[lane] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+        }
+    }
+}
+
+void scrambleScalar(uint64_t* acc, const uint8_t* secret)
+{
+    for (size_t lane = 0; lane < kAccumulatorCount; ++lane)
+    {
+        uint64_t value = acc[lane];
+        value = xorShift64(value, 47);
+        value ^= readLE64(secret + lane * 8);
+        value *= kPrime32_1;
+        acc[lane] = value;
+    }
+}
+
+#else
+void accumulateSse2(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount)
+{
+    __m128i* xacc = reinterpret_cast<__m128i*>(acc);
+
+    for (size_t n = 0; n < stripeCount; ++n)
+    {
+        const __m128i* xinput  = reinterpret_cast<const __m128i*>(input + n * kStripeLength);
+        const __m128i* xsecret = reinterpret_cast<const __m128i*>(secret + n * kSecretConsumeRate);
+
+        for (size_t i = 0; i < kStripeLength / sizeof(__m128i); ++i)
+        {
+            const __m128i dataVec   = _mm_loadu_si128(xinput + i);
+            const __m128i keyVec    = _mm_loadu_si128(xsecret + i);
+            const __m128i dataKey   = _mm_xor_si128(dataVec, keyVec);
+            const __m128i dataKeyLo = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+            const __m128i product   = _mm_mul_epu32(dataKey, dataKeyLo);
+            const __m128i dataSwap  = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+            xacc[i]                 = _mm_add_epi64(product, _mm_add_epi64(xacc[i], dataSwap));
+        }
+    }
+}
+
+void scrambleSse2(uint64_t* acc, const uint8_t* secret)
+{
+    __m128i*       xacc    = reinterpret_cast<__m128i*>(acc);
+    const __m128i* xsecret = reinterpret_cast<const __m128i*>(secret);
+    const __m128i  prime32 = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+
+    for (size_t i = 0; i < kStripeLength / sizeof(__m128i); ++i)
+    {
+        const __m128i accVec    = xacc[i];
+        const __m128i dataVec   = _mm_xor_si128(accVec, _mm_srli_epi64(accVec, 47));
+        const __m128i dataKey   = _mm_xor_si128(dataVec, _mm_loadu_si128(xsecret + i));
+        const __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i productLo = _mm_mul_epu32(dataKey, prime32);
+        const __m128i productHi = _mm_mul_epu32(dataKeyHi, prime32);
+        xacc[i]                 = _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32));
+    }
+}
+#endif
+
+#ifdef MUGGLE_HASH_AVX2_TARGET
+MUGGLE_HASH_AVX2_TARGET void accumulateAvx2(uint64_t*      acc,
+                                            const uint8_t* input,
+                                            const uint8_t* secret,
+                                            size_t         stripeCount)
+{
+    __m256i* xacc = reinterpret_cast<__m256i*>(acc);
+
+    for (size_t n = 0; n < stripeCount; ++n)
+    {
+        const __m256i* xinput  = reinterpret_cast<const __m256i*>(input + n * kStripeLength);
+        const __m256i* xsecret = reinterpret_cast<const __m256i*>(secret + n * kSecretConsumeRate);
+
+        for (size_t i = 0; i < kStripeLength / sizeof(__m256i); ++i)
+        {
+            const __m256i dataVec   = _mm256_loadu_si256(xinput + i);
+            const __m256i keyVec    = _mm256_loadu_si256(xsecret + i);
+            const __m256i dataKey   = _mm256_xor_si256(dataVec, keyVec);
+            const __m256i dataKeyLo = _mm256_srli_epi64(dataKey, 32);
+            const __m256i product   = _mm256_mul_epu32(dataKey, dataKeyLo);
+            const __m256i dataSwap  = _mm256_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+            xacc[i]                 = _mm256_add_epi64(product, _mm256_add_epi64(xacc[i], dataSwap));
+        }
+    }
+}
+
+MUGGLE_HASH_AVX2_TARGET void scrambleAvx2(uint64_t* acc, const uint8_t* secret)
+{
+    __m256i*       xacc    = reinterpret_cast<__m256i*>(acc);
+    const __m256i* xsecret = reinterpret_cast<const __m256i*>(secret);
+    const __m256i  prime32 = _mm256_set1_epi32(static_cast<int>(kPrime32_1));
+
+    for (size_t i = 0; i < kStripeLength / sizeof(__m256i); ++i)
+    {
+        const __m256i accVec    = xacc[i];
+        const __m256i dataVec   = _mm256_xor_si256(accVec, _mm256_srli_epi64(accVec, 47));
+        const __m256i dataKey   = _mm256_xor_si256(dataVec, _mm256_loadu_si256(xsecret + i));
+        const __m256i dataKeyHi = _mm256_srli_epi64(dataKey, 32);
+        const __m256i productLo = _mm256_mul_epu32(dataKey, prime32);
+        const __m256i productHi = _mm256_mul_epu32(dataKeyHi, prime32);
+        xacc[i]                 = _mm256_add_epi64(productLo, _mm256_slli_epi64(productHi, 32));
+    }
+}
+#endif
+
+using accumulate_t = void (*)(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount);
+using scramble_t   = void (*)(uint64_t* acc, const uint8_t* secret);
+
+template<accumulate_t Accumulate, scramble_t Scramble>
+uint64_t hashLong(const uint8_t* input, size_t length, const uint8_t* secret)
+{
+    alignas(32) uint64_t acc[kAccumulatorCount] = {
+        kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1};
+
+    const size_t stripesPerBlock = (kSecretSize - kStripeLength) / kSecretConsumeRate;
+    const size_t blockLength     = kStripeLength * stripesPerBlock;
+    const size_t blockCount      = (length - 1) / blockLength;
+
+    for (size_t n = 0; n < blockCount; ++n)
+    {
+        Accumulate(acc, input + n * blockLength, secret, stripesPerBlock);
+        Scramble(acc, secret + kSecretSize - kStripeLength);
+    }
+
+    // last partial block, then the last stripe which may overlap it
+    const size_t stripeCount = ((length - 1) - blockLength * blockCount) / kStripeLength;
+    Accumulate(acc, input + blockCount * blockLength, secret, stripeCount);
+    Accumulate(acc, input + length - kStripeLength, secret + kSecretSize - kStripeLength - kSecretLastAccStart, 1);
+
+    uint64_t       result = length * kPrime64_1;
+    const uint8_t* merge  = secret + kSecretMergeAccStart;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        result += mul128Fold64(acc[2 * i] ^ readLE64(merge + 16 * i), acc[2 * i + 1] ^ readLE64(merge + 16 * i + 8));
+    }
+
+    return avalanche(result);
+}
+
+using hash_long_t = uint64_t (*)(const uint8_t* input, size_t length, const uint8_t* secret);
+
+hash_long_t selectHashLong()
+{
+#if defined(MUGGLE_HASH_AVX2_DISPATCH)
+    if (__builtin_cpu_supports("avx2"))
+        return hashLong<accumulateAvx2, scrambleAvx2>;
+    return hashLong<accumulateSse2, scrambleSse2>;
+#elif defined(MUGGLE_HASH_AVX2_TARGET)
+    return hashLong<accumulateAvx2, scrambleAvx2>;
+#elif defined(MUGGLE_HASH_X64)
+    return hashLong<accumulateSse2, scrambleSse2>;
+#else
+    return hashLong<accumulateScalar, scrambleScalar>;
+#endif
+}
+
+} // namespace
+
+uint64_t muggle::hash::xxh3(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+
+    if (size <= 16)
+        return hashLength0To16(input, size, kSecret, seed);
+
+    if (size <= 128)
+        return hashLength17To128(input, size, kSecret, seed);
+
+    if (size <= kMidSizeMax)
+        return hashLength129To240(input, size, kSecret, seed);
+
+    static const hash_long_t hashLongImpl = selectHashLong();
+
+    if (seed == 0)
+        return hashLongImpl(input, size, kSecret);
+
+    // seeded long inputs use a secret derived from the seed
+    alignas(64) uint8_t secret[kSecretSize];
+    for (size_t i = 0; i < kSecretSize / 16; ++i)
+    {
+        writeLE64(secret + 16 * i, readLE64(kSecret + 16 * i) + seed);
+        writeLE64(secret + 16 * i + 8, readLE64(kSecret + 16 * i + 8) - seed);
+    }
+
+    return hashLongImpl(input, size, secret);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace muggle
+{
+namespace hash
+{
+
+// 64-bit XXH3 from xxHash 0.8: fast on any size of input, well distributed, but not cryptographic.
+// Matches XXH3_64bits_withSeed of the reference implementation, the values can be stored in files.
+// Inputs larger than 240 bytes are hashed with AVX2 or SSE2 when the CPU supports them.
+uint64_t xxh3(const void* data, size_t size, uint64_t seed = 0);
+
+} // namespace hash
+} // namespace muggle
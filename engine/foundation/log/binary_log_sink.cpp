@@ -0,0 +1,337 @@
+#include "foundation/log/binary_log_sink.h"
+
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+extern "C"
+{
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+}
+#endif
+
+using namespace muggle;
+using namespace muggle::binlog;
+
+namespace
+{
+
+template<typename T>
+void put(uint8_t*& p, const T& value)
+{
+    memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+}
+
+} // namespace
+
+Reader::Reader(const void* data, size_t size) : data_(static_cast<const uint8_t*>(data)), size_(size)
+{
+    FileHeader header;
+    if (!read(&header))
+        return;
+
+    valid_ = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion;
+
+    // id 0 is no string
+    strings_.emplace_back();
+}
+
+template<typename T>
+bool Reader::read(T* outValue)
+{
+    if (size_ - position_ < sizeof(T))
+        return false;
+
+    memcpy(outValue, data_ + position_, sizeof(T));
+    position_ += sizeof(T);
+    return true;
+}
+
+bool Reader::next(Message* outMessage)
+{
+    if (!valid_ || corrupt_)
+        return false;
+
+    for (;;)
+    {
+        uint8_t type = 0;
+        if (!read(&type) || type == static_cast<uint8_t>(RecordType::End))
+            return false;
+
+        if (type == static_cast<uint8_t>(RecordType::String))
+        {
+            uint32_t id     = 0;
+            uint32_t length = 0;
+            if (!read(&id) || !read(&length) || id != strings_.size() || length >= size_ - position_ ||
+                data_[position_ + length] != 0)
+            {
+                corrupt_ = true;
+                return false;
+            }
+
+            strings_.emplace_back(reinterpret_cast<const char*>(data_ + position_), length);
+            position_ += length + 1;
+            continue;
+        }
+
+        uint8_t  level      = 0;
+        uint32_t categoryId = 0;
+        uint32_t formatId   = 0;
+        uint32_t argsSize   = 0;
+
+        if (type != static_cast<uint8_t>(RecordType::Message) || !read(&outMessage->timestamp) ||
+            !read(&outMessage->threadId) || !read(&level) || !read(&outMessage->argCount) || !read(&categoryId) ||
+            !read(&formatId) || !read(&argsSize) || categoryId >= strings_.size() || formatId == 0 ||
+            formatId >= strings_.size() || argsSize > size_ - position_)
+        {
+            corrupt_ = true;
+            return false;
+        }
+
+        outMessage->level    = static_cast<LogSystem::LogLevel>(level);
+        outMessage->category = strings_[categoryId];
+        outMessage->format   = strings_[formatId];
+        outMessage->args     = data_ + position_;
+        outMessage->argsSize = argsSize;
+
+        position_ += argsSize;
+        return true;
+    }
+}
+
+BinaryLogSink::BinaryLogSink(std::filesystem::path basePath, uint64_t fileSize, uint32_t maxFiles) :
+    basePath_(std::move(basePath)), fileSize_(fileSize), maxFiles_(maxFiles > 0 ? maxFiles : 1)
+{
+    rotate();
+}
+
+BinaryLogSink::~BinaryLogSink()
+{
+    closeFile();
+}
+
+std::filesystem::path BinaryLogSink::getFilePath(const std::filesystem::path& basePath, uint32_t index)
+{
+    std::filesystem::path path = basePath;
+    if (index > 0)
+    {
+        path += "." + std::to_string(index);
+    }
+    path += kExtension;
+
+    return path;
+}
+
+bool BinaryLogSink::rotate()
+{
+    closeFile();
+
+    std::error_code error;
+    std::filesystem::remove(getFilePath(basePath_, maxFiles_ - 1), error);
+
+    for (uint32_t index = maxFiles_ - 1; index > 0; --index)
+    {
+        const auto older = getFilePath(basePath_, index - 1);
+        if (std::filesystem::exists(older, error))
+        {
+            std::filesystem::rename(older, getFilePath(basePath_, index), error);
+        }
+    }
+
+    return openFile();
+}
+
+bool BinaryLogSink::openFile()
+{
+    const auto path = getFilePath(basePath_, 0);
+
+#ifdef WIN32
+    HANDLE file = CreateFileW(path.c_str(),
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Open File: {} Failed!", path.string());
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file,
+                                        nullptr,
+                                        PAGE_READWRITE,
+                                        static_cast<DWORD>(fileSize_ >> 32),
+                                        static_cast<DWORD>(fileSize_),
+                                        nullptr);
+    void*  view    = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        LOG_ERROR("Map File: {} Failed!", path.string());
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    file_        = file;
+    fileMapping_ = mapping;
+    mapping_     = static_cast<uint8_t*>(view);
+#else
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        LOG_ERROR("Open File: {} Failed!", path.string());
+        return false;
+    }
+
+    void* mapping = ftruncate(fd, static_cast<off_t>(fileSize_)) == 0
+                        ? mmap(nullptr, fileSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+    if (mapping == MAP_FAILED)
+    {
+        LOG_ERROR("Map File: {} Failed!", path.string());
+        close(fd);
+        return false;
+    }
+
+    fd_      = fd;
+    mapping_ = static_cast<uint8_t*>(mapping);
+#endif
+
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    FileHeader header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version    = kVersion;
+    header.createTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+
+    memcpy(mapping_, &header, sizeof(header));
+    position_ = sizeof(header);
+
+    stringIds_.clear();
+
+    return true;
+}
+
+void BinaryLogSink::closeFile()
+{
+    if (!mapping_)
+        return;
+
+    // the file is cut to what was written, if that fails the zeros after it end the log just as well
+#ifdef WIN32
+    UnmapViewOfFile(mapping_);
+    CloseHandle(fileMapping_);
+
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(position_);
+    SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+    SetEndOfFile(file_);
+    CloseHandle(file_);
+
+    file_        = nullptr;
+    fileMapping_ = nullptr;
+#else
+    munmap(mapping_, fileSize_);
+    [[maybe_unused]] const int truncated = ftruncate(fd_, static_cast<off_t>(position_));
+    close(fd_);
+
+    fd_ = -1;
+#endif
+
+    mapping_ = nullptr;
+}
+
+void BinaryLogSink::flush()
+{
+    if (!mapping_)
+        return;
+
+#ifdef WIN32
+    FlushViewOfFile(mapping_, 0);
+#else
+    msync(mapping_, fileSize_, MS_ASYNC);
+#endif
+}
+
+size_t BinaryLogSink::getStringRecordSize(const char* string) const
+{
+    if (!string || stringIds_.count(string) > 0)
+        return 0;
+
+    return kStringRecordSize + strlen(string) + 1;
+}
+
+uint32_t BinaryLogSink::writeString(const char* string)
+{
+    if (!string)
+        return 0;
+
+    auto it = stringIds_.find(string);
+    if (it != stringIds_.end())
+        return it->second;
+
+    const uint32_t id     = static_cast<uint32_t>(stringIds_.size() + 1);
+    const uint32_t length = static_cast<uint32_t>(strlen(string));
+
+    uint8_t* p = mapping_ + position_;
+    put(p, RecordType::String);
+    put(p, id);
+    put(p, length);
+    memcpy(p, string, length + 1);
+
+    position_ += kStringRecordSize + length + 1;
+    stringIds_.emplace(string, id);
+
+    return id;
+}
+
+void BinaryLogSink::write(const LogSystem::RecordHeader& header,
+                          uint64_t                       threadId,
+                          const uint8_t*                 args,
+                          size_t                         argsSize)
+{
+    if (!mapping_)
+        return;
+
+    auto getSize = [&]() {
+        return getStringRecordSize(header.category) + getStringRecordSize(header.format) + kMessageRecordSize +
+               argsSize;
+    };
+
+    if (position_ + getSize() > fileSize_)
+    {
+        // the strings are written again to the new file
+        if (!rotate() || position_ + getSize() > fileSize_)
+            return;
+    }
+
+    const uint32_t categoryId = writeString(header.category);
+    const uint32_t formatId   = writeString(header.format);
+
+    uint8_t* p = mapping_ + position_;
+    put(p, RecordType::Message);
+    put(p, header.timestamp);
+    put(p, threadId);
+    put(p, header.level);
+    put(p, header.argCount);
+    put(p, categoryId);
+    put(p, formatId);
+    put(p, static_cast<uint32_t>(argsSize));
+    memcpy(p, args, argsSize);
+
+    position_ += kMessageRecordSize + argsSize;
+}
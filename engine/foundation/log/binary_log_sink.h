@@ -0,0 +1,155 @@
+#pragma once
+
+#include "foundation/log/log_system.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace muggle
+{
+namespace binlog
+{
+
+// Layout of a binary log file:
+//   FileHeader
+//   records, each starting with its RecordType:
+//     String:  uint32_t id, uint32_t length, the characters and a null terminator
+//     Message: int64_t timestamp, uint64_t thread id, uint8_t level, uint8_t argument count, uint32_t category id,
+//              uint32_t format id, uint32_t arguments size, the arguments encoded as in LogSystem records
+//   zeros up to the end of the file, while it is being written
+// Each file is self-contained: a string is defined before the first message using it. Id 0 is no string.
+constexpr char        kMagic[4]  = {'M', 'L', 'O', 'G'};
+constexpr uint32_t    kVersion   = 1;
+constexpr const char* kExtension = ".mlog";
+
+enum class RecordType : uint8_t
+{
+    End,
+    String,
+    Message,
+};
+
+struct FileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    int64_t  createTime; // system clock, in nanoseconds since the epoch
+};
+
+constexpr size_t kStringRecordSize  = 1 + 2 * sizeof(uint32_t);
+constexpr size_t kMessageRecordSize = 1 + sizeof(int64_t) + sizeof(uint64_t) + 2 + 3 * sizeof(uint32_t);
+
+struct Message
+{
+    int64_t             timestamp;
+    uint64_t            threadId;
+    LogSystem::LogLevel level;
+    std::string_view    category; // empty without a category
+    std::string_view    format;   // null terminated
+    uint8_t             argCount;
+    const uint8_t*      args;
+    size_t              argsSize;
+
+    [[nodiscard]] std::string formatText() const
+    {
+        return LogSystem::formatMessage(format.data(), argCount, args, args + argsSize);
+    }
+};
+
+// Reads the messages of a binary log file in memory, which must outlive the reader and the messages
+class Reader {
+public:
+    Reader(const void* data, size_t size);
+
+    // The file starts with a valid header
+    [[nodiscard]] bool isValid() const
+    {
+        return valid_;
+    }
+
+    // Returns false at the end of the messages, or when the rest of the file is corrupt
+    bool next(Message* outMessage);
+
+    [[nodiscard]] bool isCorrupt() const
+    {
+        return corrupt_;
+    }
+
+private:
+    template<typename T>
+    bool read(T* outValue);
+
+    const uint8_t*                data_;
+    size_t                        size_;
+    size_t                        position_ = 0;
+    bool                          valid_    = false;
+    bool                          corrupt_  = false;
+    std::vector<std::string_view> strings_;
+};
+
+} // namespace binlog
+
+// Writes the log records, without formatting them, to memory mapped files in the binary log format.
+// 'basePath' + ".mlog" is the current file; when it is full it becomes basePath.1.mlog, the previous one
+// basePath.2.mlog and so on, and the oldest is removed to keep 'maxFiles' files. An existing log is rotated
+// the same way on construction. Records larger than a whole file are dropped.
+class BinaryLogSink : public LogRecordSink {
+public:
+    static constexpr uint64_t kDefaultFileSize = 64 * 1024 * 1024;
+    static constexpr uint32_t kDefaultMaxFiles = 4;
+
+    explicit BinaryLogSink(std::filesystem::path basePath,
+                           uint64_t              fileSize = kDefaultFileSize,
+                           uint32_t              maxFiles = kDefaultMaxFiles);
+    ~BinaryLogSink() override;
+
+    BinaryLogSink(const BinaryLogSink&)            = delete;
+    BinaryLogSink& operator=(const BinaryLogSink&) = delete;
+
+    [[nodiscard]] bool isOpen() const
+    {
+        return mapping_ != nullptr;
+    }
+
+    void write(const LogSystem::RecordHeader& header,
+               uint64_t                       threadId,
+               const uint8_t*                 args,
+               size_t                         argsSize) override;
+
+    // Schedule the written records to be stored, the operating system has them already
+    void flush() override;
+
+    // Path of the file 'index' rotations old
+    static std::filesystem::path getFilePath(const std::filesystem::path& basePath, uint32_t index);
+
+private:
+    bool openFile();
+    void closeFile();
+    bool rotate();
+
+    // Size of the string record needed for 'string', 0 if it is null or written already
+    size_t   getStringRecordSize(const char* string) const;
+    uint32_t writeString(const char* string);
+
+    std::filesystem::path basePath_;
+    uint64_t              fileSize_;
+    uint32_t              maxFiles_;
+
+    uint8_t* mapping_  = nullptr;
+    uint64_t position_ = 0;
+#ifdef WIN32
+    void* file_        = nullptr;
+    void* fileMapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+
+    // ids of the strings written to the current file, by address
+    std::unordered_map<const char*, uint32_t> stringIds_;
+};
+
+} // namespace muggle
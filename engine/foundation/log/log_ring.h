@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace muggle
+{
+
+// Single producer, single consumer queue of variable sized entries, used to hand log records from the thread
+// writing them to the logging backend without locks. Entries are contiguous in memory: one that does not fit
+// before the end of the buffer is preceded by padding and starts over at the beginning.
+class LogRing {
+public:
+    // 'capacity' is rounded up to a power of two
+    explicit LogRing(size_t capacity)
+    {
+        capacity_ = 64;
+        while (capacity_ < capacity)
+        {
+            capacity_ *= 2;
+        }
+
+        buffer_ = std::make_unique<uint8_t[]>(capacity_);
+    }
+
+    LogRing(const LogRing&)            = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    [[nodiscard]] size_t getCapacity() const
+    {
+        return capacity_;
+    }
+
+    // Producer: get 'size' bytes to write an entry to, or nullptr if the ring is full.
+    // The entry becomes visible to the consumer on commit.
+    uint8_t* reserve(size_t size)
+    {
+        const uint64_t entrySize = alignEntry(size);
+        uint64_t       head      = head_.load(std::memory_order_relaxed);
+        const size_t   offset    = static_cast<size_t>(head & (capacity_ - 1));
+        const size_t   toEnd     = capacity_ - offset;
+        const uint64_t needed    = entrySize <= toEnd ? entrySize : toEnd + entrySize;
+
+        if (entrySize > capacity_ / 2)
+            return nullptr;
+
+        if (head + needed - cachedTail_ > capacity_)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head + needed - cachedTail_ > capacity_)
+                return nullptr;
+        }
+
+        if (entrySize > toEnd)
+        {
+            writeEntryHeader(offset, static_cast<uint32_t>(toEnd), true);
+            head += toEnd;
+        }
+
+        const size_t entryOffset = static_cast<size_t>(head & (capacity_ - 1));
+        writeEntryHeader(entryOffset, static_cast<uint32_t>(entrySize), false);
+
+        pendingHead_ = head + entrySize;
+        return buffer_.get() + entryOffset + kEntryHeaderSize;
+    }
+
+    // Producer: publish the entry returned by the last reserve.
+    // Returns true if the ring was empty, when the consumer may have found nothing to do and gone to sleep.
+    bool commit()
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        head_.store(pendingHead_, std::memory_order_release);
+
+        // pairs with the fence in peek: either the consumer sees the entry, or this sees the ring it emptied
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        return cachedTail_ == head;
+    }
+
+    // Consumer: get the oldest entry and its size, which may be larger than reserved, or nullptr if there is none
+    const uint8_t* peek(size_t* outSize)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            if (tail == cachedHead_)
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                cachedHead_ = head_.load(std::memory_order_acquire);
+                if (tail == cachedHead_)
+                    return nullptr;
+            }
+
+            const size_t offset = static_cast<size_t>(tail & (capacity_ - 1));
+
+            EntryHeader header;
+            memcpy(&header, buffer_.get() + offset, sizeof(header));
+
+            if (!header.padding)
+            {
+                *outSize = header.size - kEntryHeaderSize;
+                return buffer_.get() + offset + kEntryHeaderSize;
+            }
+
+            tail += header.size;
+            tail_.store(tail, std::memory_order_release);
+        }
+    }
+
+    // Consumer: free the entry returned by peek
+    void release()
+    {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+        EntryHeader header;
+        memcpy(&header, buffer_.get() + (tail & (capacity_ - 1)), sizeof(header));
+
+        tail_.store(tail + header.size, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct EntryHeader
+    {
+        uint32_t size; // including the header
+        uint32_t padding;
+    };
+
+    static constexpr size_t kEntryHeaderSize = sizeof(EntryHeader);
+
+    static uint64_t alignEntry(size_t size)
+    {
+        return (static_cast<uint64_t>(size) + kEntryHeaderSize + 7) & ~uint64_t(7);
+    }
+
+    void writeEntryHeader(size_t offset, uint32_t size, bool padding)
+    {
+        const EntryHeader header = {size, padding ? 1u : 0u};
+        memcpy(buffer_.get() + offset, &header, sizeof(header));
+    }
+
+    std::unique_ptr<uint8_t[]> buffer_;
+    size_t                     capacity_ = 0;
+
+    // each side keeps its own copy of the other side's position, to rarely touch the other side's cache line;
+    // the producer still reads the tail on every commit to tell whether the consumer needs waking up
+    alignas(64) std::atomic<uint64_t> head_ {0};
+    uint64_t pendingHead_ = 0;
+    uint64_t cachedTail_  = 0;
+
+    alignas(64) std::atomic<uint64_t> tail_ {0};
+    uint64_t cachedHead_ = 0;
+};
+
+} // namespace muggle
@@ -1,37 +1,455 @@
 #include "foundation/log/log_system.h"
 
-#include <spdlog/async.h>
-#include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
+#ifdef SPDLOG_FMT_EXTERNAL
+#include <fmt/args.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#endif
+
+#include <algorithm>
+
 namespace muggle
 {
 
-LogSystem::LogSystem()
+LogCategory gDefaultLogCategory("default");
+
+namespace
+{
+
+std::atomic<uint64_t> gNextLogSystemId {1};
+
+struct CategoryRegistry
+{
+    std::mutex                mutex;
+    std::vector<LogCategory*> categories;
+};
+
+// Constructed by the first category, so it outlives the global categories
+CategoryRegistry& getCategoryRegistry()
+{
+    static CategoryRegistry registry;
+    return registry;
+}
+
+// How long the backend sleeps when nothing wakes it up, to report repeated records and update the clock of the
+// call sites
+constexpr std::chrono::milliseconds kBackendIdleTime(100);
+
+spdlog::level::level_enum toSpdlogLevel(LogSystem::LogLevel level)
+{
+    switch (level)
+    {
+        case LogSystem::LogLevel::debug:
+            return spdlog::level::debug;
+        case LogSystem::LogLevel::info:
+            return spdlog::level::info;
+        case LogSystem::LogLevel::warn:
+            return spdlog::level::warn;
+        case LogSystem::LogLevel::error:
+            return spdlog::level::err;
+        case LogSystem::LogLevel::fatal:
+            return spdlog::level::critical;
+        default:
+            return spdlog::level::info;
+    }
+}
+
+int64_t getTimestamp()
+{
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+struct FormattedMessage
+{
+    int64_t             timestamp;
+    LogSystem::LogLevel level;
+    std::string         text;
+};
+
+// Pass a record to the record sinks, and format it to 'messages' unless that is null
+void emitRecord(const LogSystem::RecordHeader&                     header,
+                uint64_t                                           threadId,
+                const uint8_t*                                     args,
+                size_t                                             argsSize,
+                const std::vector<std::shared_ptr<LogRecordSink>>& recordSinks,
+                std::vector<FormattedMessage>*                     messages)
+{
+    for (auto& sink : recordSinks)
+    {
+        sink->write(header, threadId, args, argsSize);
+    }
+
+    if (messages)
+    {
+        std::string text = LogSystem::formatMessage(header.format, header.argCount, args, args + argsSize);
+        if (header.category)
+        {
+            text = fmt::format("[{}] {}", header.category, text);
+        }
+
+        messages->push_back({header.timestamp, header.level, std::move(text)});
+    }
+}
+
+// Emit a record made by the backend, whose only argument is a count
+void emitCountRecord(LogSystem::LogLevel                                level,
+                     const char*                                        category,
+                     const char*                                        format,
+                     uint64_t                                           count,
+                     int64_t                                            timestamp,
+                     uint64_t                                           threadId,
+                     const std::vector<std::shared_ptr<LogRecordSink>>& recordSinks,
+                     std::vector<FormattedMessage>*                     messages)
+{
+    // encoded the way writeArgs does
+    uint8_t args[1 + sizeof(uint64_t)] = {static_cast<uint8_t>(LogSystem::ArgType::UInt)};
+    memcpy(args + 1, &count, sizeof(count));
+
+    LogSystem::RecordHeader header;
+    header.size      = static_cast<uint32_t>(sizeof(header) + sizeof(args));
+    header.level     = level;
+    header.argCount  = 1;
+    header.category  = category;
+    header.format    = format;
+    header.timestamp = timestamp;
+
+    emitRecord(header, threadId, args, sizeof(args), recordSinks, messages);
+}
+
+} // namespace
+
+std::atomic<uint32_t> LogCallSite::sCurrentSecond {0};
+std::atomic<uint32_t> LogCallSite::sRateLimit {kDefaultRateLimit};
+
+void LogCallSite::updateClock()
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    sCurrentSecond.store(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(now).count()),
+                         std::memory_order_relaxed);
+}
+
+void LogCallSite::startSecond(uint32_t second)
 {
-    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-    console_sink->set_level(spdlog::level::trace);
-    console_sink->set_pattern("[%^%l%$] %v");
+    // only the first thread to see the new second resets the counts, the others may count a few messages in the
+    // previous second, which does not matter
+    uint32_t previous = second_.load(std::memory_order_relaxed);
+    if (previous == second || !second_.compare_exchange_strong(previous, second, std::memory_order_relaxed))
+        return;
 
-    const spdlog::sinks_init_list sink_list = {console_sink};
+    count_.store(0, std::memory_order_relaxed);
+    reportable_.fetch_add(suppressed_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+}
 
-    spdlog::init_thread_pool(8192, 1);
+LogCategory::LogCategory(const char* name, LogLevel level) : name_(name), level_(LogLevel::debug)
+{
+    setLevel(level);
+
+    CategoryRegistry&           registry = getCategoryRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.categories.push_back(this);
+}
+
+LogCategory::~LogCategory()
+{
+    CategoryRegistry&           registry = getCategoryRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.categories.erase(std::find(registry.categories.begin(), registry.categories.end(), this));
+}
+
+LogCategory* LogCategory::find(std::string_view name)
+{
+    CategoryRegistry&           registry = getCategoryRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
 
-    logger_ = std::make_shared<spdlog::async_logger>("muggle_logger",
-                                                     sink_list.begin(),
-                                                     sink_list.end(),
-                                                     spdlog::thread_pool(),
-                                                     spdlog::async_overflow_policy::block);
+    for (LogCategory* category : registry.categories)
+    {
+        if (name == category->name_)
+            return category;
+    }
+
+    return nullptr;
+}
+
+std::vector<LogCategory*> LogCategory::getCategories()
+{
+    CategoryRegistry&           registry = getCategoryRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.categories;
+}
+
+std::string LogSystem::formatMessage(const char* format, uint8_t argCount, const uint8_t* args, const uint8_t* end)
+{
+    // the string arguments are referenced in place
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    store.reserve(argCount, 0);
+
+    const bool valid = visitArgs(argCount, args, end, [&store](const auto& value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string_view>)
+            store.push_back(fmt::string_view(value.data(), value.size()));
+        else
+            store.push_back(value);
+    });
+
+    if (!valid)
+        return fmt::format("[corrupt log record] {}", format);
+
+    try
+    {
+        return fmt::vformat(format, store);
+    }
+    catch (const fmt::format_error& error)
+    {
+        return fmt::format("[invalid log format: {}] {}", error.what(), format);
+    }
+}
+
+LogSystem::LogSystem() :
+    LogSystem({std::make_shared<spdlog::sinks::stdout_color_sink_mt>()}, kDefaultThreadBufferSize)
+{}
+
+LogSystem::LogSystem(std::vector<spdlog::sink_ptr> sinks, size_t threadBufferSize) :
+    id_(gNextLogSystemId.fetch_add(1)), threadBufferSize_(threadBufferSize)
+{
+    for (auto& sink : sinks)
+    {
+        sink->set_level(spdlog::level::trace);
+        sink->set_pattern("[%^%l%$] %v");
+    }
+
+    // only the backend thread writes to the sinks, so the logger is not registered with spdlog for others to find
+    logger_ = std::make_shared<spdlog::logger>("muggle_logger", sinks.begin(), sinks.end());
     logger_->set_level(spdlog::level::trace);
 
-    spdlog::register_logger(logger_);
+    backend_ = std::thread([this]() { backendLoop(); });
 }
 
 LogSystem::~LogSystem()
 {
+    {
+        std::lock_guard<std::mutex> lock(backendMutex_);
+        stopping_ = true;
+    }
+    backendWakeUp_.notify_one();
+    backend_.join();
+
     logger_->flush();
-    spdlog::drop_all();
+}
+
+std::shared_ptr<LogSystem::ThreadBuffer> LogSystem::registerThread()
+{
+    auto buffer = std::make_shared<ThreadBuffer>(threadBufferSize_, spdlog::details::os::thread_id());
+
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    buffers_.push_back(buffer);
+
+    return buffer;
+}
+
+void LogSystem::addRecordSink(std::shared_ptr<LogRecordSink> sink)
+{
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    recordSinks_.push_back(std::move(sink));
+}
+
+void LogSystem::wakeUpBackend()
+{
+    if (recordsPending_.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    // the backend checks recordsPending_ under the mutex before it waits, so the notification cannot be missed
+    std::lock_guard<std::mutex> lock(backendMutex_);
+    backendWakeUp_.notify_one();
+}
+
+void LogSystem::flush()
+{
+    std::unique_lock<std::mutex> lock(backendMutex_);
+
+    const uint64_t request = ++flushRequests_;
+    backendWakeUp_.notify_one();
+
+    flushed_.wait(lock, [this, request]() { return flushesDone_ >= request || stopping_; });
+}
+
+void LogSystem::backendLoop()
+{
+    for (;;)
+    {
+        uint64_t flushRequests = 0;
+        bool     stopping      = false;
+        {
+            std::lock_guard<std::mutex> lock(backendMutex_);
+            flushRequests = flushRequests_;
+            stopping      = stopping_;
+        }
+
+        LogCallSite::updateClock();
+
+        // records written from now on wake the backend up again
+        recordsPending_.exchange(false, std::memory_order_acq_rel);
+
+        // records written before a flush or stop request are all visible by now
+        const bool flushing = flushRequests != flushesDone_ || stopping;
+        while (processRecords(false) > 0)
+        {}
+
+        if (flushing)
+        {
+            processRecords(true);
+
+            logger_->flush();
+
+            std::lock_guard<std::mutex> lock(bufferMutex_);
+            for (auto& sink : recordSinks_)
+            {
+                sink->flush();
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(backendMutex_);
+
+        if (flushRequests != flushesDone_)
+        {
+            flushesDone_ = flushRequests;
+            flushed_.notify_all();
+        }
+
+        if (stopping)
+            break;
+
+        backendWakeUp_.wait_for(lock, kBackendIdleTime, [this]() {
+            return stopping_ || flushRequests_ != flushesDone_ || recordsPending_.load(std::memory_order_relaxed);
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(backendMutex_);
+    flushed_.notify_all();
+}
+
+size_t LogSystem::processRecords(bool flushRepeats)
+{
+    std::vector<std::shared_ptr<ThreadBuffer>>  buffers;
+    std::vector<std::shared_ptr<LogRecordSink>> recordSinks;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+
+        // the buffers of exited threads go once they are empty, which they stay since nobody writes to them
+        buffers_.erase(std::remove_if(buffers_.begin(),
+                                      buffers_.end(),
+                                      [](const auto& buffer) {
+                                          return buffer->closed.load(std::memory_order_acquire) &&
+                                                 buffer->ring.isEmpty() && buffer->repeats == 0;
+                                      }),
+                       buffers_.end());
+        buffers     = buffers_;
+        recordSinks = recordSinks_;
+    }
+
+    std::vector<FormattedMessage>  formatted;
+    std::vector<FormattedMessage>* messages    = logger_->sinks().empty() ? nullptr : &formatted;
+    size_t                         recordCount = 0;
+
+    const int64_t now = getTimestamp();
+
+    for (auto& buffer : buffers)
+    {
+        auto reportRepeats = [&]() {
+            if (buffer->repeats == 0)
+                return;
+
+            emitCountRecord(buffer->lastHeader.level,
+                            buffer->lastHeader.category,
+                            kRepeatedFormat,
+                            buffer->repeats,
+                            buffer->lastRepeatTime,
+                            buffer->threadId,
+                            recordSinks,
+                            messages);
+            buffer->repeats = 0;
+        };
+
+        // bounded by what the ring held when we started, so a busy thread does not starve the others
+        size_t remaining = buffer->ring.getCapacity();
+        size_t size      = 0;
+
+        while (const uint8_t* record = buffer->ring.peek(&size))
+        {
+            RecordHeader header;
+            memcpy(&header, record, sizeof(header));
+
+            const uint8_t* args     = record + sizeof(header);
+            const size_t   argsSize = header.size - sizeof(header);
+
+            const RecordHeader& last     = buffer->lastHeader;
+            const bool          repeated = buffer->hasLastRecord && header.size == last.size &&
+                                  header.level == last.level && header.argCount == last.argCount &&
+                                  header.category == last.category && header.format == last.format &&
+                                  memcmp(args, buffer->lastArgs.data(), argsSize) == 0;
+
+            if (repeated)
+            {
+                if (buffer->repeats++ == 0)
+                {
+                    buffer->firstRepeatTime = header.timestamp;
+                }
+                buffer->lastRepeatTime = header.timestamp;
+            }
+            else
+            {
+                reportRepeats();
+
+                emitRecord(header, buffer->threadId, args, argsSize, recordSinks, messages);
+
+                buffer->hasLastRecord = true;
+                buffer->lastHeader    = header;
+                buffer->lastArgs.assign(args, args + argsSize);
+            }
+
+            buffer->ring.release();
+            ++recordCount;
+
+            if (size >= remaining)
+                break;
+            remaining -= size;
+        }
+
+        if (flushRepeats ||
+            now - buffer->firstRepeatTime >= std::chrono::nanoseconds(kRepeatReportInterval).count())
+        {
+            reportRepeats();
+        }
+
+        if (uint64_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed))
+        {
+            droppedCount_.fetch_add(dropped, std::memory_order_relaxed);
+
+            reportRepeats();
+            emitCountRecord(
+                LogLevel::warn, nullptr, kDroppedFormat, dropped, now, buffer->threadId, recordSinks, messages);
+            buffer->hasLastRecord = false;
+            ++recordCount;
+        }
+    }
+
+    // each buffer is in order already, merge them
+    std::stable_sort(
+        formatted.begin(), formatted.end(), [](const FormattedMessage& a, const FormattedMessage& b) {
+            return a.timestamp < b.timestamp;
+        });
+
+    for (const auto& message : formatted)
+    {
+        const auto time = spdlog::log_clock::time_point(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(message.timestamp)));
+
+        logger_->log(time, spdlog::source_loc {}, toSpdlogLevel(message.level), message.text);
+    }
+
+    return recordCount;
 }
 
 } // namespace muggle
@@ -1,14 +1,94 @@
 #pragma once
 
+#include "foundation/log/log_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace muggle
 {
 
 extern class LogSystem* gLoggerSystem;
 
+class LogRecordSink;
+
+// State of one log macro call site, which lets it log at most a number of messages per second.
+// It is a function local static of the macro, so the check is a few relaxed loads while under the limit.
+// The messages suppressed in a second are reported with the next message the call site logs.
+class LogCallSite {
+public:
+    // Messages per second of each call site unless changed with setRateLimit
+    static constexpr uint32_t kDefaultRateLimit = 100;
+
+    constexpr LogCallSite() = default;
+
+    bool allow()
+    {
+        const uint32_t second = sCurrentSecond.load(std::memory_order_relaxed);
+        if (second != second_.load(std::memory_order_relaxed))
+        {
+            startSecond(second);
+        }
+
+        const uint32_t limit = sRateLimit.load(std::memory_order_relaxed);
+        if (limit > 0 && count_.load(std::memory_order_relaxed) >= limit)
+        {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // The number of messages suppressed in the seconds before the current one, which are then reported
+    uint32_t takeSuppressed()
+    {
+        if (reportable_.load(std::memory_order_relaxed) == 0)
+            return 0;
+
+        return reportable_.exchange(0, std::memory_order_relaxed);
+    }
+
+    // 0 disables rate limiting
+    static void setRateLimit(uint32_t messagesPerSecond)
+    {
+        sRateLimit.store(messagesPerSecond, std::memory_order_relaxed);
+    }
+
+    // Called regularly by the LogSystem backend, call sites start counting again when the second changes
+    static void updateClock();
+
+private:
+    void startSecond(uint32_t second);
+
+    std::atomic<uint32_t> second_ {0};
+    std::atomic<uint32_t> count_ {0};
+    std::atomic<uint32_t> suppressed_ {0};
+    std::atomic<uint32_t> reportable_ {0};
+
+    static std::atomic<uint32_t> sCurrentSecond;
+    static std::atomic<uint32_t> sRateLimit;
+};
+
+// Logging with the formatting deferred to a backend thread.
+// A log call only copies the format string pointer and its arguments into a ring buffer owned by the calling thread;
+// the backend thread takes the records from every thread, formats them in timestamp order and writes them to the
+// sinks. The format string must outlive the LogSystem, which string literals do. Arguments of types without
+// a cheap copy are formatted to a string on the calling thread. When a thread's buffer is full its records are
+// dropped rather than making it wait, and the number of dropped records is logged once there is room again.
 class LogSystem {
 public:
     enum class LogLevel : uint8_t
@@ -20,36 +100,60 @@ public:
         fatal
     };
 
+    // Size of the buffer of each logging thread
+    static constexpr size_t kDefaultThreadBufferSize = 256 * 1024;
+
+    // Identical records of a thread in a row are written once, followed by how often they were repeated.
+    // The count is written when the thread logs something else, on flush, or after this time.
+    static constexpr std::chrono::seconds kRepeatReportInterval {1};
+
+    static constexpr const char* kSuppressedFormat = "{} more messages like \"{}\" were suppressed by rate limiting";
+    static constexpr const char* kRepeatedFormat   = "last message repeated {} more times";
+    static constexpr const char* kDroppedFormat    = "{} log messages were dropped, the thread's log buffer was full";
+
 public:
     LogSystem();
+    explicit LogSystem(std::vector<spdlog::sink_ptr> sinks, size_t threadBufferSize = kDefaultThreadBufferSize);
     ~LogSystem();
 
+    LogSystem(const LogSystem&)            = delete;
+    LogSystem& operator=(const LogSystem&) = delete;
+
     template<typename... TARGS>
-    static void log(LogLevel level, TARGS&&... args)
+    static void log(LogLevel level, const char* format, const TARGS&... args)
     {
-        switch (level)
+        log(nullptr, level, format, args...);
+    }
+
+    // Log from a call site that 'callSite' allowed, reporting the messages it suppressed before
+    template<typename... TARGS>
+    static void log(
+        LogCallSite& callSite, const char* category, LogLevel level, const char* format, const TARGS&... args)
+    {
+        log(category, level, format, args...);
+
+        if (const uint32_t suppressed = callSite.takeSuppressed())
         {
-            case LogLevel::debug:
-                gLoggerSystem->logger_->debug(std::forward<TARGS>(args)...);
-                break;
-            case LogLevel::info:
-                gLoggerSystem->logger_->info(std::forward<TARGS>(args)...);
-                break;
-            case LogLevel::warn:
-                gLoggerSystem->logger_->warn(std::forward<TARGS>(args)...);
-                break;
-            case LogLevel::error:
-                gLoggerSystem->logger_->error(std::forward<TARGS>(args)...);
-                break;
-            case LogLevel::fatal:
-                gLoggerSystem->logger_->critical(std::forward<TARGS>(args)...);
-                fatalCallback(std::forward<TARGS>(args)...);
-                break;
-            default:
-                break;
+            gLoggerSystem->write(level, category, kSuppressedFormat, suppressed, std::string_view(format));
         }
     }
 
+    // 'category' is printed before the message unless it is null, and must outlive the LogSystem like 'format'
+    template<typename... TARGS>
+    static void log(const char* category, LogLevel level, const char* format, const TARGS&... args)
+    {
+        // fatal errors are formatted right away, they are reported by the exception as well
+        if (level == LogLevel::fatal)
+        {
+            const std::string message = fmt::format(format, args...);
+            gLoggerSystem->write(level, category, "{}", message);
+            gLoggerSystem->flush();
+            fatalCallback("{}", message);
+        }
+
+        gLoggerSystem->write(level, category, format, args...);
+    }
+
     template<typename... TARGS>
     static void fatalCallback(TARGS&&... args)
     {
@@ -57,18 +161,446 @@ public:
         throw std::runtime_error(format_str);
     }
 
+    // Queue a record for the backend thread
+    template<typename... TARGS>
+    void write(LogLevel level, const char* category, const char* format, const TARGS&... args)
+    {
+        static_assert(sizeof...(TARGS) <= 255, "Too many arguments for a log record");
+
+        writeArgs(level, category, format, toLogArg(args)...);
+    }
+
+    // Wait until every record written so far is in the sinks, and flush them
+    void flush();
+
+    // Also pass the records to 'sink' before they are formatted.
+    // A LogSystem without text sinks only writes to its record sinks, and does not format at all.
+    void addRecordSink(std::shared_ptr<LogRecordSink> sink);
+
+    // Number of records dropped because a thread's buffer was full
+    [[nodiscard]] uint64_t getDroppedCount() const
+    {
+        return droppedCount_.load(std::memory_order_relaxed);
+    }
+
+    // Argument types that are stored in log records as they are
+    enum class ArgType : uint8_t
+    {
+        Bool,
+        Char,
+        Int,    // any signed integer, as int64_t
+        UInt,   // any unsigned integer, as uint64_t
+        Float,
+        Double,
+        Pointer,
+        String, // uint32_t length followed by the characters
+    };
+
+    struct RecordHeader
+    {
+        uint32_t    size; // including the arguments
+        LogLevel    level;
+        uint8_t     argCount;
+        const char* category; // may be null
+        const char* format;
+        int64_t     timestamp; // system clock, in nanoseconds since the epoch
+    };
+
+    // Call 'visitor' with each of the 'argCount' arguments encoded in [p, end), as bool, char, int64_t, uint64_t,
+    // float, double, const void* or std::string_view. Returns false if the arguments are corrupt.
+    template<typename VISITOR>
+    static bool visitArgs(uint8_t argCount, const uint8_t* p, const uint8_t* end, VISITOR&& visitor)
+    {
+        for (uint8_t i = 0; i < argCount; ++i)
+        {
+            if (p >= end)
+                return false;
+
+            const auto type = static_cast<ArgType>(*p++);
+            if (type == ArgType::String)
+            {
+                uint32_t length = 0;
+                if (!readArg(p, end, &length) || length > static_cast<size_t>(end - p))
+                    return false;
+
+                visitor(std::string_view(reinterpret_cast<const char*>(p), length));
+                p += length;
+                continue;
+            }
+
+            bool ok = false;
+            switch (type)
+            {
+                case ArgType::Bool:
+                    ok = visitArg<bool>(p, end, visitor);
+                    break;
+                case ArgType::Char:
+                    ok = visitArg<char>(p, end, visitor);
+                    break;
+                case ArgType::Int:
+                    ok = visitArg<int64_t>(p, end, visitor);
+                    break;
+                case ArgType::UInt:
+                    ok = visitArg<uint64_t>(p, end, visitor);
+                    break;
+                case ArgType::Float:
+                    ok = visitArg<float>(p, end, visitor);
+                    break;
+                case ArgType::Double:
+                    ok = visitArg<double>(p, end, visitor);
+                    break;
+                case ArgType::Pointer:
+                    ok = visitArg<const void*>(p, end, visitor);
+                    break;
+                default:
+                    break;
+            }
+
+            if (!ok)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Format a message from its format string and encoded arguments, as the backend does
+    static std::string formatMessage(const char* format, uint8_t argCount, const uint8_t* args, const uint8_t* end);
+
 private:
+    struct ThreadBuffer
+    {
+        LogRing               ring;
+        uint64_t              threadId; // of the operating system
+        std::atomic<uint64_t> dropped {0};
+        std::atomic<bool>     closed {false}; // the thread has exited
+
+        // used by the backend only: the last record passed on and how often it was repeated since
+        bool                 hasLastRecord = false;
+        RecordHeader         lastHeader;
+        std::vector<uint8_t> lastArgs;
+        uint64_t             repeats         = 0;
+        int64_t              firstRepeatTime = 0;
+        int64_t              lastRepeatTime  = 0;
+
+        ThreadBuffer(size_t size, uint64_t threadId) : ring(size), threadId(threadId)
+        {}
+    };
+
+    template<typename T>
+    static bool readArg(const uint8_t*& p, const uint8_t* end, T* outValue)
+    {
+        if (static_cast<size_t>(end - p) < sizeof(T))
+            return false;
+
+        memcpy(outValue, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    template<typename T, typename VISITOR>
+    static bool visitArg(const uint8_t*& p, const uint8_t* end, VISITOR& visitor)
+    {
+        T value;
+        if (!readArg(p, end, &value))
+            return false;
+
+        visitor(value);
+        return true;
+    }
+
+    // The argument as it is stored: a scalar, a string_view of its characters, or a formatted std::string
+    template<typename T>
+    static auto toLogArg(const T& value)
+    {
+        using U = std::decay_t<T>;
+
+        if constexpr (std::is_same_v<U, bool> || std::is_same_v<U, char> || std::is_same_v<U, float> ||
+                      std::is_same_v<U, double>)
+            return value;
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+            return static_cast<int64_t>(value);
+        else if constexpr (std::is_integral_v<U>)
+            return static_cast<uint64_t>(value);
+        else if constexpr (std::is_array_v<T> && (std::is_same_v<U, const char*> || std::is_same_v<U, char*>))
+            return std::string_view(value);
+        else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>)
+            return std::string_view(value ? value : "(null)");
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            return std::string_view(value);
+        else if constexpr (std::is_pointer_v<U>)
+            return static_cast<const void*>(value);
+        else
+            return fmt::format("{}", value);
+    }
+
+    template<typename T>
+    static size_t getEncodedSize(const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+            return 1 + sizeof(uint32_t) + value.size();
+        else
+            return 1 + sizeof(T);
+    }
+
+    template<typename T>
+    static uint8_t* encode(uint8_t* p, const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+        {
+            const uint32_t length = static_cast<uint32_t>(value.size());
+            *p++                  = static_cast<uint8_t>(ArgType::String);
+            memcpy(p, &length, sizeof(length));
+            memcpy(p + sizeof(length), value.data(), length);
+            return p + sizeof(length) + length;
+        }
+        else
+        {
+            *p++ = static_cast<uint8_t>(getArgType<T>());
+            memcpy(p, &value, sizeof(T));
+            return p + sizeof(T);
+        }
+    }
+
+    template<typename T>
+    static constexpr ArgType getArgType()
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            return ArgType::Bool;
+        else if constexpr (std::is_same_v<T, char>)
+            return ArgType::Char;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return ArgType::Int;
+        else if constexpr (std::is_same_v<T, uint64_t>)
+            return ArgType::UInt;
+        else if constexpr (std::is_same_v<T, float>)
+            return ArgType::Float;
+        else if constexpr (std::is_same_v<T, double>)
+            return ArgType::Double;
+        else
+            return ArgType::Pointer;
+    }
+
+    template<typename... TARGS>
+    void writeArgs(LogLevel level, const char* category, const char* format, const TARGS&... args)
+    {
+        const size_t size = sizeof(RecordHeader) + (getEncodedSize(args) + ... + size_t(0));
+
+        ThreadBuffer& buffer = getThreadBuffer();
+        uint8_t*      p      = buffer.ring.reserve(size);
+        if (!p)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+
+        RecordHeader header;
+        header.size      = static_cast<uint32_t>(size);
+        header.level     = level;
+        header.argCount  = static_cast<uint8_t>(sizeof...(TARGS));
+        header.category  = category;
+        header.format    = format;
+        header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        ((p = encode(p, args)), ...);
+
+        if (buffer.ring.commit())
+        {
+            wakeUpBackend();
+        }
+    }
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        struct Registration
+        {
+            uint64_t                      owner = 0;
+            std::shared_ptr<ThreadBuffer> buffer;
+
+            ~Registration()
+            {
+                if (buffer)
+                {
+                    buffer->closed.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local Registration registration;
+
+        if (registration.owner != id_)
+        {
+            if (registration.buffer)
+            {
+                registration.buffer->closed.store(true, std::memory_order_release);
+            }
+
+            registration.buffer = registerThread();
+            registration.owner  = id_;
+        }
+
+        return *registration.buffer;
+    }
+
+    std::shared_ptr<ThreadBuffer> registerThread();
+    void                          wakeUpBackend();
+    void                          backendLoop();
+    size_t                        processRecords(bool flushRepeats);
+
     std::shared_ptr<spdlog::logger> logger_;
+
+    const uint64_t id_; // tells the buffers of successive LogSystems apart
+    const size_t   threadBufferSize_;
+
+    std::mutex                                  bufferMutex_; // also guards recordSinks_
+    std::vector<std::shared_ptr<ThreadBuffer>>  buffers_;
+    std::vector<std::shared_ptr<LogRecordSink>> recordSinks_;
+    std::atomic<uint64_t>                      droppedCount_ {0};
+
+    // the backend sleeps until it is woken up for new records, a flush or to stop; records only wake it up when
+    // they are written to an empty buffer, and only once until it takes them
+    std::atomic<bool>       recordsPending_ {false};
+    std::mutex              backendMutex_;
+    std::condition_variable backendWakeUp_;
+    std::condition_variable flushed_;
+    uint64_t                flushRequests_ = 0;
+    uint64_t                flushesDone_   = 0;
+    bool                    stopping_      = false;
+    std::thread             backend_;
+};
+
+// Receives log records before they are formatted, on the backend thread of the LogSystem.
+// The records of each thread come in order, but those of different threads are not merged by time.
+class LogRecordSink {
+public:
+    virtual ~LogRecordSink() = default;
+
+    // 'args' holds the header.argCount arguments, see LogSystem::visitArgs
+    virtual void write(const LogSystem::RecordHeader& header,
+                       uint64_t                       threadId,
+                       const uint8_t*                 args,
+                       size_t                         argsSize) = 0;
+
+    virtual void flush() = 0;
+};
+
+// A named group of log messages whose lowest enabled level can be changed at runtime. Categories are meant to be
+// global objects, defined with MUGGLE_DEFINE_LOG_CATEGORY, and are found by name to configure them.
+// Checking a category is one relaxed load, done by the LOG_CATEGORY_* macros before the arguments are evaluated.
+class LogCategory {
+public:
+    using LogLevel = LogSystem::LogLevel;
+
+    // 'name' must outlive the category, a string literal does
+    explicit LogCategory(const char* name, LogLevel level = LogLevel::debug);
+    ~LogCategory();
+
+    LogCategory(const LogCategory&)            = delete;
+    LogCategory& operator=(const LogCategory&) = delete;
+
+    [[nodiscard]] bool isEnabled(LogLevel level) const
+    {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Fatal messages are never disabled, since they throw
+    void setLevel(LogLevel level)
+    {
+        level_.store(level < LogLevel::fatal ? level : LogLevel::fatal, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] LogLevel getLevel() const
+    {
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] const char* getName() const
+    {
+        return name_;
+    }
+
+    // The category with the given name, or nullptr
+    static LogCategory* find(std::string_view name);
+
+    static std::vector<LogCategory*> getCategories();
+
+private:
+    const char*           name_;
+    std::atomic<LogLevel> level_;
 };
 
-#define LOG_DEBUG(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::debug, ##__VA_ARGS__);
+// The category of the LOG_* macros, its messages are printed without a category name
+extern LogCategory gDefaultLogCategory;
+
+} // namespace muggle
+
+#define MUGGLE_DECLARE_LOG_CATEGORY(name) extern muggle::LogCategory name;
+
+#define MUGGLE_DEFINE_LOG_CATEGORY(name, ...) muggle::LogCategory name(#name, ##__VA_ARGS__);
+
+// Lowest level of the log messages that are compiled, the macros of lower levels expand to nothing.
+// Fatal messages are always compiled, since they throw.
+#define MUGGLE_LOG_LEVEL_DEBUG 0
+#define MUGGLE_LOG_LEVEL_INFO 1
+#define MUGGLE_LOG_LEVEL_WARN 2
+#define MUGGLE_LOG_LEVEL_ERROR 3
+
+#ifndef MUGGLE_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define MUGGLE_LOG_ACTIVE_LEVEL MUGGLE_LOG_LEVEL_INFO
+#else
+#define MUGGLE_LOG_ACTIVE_LEVEL MUGGLE_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#define MUGGLE_LOG(categoryName, category, level, ...)                                                               \
+    do                                                                                                               \
+    {                                                                                                                \
+        static muggle::LogCallSite muggleLogCallSite;                                                                \
+        if ((category).isEnabled(muggle::LogSystem::LogLevel::level) && muggleLogCallSite.allow())                   \
+            muggle::LogSystem::log(                                                                                  \
+                muggleLogCallSite, categoryName, muggle::LogSystem::LogLevel::level, __VA_ARGS__);                   \
+    } while (false);
+
+#define MUGGLE_LOG_DEFAULT(level, ...) MUGGLE_LOG(nullptr, muggle::gDefaultLogCategory, level, __VA_ARGS__)
+
+#define MUGGLE_LOG_CATEGORY(category, level, ...) MUGGLE_LOG((category).getName(), category, level, __VA_ARGS__)
 
-#define LOG_INFO(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::info, ##__VA_ARGS__);
+#if MUGGLE_LOG_ACTIVE_LEVEL <= MUGGLE_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) MUGGLE_LOG_DEFAULT(debug, __VA_ARGS__)
+#define LOG_CATEGORY_DEBUG(category, ...) MUGGLE_LOG_CATEGORY(category, debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) (void)0;
+#define LOG_CATEGORY_DEBUG(category, ...) (void)0;
+#endif
 
-#define LOG_WARN(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::warn, ##__VA_ARGS__);
+#if MUGGLE_LOG_ACTIVE_LEVEL <= MUGGLE_LOG_LEVEL_INFO
+#define LOG_INFO(...) MUGGLE_LOG_DEFAULT(info, __VA_ARGS__)
+#define LOG_CATEGORY_INFO(category, ...) MUGGLE_LOG_CATEGORY(category, info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) (void)0;
+#define LOG_CATEGORY_INFO(category, ...) (void)0;
+#endif
 
-#define LOG_ERROR(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::error, ##__VA_ARGS__);
+#if MUGGLE_LOG_ACTIVE_LEVEL <= MUGGLE_LOG_LEVEL_WARN
+#define LOG_WARN(...) MUGGLE_LOG_DEFAULT(warn, __VA_ARGS__)
+#define LOG_CATEGORY_WARN(category, ...) MUGGLE_LOG_CATEGORY(category, warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) (void)0;
+#define LOG_CATEGORY_WARN(category, ...) (void)0;
+#endif
 
-#define LOG_FATAL(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::fatal, ##__VA_ARGS__);
+#if MUGGLE_LOG_ACTIVE_LEVEL <= MUGGLE_LOG_LEVEL_ERROR
+#define LOG_ERROR(...) MUGGLE_LOG_DEFAULT(error, __VA_ARGS__)
+#define LOG_CATEGORY_ERROR(category, ...) MUGGLE_LOG_CATEGORY(category, error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) (void)0;
+#define LOG_CATEGORY_ERROR(category, ...) (void)0;
+#endif
 
-} // namespace muggle
\ No newline at end of file
+#define LOG_FATAL(...) muggle::LogSystem::log(muggle::LogSystem::LogLevel::fatal, __VA_ARGS__);
+#define LOG_CATEGORY_FATAL(category, ...)                                                                            \
+    muggle::LogSystem::log((category).getName(), muggle::LogSystem::LogLevel::fatal, __VA_ARGS__);
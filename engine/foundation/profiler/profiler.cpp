@@ -0,0 +1,371 @@
+#include "foundation/profiler/profiler.h"
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+using namespace muggle;
+
+std::atomic<bool> Profiler::enabled_ {false};
+
+namespace
+{
+
+struct OpenZone
+{
+    const ProfileZoneSite* site;
+    uint64_t               begin;
+    uint64_t               childTicks;
+};
+
+// A thread's buffer with what the consumer knows about it
+struct ThreadState
+{
+    std::shared_ptr<Profiler::ThreadBuffer> buffer;
+    uint32_t                                index;
+    std::vector<OpenZone>                   openZones; // zones that began in an earlier frame are still here
+};
+
+struct ProfilerState
+{
+    std::mutex               threadMutex;
+    std::vector<ThreadState> threads;
+    std::vector<std::string> threadNames;
+    std::atomic<uint64_t>    droppedCount {0};
+
+    std::mutex               frameMutex;
+    std::deque<ProfileFrame> frames;
+    size_t                   maxFrames  = Profiler::kDefaultMaxFrames;
+    uint64_t                 frameIndex = 0;
+    uint64_t                 frameBegin = 0;
+};
+
+ProfilerState& getState()
+{
+    static ProfilerState state;
+    return state;
+}
+
+// Marks the buffer of the thread as closed when the thread exits
+struct Registration
+{
+    std::shared_ptr<Profiler::ThreadBuffer> buffer;
+
+    ~Registration()
+    {
+        if (buffer)
+        {
+            buffer->close();
+        }
+    }
+};
+
+thread_local Registration tRegistration;
+
+void appendJsonString(std::string& out, const char* text)
+{
+    out += '"';
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out += '\\';
+            out += *c;
+        }
+        else if (static_cast<unsigned char>(*c) < 0x20)
+        {
+            out += ' ';
+        }
+        else
+        {
+            out += *c;
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+Profiler::ThreadBuffer* Profiler::registerThread()
+{
+    ProfilerState& state  = getState();
+    auto           buffer = std::make_shared<ThreadBuffer>();
+
+    std::lock_guard<std::mutex> lock(state.threadMutex);
+
+    const auto index = static_cast<uint32_t>(state.threadNames.size());
+    state.threads.push_back({buffer, index, {}});
+    state.threadNames.push_back("Thread " + std::to_string(index));
+
+    tRegistration.buffer = buffer;
+    threadBuffer_        = buffer.get();
+
+    return threadBuffer_;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    ThreadBuffer*  buffer = getThreadBuffer();
+    ProfilerState& state  = getState();
+
+    std::lock_guard<std::mutex> lock(state.threadMutex);
+
+    for (const auto& thread : state.threads)
+    {
+        if (thread.buffer.get() == buffer)
+        {
+            state.threadNames[thread.index] = name;
+        }
+    }
+}
+
+void Profiler::endFrame()
+{
+    ProfilerState& state = getState();
+
+    ProfileFrame frame;
+    frame.end = Timer::getTicks();
+
+    {
+        std::lock_guard<std::mutex> lock(state.threadMutex);
+
+        for (auto& thread : state.threads)
+        {
+            ThreadBuffer&  buffer = *thread.buffer;
+            const uint64_t head   = buffer.head_.load(std::memory_order_acquire);
+            uint64_t       tail   = buffer.tail_.load(std::memory_order_relaxed);
+
+            for (; tail != head; ++tail)
+            {
+                const ThreadBuffer::Event& event = buffer.events_[tail & (kThreadBufferEvents - 1)];
+                const auto* site = reinterpret_cast<const ProfileZoneSite*>(event.siteAndEnd & ~uintptr_t(1));
+
+                if ((event.siteAndEnd & 1) == 0)
+                {
+                    thread.openZones.push_back({site, event.ticks, 0});
+                    continue;
+                }
+
+                // every recorded zone ends, in the reverse order they began
+                const OpenZone zone = thread.openZones.back();
+                thread.openZones.pop_back();
+
+                const uint64_t duration = event.ticks - zone.begin;
+                if (!thread.openZones.empty())
+                {
+                    thread.openZones.back().childTicks += duration;
+                }
+
+                frame.zones.push_back({zone.site,
+                                       thread.index,
+                                       static_cast<uint32_t>(thread.openZones.size()),
+                                       zone.begin,
+                                       event.ticks,
+                                       duration - std::min(duration, zone.childTicks)});
+            }
+
+            buffer.tail_.store(tail, std::memory_order_release);
+            state.droppedCount.fetch_add(buffer.dropped_.exchange(0, std::memory_order_relaxed),
+                                         std::memory_order_relaxed);
+        }
+
+        state.threads.erase(std::remove_if(state.threads.begin(),
+                                           state.threads.end(),
+                                           [](const ThreadState& thread) {
+                                               return thread.buffer->closed_.load(std::memory_order_acquire) &&
+                                                      thread.buffer->head_.load(std::memory_order_acquire) ==
+                                                          thread.buffer->tail_.load(std::memory_order_relaxed);
+                                           }),
+                            state.threads.end());
+
+        frame.threads = state.threadNames;
+    }
+
+    std::lock_guard<std::mutex> lock(state.frameMutex);
+
+    if (state.frameBegin == 0)
+    {
+        state.frameBegin = frame.end;
+        for (const auto& zone : frame.zones)
+        {
+            state.frameBegin = std::min(state.frameBegin, zone.begin);
+        }
+    }
+
+    frame.index      = state.frameIndex++;
+    frame.begin      = state.frameBegin;
+    state.frameBegin = frame.end;
+
+    state.frames.push_back(std::move(frame));
+    while (state.frames.size() > state.maxFrames)
+    {
+        state.frames.pop_front();
+    }
+}
+
+void Profiler::setMaxFrames(size_t maxFrames)
+{
+    ProfilerState&              state = getState();
+    std::lock_guard<std::mutex> lock(state.frameMutex);
+
+    state.maxFrames = std::max<size_t>(maxFrames, 1);
+    while (state.frames.size() > state.maxFrames)
+    {
+        state.frames.pop_front();
+    }
+}
+
+std::vector<ProfileFrame> Profiler::getFrames()
+{
+    ProfilerState&              state = getState();
+    std::lock_guard<std::mutex> lock(state.frameMutex);
+
+    return {state.frames.begin(), state.frames.end()};
+}
+
+std::vector<ProfileZoneStats> Profiler::getZoneStats(size_t frameCount)
+{
+    ProfilerState&              state = getState();
+    std::lock_guard<std::mutex> lock(state.frameMutex);
+
+    frameCount = std::min(frameCount, state.frames.size());
+    if (frameCount == 0)
+        return {};
+
+    struct Totals
+    {
+        uint64_t calls      = 0;
+        uint64_t ticks      = 0;
+        uint64_t selfTicks  = 0;
+        uint64_t worstTicks = 0;
+    };
+
+    std::unordered_map<const ProfileZoneSite*, Totals> totals;
+    for (auto frame = state.frames.end() - static_cast<ptrdiff_t>(frameCount); frame != state.frames.end(); ++frame)
+    {
+        for (const auto& zone : frame->zones)
+        {
+            Totals& site = totals[zone.site];
+            site.calls += 1;
+            site.ticks += zone.end - zone.begin;
+            site.selfTicks += zone.selfTicks;
+            site.worstTicks = std::max(site.worstTicks, zone.end - zone.begin);
+        }
+    }
+
+    const double millisecondsPerTick = 1000.0 / Timer().getFrequency();
+    const double frames              = static_cast<double>(frameCount);
+
+    std::vector<ProfileZoneStats> stats;
+    stats.reserve(totals.size());
+    for (const auto& [site, total] : totals)
+    {
+        stats.push_back({site,
+                         static_cast<double>(total.calls) / frames,
+                         static_cast<double>(total.ticks) * millisecondsPerTick / frames,
+                         static_cast<double>(total.selfTicks) * millisecondsPerTick / frames,
+                         static_cast<double>(total.worstTicks) * millisecondsPerTick});
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b) {
+        return a.milliseconds > b.milliseconds;
+    });
+
+    return stats;
+}
+
+uint64_t Profiler::getDroppedCount()
+{
+    return getState().droppedCount.load(std::memory_order_relaxed);
+}
+
+bool Profiler::exportChromeTrace(const std::filesystem::path& path)
+{
+    const std::vector<ProfileFrame> frames = getFrames();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        LOG_ERROR("Open File: {} Failed!", path.string());
+        return false;
+    }
+
+    // microseconds since the first frame
+    const double   microsecondsPerTick = 1e6 / Timer().getFrequency();
+    const uint64_t base                = frames.empty() ? 0 : frames.front().begin;
+    auto           toMicroseconds      = [&](uint64_t ticks) {
+        return static_cast<double>(ticks - std::min(ticks, base)) * microsecondsPerTick;
+    };
+
+    // the frames are on a track of their own, before the threads
+    constexpr uint32_t kFrameTrack = 0;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+
+    if (!frames.empty())
+    {
+        const auto& threads = frames.back().threads;
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(i + 1) +
+                    ",\"args\":{\"name\":";
+            appendJsonString(json, threads[i].c_str());
+            json += "}}";
+        }
+    }
+
+    char number[64];
+    for (const auto& frame : frames)
+    {
+        snprintf(number,
+                 sizeof(number),
+                 "\"ts\":%.3f,\"dur\":%.3f",
+                 toMicroseconds(frame.begin),
+                 toMicroseconds(frame.end) - toMicroseconds(frame.begin));
+
+        json += ",\n{\"name\":\"Frame " + std::to_string(frame.index) + "\",\"cat\":\"frame\",\"ph\":\"X\",";
+        json += number;
+        json += ",\"pid\":1,\"tid\":" + std::to_string(kFrameTrack) + "}";
+
+        for (const auto& zone : frame.zones)
+        {
+            snprintf(number,
+                     sizeof(number),
+                     "\"ts\":%.3f,\"dur\":%.3f",
+                     toMicroseconds(zone.begin),
+                     toMicroseconds(zone.end) - toMicroseconds(zone.begin));
+
+            json += ",\n{\"name\":";
+            appendJsonString(json, zone.site->name);
+            json += ",\"cat\":\"zone\",\"ph\":\"X\",";
+            json += number;
+            json += ",\"pid\":1,\"tid\":" + std::to_string(zone.thread + 1) + ",\"args\":{\"function\":";
+            appendJsonString(json, zone.site->function);
+            json += ",\"file\":";
+            appendJsonString(json, zone.site->file);
+            json += ",\"line\":" + std::to_string(zone.site->line) + "}}";
+        }
+
+        // written in pieces, a trace of a few hundred frames can have millions of zones
+        if (json.size() > (1 << 20))
+        {
+            file.write(json.data(), static_cast<std::streamsize>(json.size()));
+            json.clear();
+        }
+    }
+
+    json += "\n]}\n";
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+
+    if (!file.good())
+    {
+        LOG_ERROR("Write File: {} Failed!", path.string());
+        return false;
+    }
+
+    return true;
+}
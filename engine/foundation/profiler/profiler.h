@@ -0,0 +1,217 @@
+#pragma once
+
+#include "foundation/timer/timer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace muggle
+{
+
+// Where a profile zone is in the source, a static record made by the zone macros
+struct ProfileZoneSite
+{
+    const char* name;
+    const char* function;
+    const char* file;
+    uint32_t    line;
+};
+
+// A zone of one frame, ticks are those of Timer::getTicks
+struct ProfileZone
+{
+    const ProfileZoneSite* site;
+    uint32_t               thread; // index into ProfileFrame::threads
+    uint32_t               depth;  // 0 for zones that are not inside another zone of their thread
+    uint64_t               begin;
+    uint64_t               end;
+    uint64_t               selfTicks; // without the zones inside it
+};
+
+// The zones that ended during a frame, in the order they ended on each thread
+struct ProfileFrame
+{
+    uint64_t                 index;
+    uint64_t                 begin;
+    uint64_t                 end;
+    std::vector<ProfileZone> zones;
+    std::vector<std::string> threads; // the names of the threads, by index
+};
+
+// Time spent in the zones of a site over some frames
+struct ProfileZoneStats
+{
+    const ProfileZoneSite* site;
+    double                 callsPerFrame;
+    double                 milliseconds;     // per frame, including the zones inside
+    double                 selfMilliseconds; // per frame
+    double                 maxMilliseconds;  // of a single zone
+};
+
+// Instrumenting CPU profiler. MUGGLE_PROFILE_ZONE records when the scope it is in begins and ends into a lock-free
+// buffer of the calling thread; endFrame, called by one thread once a frame, takes the zones of every thread and
+// keeps the last frames, to look at in code or to export as a Chrome trace for chrome://tracing or Perfetto.
+// Zones cost a relaxed load while the profiler is disabled, which it is by default.
+class Profiler {
+public:
+    static constexpr size_t kThreadBufferEvents = 64 * 1024;
+    static constexpr size_t kDefaultMaxFrames   = 300;
+
+    static void setEnabled(bool enabled)
+    {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static bool isEnabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Name of the calling thread in the profiles
+    static void setThreadName(const std::string& name);
+
+    // End the current frame: collect the zones that ended since the last call. Only one thread may call it.
+    static void endFrame();
+
+    static void setMaxFrames(size_t maxFrames);
+
+    // The frames kept, oldest first
+    static std::vector<ProfileFrame> getFrames();
+
+    // Statistics of each zone site over the last 'frameCount' frames, the most expensive first
+    static std::vector<ProfileZoneStats> getZoneStats(size_t frameCount);
+
+    // Zones that were not recorded because a thread's buffer was full
+    static uint64_t getDroppedCount();
+
+    // Write the frames kept in the Chrome trace event format
+    static bool exportChromeTrace(const std::filesystem::path& path);
+
+    // Used by ProfileScope
+    class ThreadBuffer;
+    static ThreadBuffer* getThreadBuffer()
+    {
+        ThreadBuffer* buffer = threadBuffer_;
+        return buffer ? buffer : registerThread();
+    }
+
+private:
+    static ThreadBuffer* registerThread();
+
+    static std::atomic<bool>                 enabled_;
+    static inline thread_local ThreadBuffer* threadBuffer_ = nullptr;
+};
+
+// Single producer, single consumer queue of the zone events of a thread. A zone begins only if there is room
+// for its end and the ends of the zones it is inside, so every recorded zone ends.
+class Profiler::ThreadBuffer {
+public:
+    struct Event
+    {
+        uint64_t  ticks;
+        uintptr_t siteAndEnd; // the site, with the lowest bit set for the end of the zone
+    };
+
+    // Producer
+    bool begin(const ProfileZoneSite* site)
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head + openZones_ + 2 - cachedTail_ > kThreadBufferEvents)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head + openZones_ + 2 - cachedTail_ > kThreadBufferEvents)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        ++openZones_;
+        events_[head & (kThreadBufferEvents - 1)] = {Timer::getTicksFast(), reinterpret_cast<uintptr_t>(site)};
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer, only for zones whose begin returned true
+    void end(const ProfileZoneSite* site)
+    {
+        const uint64_t ticks = Timer::getTicksFast();
+        const uint64_t head  = head_.load(std::memory_order_relaxed);
+
+        --openZones_;
+        events_[head & (kThreadBufferEvents - 1)] = {ticks, reinterpret_cast<uintptr_t>(site) | 1};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // The thread exited, the buffer goes once it is empty
+    void close()
+    {
+        closed_.store(true, std::memory_order_release);
+    }
+
+private:
+    friend class Profiler;
+
+    std::unique_ptr<Event[]> events_ {new Event[kThreadBufferEvents]};
+
+    // written by the producer
+    alignas(64) std::atomic<uint64_t> head_ {0};
+    uint64_t              cachedTail_ = 0;
+    uint64_t              openZones_  = 0;
+    std::atomic<uint64_t> dropped_ {0};
+
+    // written by the consumer
+    alignas(64) std::atomic<uint64_t> tail_ {0};
+    std::atomic<bool>     closed_ {false};
+};
+
+// Records a zone for the lifetime of the object, see MUGGLE_PROFILE_ZONE
+class ProfileScope {
+public:
+    explicit ProfileScope(const ProfileZoneSite* site)
+    {
+        if (Profiler::isEnabled())
+        {
+            Profiler::ThreadBuffer* buffer = Profiler::getThreadBuffer();
+            if (buffer->begin(site))
+            {
+                buffer_ = buffer;
+                site_   = site;
+            }
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (buffer_)
+        {
+            buffer_->end(site_);
+        }
+    }
+
+    ProfileScope(const ProfileScope&)            = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler::ThreadBuffer* buffer_ = nullptr;
+    const ProfileZoneSite*  site_   = nullptr;
+};
+
+} // namespace muggle
+
+#define MUGGLE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MUGGLE_PROFILE_CONCAT(a, b) MUGGLE_PROFILE_CONCAT_IMPL(a, b)
+
+// Profile the rest of the enclosing scope as a zone called 'name', which must be a string literal
+#define MUGGLE_PROFILE_ZONE(name)                                                                                    \
+    static const muggle::ProfileZoneSite MUGGLE_PROFILE_CONCAT(muggleProfileSite, __LINE__) = {                     \
+        name, __func__, __FILE__, __LINE__};                                                                         \
+    muggle::ProfileScope MUGGLE_PROFILE_CONCAT(muggleProfileScope, __LINE__)(                                        \
+        &MUGGLE_PROFILE_CONCAT(muggleProfileSite, __LINE__));
+
+// Profile the rest of the enclosing function as a zone named after it
+#define MUGGLE_PROFILE_FUNCTION() MUGGLE_PROFILE_ZONE(__func__)
@@ -0,0 +1,279 @@
+#include "foundation/stats/stats.h"
+#include "foundation/log/log_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+using namespace muggle;
+
+std::atomic<uint64_t> Stat::interval_ {0};
+
+namespace
+{
+
+MUGGLE_DEFINE_LOG_CATEGORY(Stats)
+
+struct StatRegistry
+{
+    std::mutex         mutex;
+    std::vector<Stat*> stats;
+
+    Timer  timer;
+    double intervalSeconds = Stat::kDefaultIntervalSeconds;
+    double intervalBegin   = 0.0;
+    double dumpSeconds     = 0.0;
+    double lastDump        = 0.0;
+};
+
+// Constructed by the first stat, so it outlives the global stats
+StatRegistry& getStatRegistry()
+{
+    static StatRegistry registry;
+    return registry;
+}
+
+double getMillisecondsPerTick()
+{
+    static const double millisecondsPerTick = 1000.0 / Timer().getFrequency();
+    return millisecondsPerTick;
+}
+
+// The value of the bucket in the middle of those it counts, within the values recorded
+double getPercentile(const uint64_t* counts, uint64_t total, double percentile, uint64_t min, uint64_t max)
+{
+    const auto rank =
+        std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile * static_cast<double>(total))));
+
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < StatHistogram::kBucketCount; ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen < rank)
+            continue;
+
+        const bool     last = bucket + 1 == StatHistogram::kBucketCount;
+        const uint64_t low  = StatHistogram::getBucketValue(bucket);
+        const uint64_t high = last ? std::max(max, low + 1) : StatHistogram::getBucketValue(bucket + 1);
+        const uint64_t mid  = low + (high - low - 1) / 2;
+        return static_cast<double>(std::clamp(mid, min, max));
+    }
+
+    return static_cast<double>(max);
+}
+
+} // namespace
+
+void StatHistogram::reset()
+{
+    for (auto& count : counts_)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+Stat::Stat(const char* name, StatUnit unit) : name_(name), unit_(unit)
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.stats.push_back(this);
+}
+
+Stat::~Stat()
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.stats.erase(std::find(registry.stats.begin(), registry.stats.end(), this));
+}
+
+StatSummary Stat::getSummary(size_t intervalCount) const
+{
+    intervalCount = std::min(intervalCount, kWindowIntervals);
+
+    // the complete intervals are the slots before the current one
+    const uint64_t interval = interval_.load(std::memory_order_relaxed);
+    intervalCount           = static_cast<size_t>(std::min<uint64_t>(intervalCount, interval));
+
+    std::vector<uint64_t> counts(StatHistogram::kBucketCount, 0);
+    uint64_t              count = 0;
+    uint64_t              sum   = 0;
+    uint64_t              min   = std::numeric_limits<uint64_t>::max();
+    uint64_t              max   = 0;
+
+    for (size_t i = 1; i <= intervalCount; ++i)
+    {
+        const StatHistogram& histogram = intervals_[(interval - i) % kIntervalSlots];
+        for (uint32_t bucket = 0; bucket < StatHistogram::kBucketCount; ++bucket)
+        {
+            const uint32_t bucketCount = histogram.counts_[bucket].load(std::memory_order_relaxed);
+            counts[bucket] += bucketCount;
+            count += bucketCount;
+        }
+
+        sum += histogram.sum_.load(std::memory_order_relaxed);
+        min = std::min(min, histogram.min_.load(std::memory_order_relaxed));
+        max = std::max(max, histogram.max_.load(std::memory_order_relaxed));
+    }
+
+    return summarize(counts.data(), count, sum, min, max);
+}
+
+std::vector<StatSummary> Stat::getIntervalSummaries() const
+{
+    const uint64_t interval = interval_.load(std::memory_order_relaxed);
+    const size_t   complete = static_cast<size_t>(std::min<uint64_t>(kWindowIntervals, interval));
+
+    std::vector<StatSummary> summaries;
+    summaries.reserve(complete);
+
+    std::vector<uint64_t> counts(StatHistogram::kBucketCount);
+    for (size_t i = complete; i > 0; --i)
+    {
+        const StatHistogram& histogram = intervals_[(interval - i) % kIntervalSlots];
+
+        uint64_t count = 0;
+        for (uint32_t bucket = 0; bucket < StatHistogram::kBucketCount; ++bucket)
+        {
+            counts[bucket] = histogram.counts_[bucket].load(std::memory_order_relaxed);
+            count += counts[bucket];
+        }
+
+        summaries.push_back(summarize(counts.data(),
+                                      count,
+                                      histogram.sum_.load(std::memory_order_relaxed),
+                                      histogram.min_.load(std::memory_order_relaxed),
+                                      histogram.max_.load(std::memory_order_relaxed)));
+    }
+
+    return summaries;
+}
+
+StatSummary Stat::summarize(const uint64_t* counts, uint64_t count, uint64_t sum, uint64_t min, uint64_t max) const
+{
+    StatSummary summary;
+    if (count == 0)
+        return summary;
+
+    const double scale = unit_ == StatUnit::Time ? getMillisecondsPerTick() : 1.0;
+
+    summary.count = count;
+    summary.mean  = static_cast<double>(sum) / static_cast<double>(count) * scale;
+    summary.min   = static_cast<double>(min) * scale;
+    summary.p50   = getPercentile(counts, count, 0.50, min, max) * scale;
+    summary.p95   = getPercentile(counts, count, 0.95, min, max) * scale;
+    summary.p99   = getPercentile(counts, count, 0.99, min, max) * scale;
+    summary.max   = static_cast<double>(max) * scale;
+    return summary;
+}
+
+Stat* Stat::find(std::string_view name)
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (Stat* stat : registry.stats)
+    {
+        if (name == stat->name_)
+            return stat;
+    }
+
+    return nullptr;
+}
+
+std::vector<Stat*> Stat::getStats()
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.stats;
+}
+
+void Stat::update()
+{
+    StatRegistry& registry      = getStatRegistry();
+    size_t        dumpIntervals = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        const double now = registry.timer.getSeconds();
+        if (now - registry.intervalBegin < registry.intervalSeconds)
+            return;
+
+        // the oldest interval of the window makes room for the next one; a thread still recording into it with
+        // an index read a whole window ago may lose a value
+        const uint64_t next = interval_.load(std::memory_order_relaxed) + 1;
+        for (Stat* stat : registry.stats)
+        {
+            stat->intervals_[next % kIntervalSlots].reset();
+        }
+        interval_.store(next, std::memory_order_relaxed);
+        registry.intervalBegin = now;
+
+        if (registry.dumpSeconds > 0.0 && now - registry.lastDump >= registry.dumpSeconds)
+        {
+            dumpIntervals     = static_cast<size_t>(std::ceil(registry.dumpSeconds / registry.intervalSeconds));
+            registry.lastDump = now;
+        }
+    }
+
+    if (dumpIntervals > 0)
+    {
+        dump(dumpIntervals);
+    }
+}
+
+void Stat::setIntervalSeconds(double seconds)
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.intervalSeconds = std::max(seconds, 0.001);
+}
+
+void Stat::setDumpSeconds(double seconds)
+{
+    StatRegistry&               registry = getStatRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.dumpSeconds = std::max(seconds, 0.0);
+    registry.lastDump    = registry.timer.getSeconds();
+}
+
+void Stat::dump(size_t intervalCount)
+{
+    for (const Stat* stat : getStats())
+    {
+        const StatSummary summary = stat->getSummary(intervalCount);
+        if (summary.count == 0)
+            continue;
+
+        if (stat->unit_ == StatUnit::Time)
+        {
+            LOG_CATEGORY_INFO(Stats,
+                              "{}: {} values, mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, "
+                              "max {:.3f} ms",
+                              stat->name_,
+                              summary.count,
+                              summary.mean,
+                              summary.p50,
+                              summary.p95,
+                              summary.p99,
+                              summary.max);
+        }
+        else
+        {
+            LOG_CATEGORY_INFO(Stats,
+                              "{}: {} values, mean {:.1f}, p50 {:.0f}, p95 {:.0f}, p99 {:.0f}, max {:.0f}",
+                              stat->name_,
+                              summary.count,
+                              summary.mean,
+                              summary.p50,
+                              summary.p95,
+                              summary.p99,
+                              summary.max);
+        }
+    }
+}
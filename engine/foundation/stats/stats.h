@@ -0,0 +1,216 @@
+#pragma once
+
+#include "foundation/timer/timer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace muggle
+{
+
+// Counts of values in buckets whose width grows with the value, as in HDR histograms: the values below
+// kSubBucketCount have a bucket each, above that every power of two is split in kSubBucketCount buckets, so a
+// bucket is at most 1 / kSubBucketCount of its values wide. Values are recorded with relaxed atomic increments,
+// from any thread.
+class StatHistogram {
+public:
+    static constexpr uint32_t kSubBucketBits  = 5;
+    static constexpr uint32_t kSubBucketCount = 1u << kSubBucketBits;
+    static constexpr uint32_t kMaxExponent    = 43; // larger values are counted in the last bucket
+    static constexpr uint32_t kBucketCount    = (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+    StatHistogram()
+    {
+        reset();
+    }
+
+    StatHistogram(const StatHistogram&)            = delete;
+    StatHistogram& operator=(const StatHistogram&) = delete;
+
+    void record(uint64_t value)
+    {
+        counts_[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t min = min_.load(std::memory_order_relaxed);
+        while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed))
+        {
+        }
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Not synchronized with record, values recorded meanwhile may be half counted
+    void reset();
+
+    static uint32_t getBucket(uint64_t value)
+    {
+        if (value < kSubBucketCount)
+            return static_cast<uint32_t>(value);
+
+        const uint32_t exponent = 63 - static_cast<uint32_t>(countLeadingZeros(value));
+        if (exponent > kMaxExponent)
+            return kBucketCount - 1;
+
+        // the kSubBucketBits + 1 highest bits, the first of which is always set
+        const uint64_t mantissa = value >> (exponent - kSubBucketBits);
+        return (exponent - kSubBucketBits + 1) * kSubBucketCount + static_cast<uint32_t>(mantissa - kSubBucketCount);
+    }
+
+    // The smallest value counted in the bucket
+    static uint64_t getBucketValue(uint32_t bucket)
+    {
+        if (bucket < kSubBucketCount)
+            return bucket;
+
+        const uint32_t exponent = bucket / kSubBucketCount + kSubBucketBits - 1;
+        const uint64_t mantissa = kSubBucketCount + bucket % kSubBucketCount;
+        return mantissa << (exponent - kSubBucketBits);
+    }
+
+private:
+    friend class Stat;
+
+    static int countLeadingZeros(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+    std::atomic<uint32_t> counts_[kBucketCount]; // the number of values is their sum
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+enum class StatUnit
+{
+    Time,  // Timer ticks, summarized in milliseconds
+    Count, // anything else, summarized as it is
+};
+
+// The distribution of the values of a stat over some intervals
+struct StatSummary
+{
+    uint64_t count = 0;
+    double   mean  = 0.0;
+    double   min   = 0.0;
+    double   p50   = 0.0;
+    double   p95   = 0.0;
+    double   p99   = 0.0;
+    double   max   = 0.0;
+};
+
+// A named series of values, such as frame times or draw calls, kept as a histogram per interval over a rolling
+// window of kWindowIntervals intervals. Stats are meant to be global objects, defined with MUGGLE_DEFINE_STAT,
+// and are found by name. Recording never locks; Stat::update, called once a frame, starts the next interval and
+// writes the stats to the log every dump interval.
+class Stat {
+public:
+    static constexpr size_t kWindowIntervals        = 10;
+    static constexpr double kDefaultIntervalSeconds = 1.0;
+
+    // 'name' must outlive the stat, a string literal does
+    explicit Stat(const char* name, StatUnit unit = StatUnit::Time);
+    ~Stat();
+
+    Stat(const Stat&)            = delete;
+    Stat& operator=(const Stat&) = delete;
+
+    // Ticks of Timer::getTicks for StatUnit::Time
+    void record(uint64_t value)
+    {
+        intervals_[interval_.load(std::memory_order_relaxed) % kIntervalSlots].record(value);
+    }
+
+    [[nodiscard]] const char* getName() const
+    {
+        return name_;
+    }
+
+    [[nodiscard]] StatUnit getUnit() const
+    {
+        return unit_;
+    }
+
+    // Over the last 'intervalCount' complete intervals, at most kWindowIntervals
+    [[nodiscard]] StatSummary getSummary(size_t intervalCount = kWindowIntervals) const;
+
+    // One summary for each complete interval of the window, oldest first
+    [[nodiscard]] std::vector<StatSummary> getIntervalSummaries() const;
+
+    // The stat with the given name, or nullptr
+    static Stat* find(std::string_view name);
+
+    static std::vector<Stat*> getStats();
+
+    // Start the next interval once the current one is over, and dump the stats when it is time to
+    static void update();
+
+    static void setIntervalSeconds(double seconds);
+
+    // Every 'seconds' seconds update writes the summary of each stat over that time to the log, 0 turns it off
+    static void setDumpSeconds(double seconds);
+
+    // Write the summary of each stat over its last 'intervalCount' intervals to the log
+    static void dump(size_t intervalCount = kWindowIntervals);
+
+private:
+    // the interval being recorded and the complete intervals of the window
+    static constexpr size_t kIntervalSlots = kWindowIntervals + 1;
+
+    StatSummary summarize(const uint64_t* counts, uint64_t count, uint64_t sum, uint64_t min, uint64_t max) const;
+
+    const char*   name_;
+    StatUnit      unit_;
+    StatHistogram intervals_[kIntervalSlots];
+
+    // shared by every stat, so they change interval together
+    static std::atomic<uint64_t> interval_;
+};
+
+// Records the time from its construction to its destruction, see MUGGLE_STAT_SCOPE
+class StatScope {
+public:
+    explicit StatScope(Stat& stat) : stat_(stat), begin_(Timer::getTicks())
+    {
+    }
+
+    ~StatScope()
+    {
+        stat_.record(Timer::getTicks() - begin_);
+    }
+
+    StatScope(const StatScope&)            = delete;
+    StatScope& operator=(const StatScope&) = delete;
+
+private:
+    Stat&    stat_;
+    uint64_t begin_;
+};
+
+} // namespace muggle
+
+#define MUGGLE_DECLARE_STAT(name) extern muggle::Stat name;
+
+#define MUGGLE_DEFINE_STAT(name, ...) muggle::Stat name(#name, ##__VA_ARGS__);
+
+#define MUGGLE_STAT_CONCAT_IMPL(a, b) a##b
+#define MUGGLE_STAT_CONCAT(a, b) MUGGLE_STAT_CONCAT_IMPL(a, b)
+
+// Record the time the rest of the enclosing scope takes into 'stat'
+#define MUGGLE_STAT_SCOPE(stat) muggle::StatScope MUGGLE_STAT_CONCAT(muggleStatScope, __LINE__)(stat);
@@ -0,0 +1,124 @@
+#include "foundation/thread/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace muggle
+{
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+
+    workers_.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+            // drain the queue before stopping so nobody waits on a task that never runs
+            if (tasks_.empty())
+                return;
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t index)>& body)
+{
+    struct Work
+    {
+        std::atomic<size_t>     next {0};
+        size_t                  done = 0;
+        std::mutex              mutex;
+        std::condition_variable finished;
+    };
+
+    if (count == 0)
+        return;
+
+    // helpers may only get to run once everything is done, so they do not touch 'body' after that
+    auto work = std::make_shared<Work>();
+
+    auto run = [work, count, &body]() {
+        size_t completed = 0;
+        for (size_t index = work->next.fetch_add(1); index < count; index = work->next.fetch_add(1))
+        {
+            body(index);
+            ++completed;
+        }
+
+        if (completed > 0)
+        {
+            std::lock_guard<std::mutex> lock(work->mutex);
+            work->done += completed;
+            if (work->done == count)
+            {
+                work->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min<size_t>(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        post(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(work->mutex);
+    work->finished.wait(lock, [&work, count]() { return work->done == count; });
+}
+
+ThreadPool& ThreadPool::getIoPool()
+{
+    static ThreadPool pool(std::clamp(std::thread::hardware_concurrency() * 2, 4u, 16u));
+    return pool;
+}
+
+ThreadPool& ThreadPool::getWorkerPool()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+} // namespace muggle
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace muggle
+{
+
+// A fixed size pool of worker threads executing tasks in FIFO order
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] uint32_t getThreadCount() const
+    {
+        return static_cast<uint32_t>(workers_.size());
+    }
+
+    // Queue a task without any way to wait for it
+    void post(std::function<void()> task);
+
+    // Queue a task and get a future for its result
+    template<typename F>
+    auto enqueue(F&& f) -> std::future<std::invoke_result_t<F>>
+    {
+        using result_t = std::invoke_result_t<F>;
+
+        auto task   = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        post([task]() { (*task)(); });
+        return future;
+    }
+
+    // Run body(0) .. body(count - 1) on the pool and return once all of them are done.
+    // The calling thread runs its share of the calls, so this is safe to use from a task of the same pool.
+    void parallelFor(size_t count, const std::function<void(size_t index)>& body);
+
+    // Shared pool for blocking file I/O, sized for latency hiding rather than for the number of cores
+    static ThreadPool& getIoPool();
+
+    // Shared pool for CPU bound work, such as decompression, with one thread per core
+    static ThreadPool& getWorkerPool();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread>          workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex                        mutex_;
+    std::condition_variable           condition_;
+    bool                              stopping_ = false;
+};
+
+} // namespace muggle
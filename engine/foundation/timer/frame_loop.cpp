@@ -0,0 +1,146 @@
+#include "foundation/timer/frame_loop.h"
+#include "foundation/stats/stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace muggle;
+
+namespace
+{
+
+MUGGLE_DEFINE_STAT(FrameTime)
+MUGGLE_DEFINE_STAT(FrameJitter)
+
+// The sleep estimate follows the last this many sleeps, so it adapts when the system gets busier or idler
+constexpr uint64_t kSleepHistory = 1000;
+
+uint64_t toTicks(double seconds, double ticksPerSecond)
+{
+    return static_cast<uint64_t>(std::llround(seconds * ticksPerSecond));
+}
+
+uint64_t getDifference(uint64_t a, uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+FrameLoop::FrameLoop() : ticksPerSecond_(Timer().getFrequency())
+{
+    fixedStepTicks_ = toTicks(kDefaultFixedStepSeconds, ticksPerSecond_);
+}
+
+void FrameLoop::setFixedStepSeconds(double seconds)
+{
+    fixedStepTicks_ = std::max<uint64_t>(toTicks(seconds, ticksPerSecond_), 1);
+}
+
+void FrameLoop::setMaxStepsPerFrame(uint32_t steps)
+{
+    maxStepsPerFrame_ = std::max<uint32_t>(steps, 1);
+}
+
+void FrameLoop::setMaxFrameRate(double framesPerSecond)
+{
+    periodTicks_ = framesPerSecond > 0.0 ? toTicks(1.0 / framesPerSecond, ticksPerSecond_) : 0;
+}
+
+void FrameLoop::beginFrame()
+{
+    const uint64_t now = Timer::getTicks();
+
+    if (frameIndex_ == 0)
+    {
+        frameBegin_ = now;
+        deadline_   = now;
+    }
+
+    const uint64_t frameTicks = now - frameBegin_;
+    jitterTicks_              = getDifference(frameTicks, periodTicks_ > 0 ? periodTicks_ : frameTicks_);
+    frameTicks_               = frameTicks;
+    frameBegin_               = now;
+    frameSteps_               = 0;
+
+    accumulatedTicks_ += std::min(frameTicks, toTicks(kMaxFrameSeconds, ticksPerSecond_));
+
+    // the first frame has no previous one to be timed from, nor the second a frame time to be compared to
+    if (frameIndex_++ > 1)
+    {
+        FrameTime.record(frameTicks_);
+        FrameJitter.record(jitterTicks_);
+    }
+
+    Stat::update();
+}
+
+bool FrameLoop::step()
+{
+    if (accumulatedTicks_ < fixedStepTicks_)
+        return false;
+
+    if (frameSteps_ == maxStepsPerFrame_)
+    {
+        // the simulation cannot keep up, it falls behind real time rather than taking ever longer frames
+        accumulatedTicks_ %= fixedStepTicks_;
+        return false;
+    }
+
+    accumulatedTicks_ -= fixedStepTicks_;
+    ++frameSteps_;
+    ++stepCount_;
+    return true;
+}
+
+void FrameLoop::endFrame()
+{
+    if (periodTicks_ == 0)
+        return;
+
+    // the deadlines are a period apart, so the frames keep to the rate on average, unless a frame is so late that
+    // the next would be too
+    deadline_ += periodTicks_;
+
+    const uint64_t now = Timer::getTicks();
+    if (now > deadline_ + periodTicks_)
+    {
+        deadline_ = now;
+        return;
+    }
+
+    waitUntil(deadline_);
+}
+
+void FrameLoop::waitUntil(uint64_t deadline)
+{
+    // sleep 1 ms at a time while a sleep, as long as they have taken with some margin, ends before the deadline
+    for (;;)
+    {
+        const uint64_t now = Timer::getTicks();
+        if (now >= deadline)
+            return;
+
+        const double remaining = static_cast<double>(deadline - now) / ticksPerSecond_;
+        if (remaining <= sleepMean_ + std::sqrt(sleepVariance_))
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        const double slept = static_cast<double>(Timer::getTicks() - now) / ticksPerSecond_;
+
+        // Welford's running mean and variance
+        sleepCount_        = std::min(sleepCount_ + 1, kSleepHistory);
+        const double delta = slept - sleepMean_;
+        sleepMean_ += delta / static_cast<double>(sleepCount_);
+        sleepVariance_ += (delta * (slept - sleepMean_) - sleepVariance_) / static_cast<double>(sleepCount_);
+    }
+
+    // the last stretch is too short to sleep precisely
+    while (Timer::getTicks() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "foundation/timer/timer.h"
+
+#include <cstdint>
+
+namespace muggle
+{
+
+// Drives the main loop of an application: the simulation advances in fixed steps, as many as the time since the
+// last frame holds, and is drawn interpolated between its last two steps; the frame rate can be capped, waiting
+// the end of each frame out with sleeps and a short spin to be both precise and idle most of the time.
+//
+//     FrameLoop frameLoop;
+//     while (!glfwWindowShouldClose(window))
+//     {
+//         glfwPollEvents();
+//         frameLoop.beginFrame();
+//         while (frameLoop.step())
+//             simulate(frameLoop.getFixedStepSeconds());
+//         render(frameLoop.getInterpolation());
+//         frameLoop.endFrame();
+//     }
+//
+// Frame times and pacing jitter, how far a frame time is from the cap's period or from the previous frame time
+// when uncapped, go to the stats "FrameTime" and "FrameJitter". beginFrame also calls Stat::update.
+class FrameLoop {
+public:
+    static constexpr double   kDefaultFixedStepSeconds = 1.0 / 60.0;
+    static constexpr uint32_t kDefaultMaxStepsPerFrame = 8;
+
+    // Longer frames, after a breakpoint or a hitch, count as this long, so the simulation does not try to catch up
+    static constexpr double kMaxFrameSeconds = 0.25;
+
+    FrameLoop();
+
+    void setFixedStepSeconds(double seconds);
+
+    [[nodiscard]] double getFixedStepSeconds() const
+    {
+        return static_cast<double>(fixedStepTicks_) / ticksPerSecond_;
+    }
+
+    // Steps a frame can take at most; when the simulation is slower than real time, the steps over are dropped
+    void setMaxStepsPerFrame(uint32_t steps);
+
+    // Frames per second, 0 for no cap
+    void setMaxFrameRate(double framesPerSecond);
+
+    void beginFrame();
+
+    // Whether the simulation takes another fixed step this frame
+    bool step();
+
+    // How far the frame is from the last step to the next, in [0, 1)
+    [[nodiscard]] double getInterpolation() const
+    {
+        return static_cast<double>(accumulatedTicks_) / static_cast<double>(fixedStepTicks_);
+    }
+
+    // Time between the beginnings of this frame and the previous one
+    [[nodiscard]] double getFrameSeconds() const
+    {
+        return static_cast<double>(frameTicks_) / ticksPerSecond_;
+    }
+
+    [[nodiscard]] double getJitterSeconds() const
+    {
+        return static_cast<double>(jitterTicks_) / ticksPerSecond_;
+    }
+
+    // Simulated time, the fixed steps taken so far
+    [[nodiscard]] double getSimulationSeconds() const
+    {
+        return static_cast<double>(stepCount_) * getFixedStepSeconds();
+    }
+
+    [[nodiscard]] uint64_t getFrameIndex() const
+    {
+        return frameIndex_;
+    }
+
+    // Wait for the time of the next frame when the frame rate is capped
+    void endFrame();
+
+private:
+    void waitUntil(uint64_t deadline);
+
+    double ticksPerSecond_;
+
+    uint64_t fixedStepTicks_;
+    uint32_t maxStepsPerFrame_ = kDefaultMaxStepsPerFrame;
+    uint64_t periodTicks_      = 0;
+
+    uint64_t frameIndex_       = 0;
+    uint64_t frameBegin_       = 0;
+    uint64_t frameTicks_       = 0;
+    uint64_t jitterTicks_      = 0;
+    uint64_t deadline_         = 0;
+    uint64_t accumulatedTicks_ = 0;
+    uint64_t stepCount_        = 0;
+    uint32_t frameSteps_       = 0;
+
+    // how long a 1 ms sleep takes: the mean and variance of the sleeps so far
+    double   sleepMean_     = 0.002;
+    double   sleepVariance_ = 0.0;
+    uint64_t sleepCount_    = 1;
+};
+
+} // namespace muggle
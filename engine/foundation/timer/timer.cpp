@@ -5,19 +5,115 @@
 #include <Windows.h>
 #else
 #include <time.h>
+#ifdef MUGGLE_TIMER_TSC
+#include <cpuid.h>
+#endif
 #endif
 
 namespace muggle
 {
-    Timer::Timer()
+    namespace
     {
-#if defined(_MSC_VER)
-        LARGE_INTEGER frequency;
-        QueryPerformanceFrequency(&frequency);
-        ticksPerSecond_ = frequency.QuadPart;
-        secondsPerTick_ = 1.0 / ticksPerSecond_;
+        struct TickSource
+        {
+            Timer::Source source;
+            std::uint64_t ticksPerSecond;
+        };
 
+#if !defined(_MSC_VER)
+        std::uint64_t getMonotonicNanoseconds()
+        {
+            timespec time;
+#ifdef CLOCK_MONOTONIC_RAW
+            clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+#else
+            clock_gettime(CLOCK_MONOTONIC, &time);
 #endif
+            return static_cast<std::uint64_t>(time.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(time.tv_nsec);
+        }
+#endif
+
+#ifdef MUGGLE_TIMER_TSC
+        // Only a TSC that ticks at a constant rate in every power state, and is synchronized between cores, can be
+        // used as a clock
+        bool hasInvariantTsc()
+        {
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+                return false;
+
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+        }
+
+        // Count TSC ticks over a short wait timed by the monotonic clock, the median of a few rounds
+        std::uint64_t calibrateTsc()
+        {
+            constexpr int kRounds = 5;
+            constexpr std::uint64_t kRoundNanoseconds = 5000000;
+
+            std::uint64_t frequencies[kRounds];
+            for (int round = 0; round < kRounds; ++round)
+            {
+                const std::uint64_t startTime = getMonotonicNanoseconds();
+                const std::uint64_t startTsc = __rdtsc();
+
+                std::uint64_t time = startTime;
+                while (time - startTime < kRoundNanoseconds)
+                {
+                    time = getMonotonicNanoseconds();
+                }
+                const std::uint64_t tsc = __rdtsc();
+
+                frequencies[round] = static_cast<std::uint64_t>(static_cast<double>(tsc - startTsc) * 1e9 /
+                                                                static_cast<double>(time - startTime));
+            }
+
+            for (int i = 1; i < kRounds; ++i)
+            {
+                for (int j = i; j > 0 && frequencies[j] < frequencies[j - 1]; --j)
+                {
+                    const std::uint64_t swap = frequencies[j];
+                    frequencies[j] = frequencies[j - 1];
+                    frequencies[j - 1] = swap;
+                }
+            }
+
+            return frequencies[kRounds / 2];
+        }
+#endif
+
+        TickSource selectTickSource()
+        {
+#if defined(_MSC_VER)
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            return { Timer::Source::QueryPerformanceCounter, static_cast<std::uint64_t>(frequency.QuadPart) };
+#else
+#ifdef MUGGLE_TIMER_TSC
+            if (hasInvariantTsc())
+            {
+                const std::uint64_t frequency = calibrateTsc();
+                if (frequency > 0)
+                    return { Timer::Source::Tsc, frequency };
+            }
+#endif
+            return { Timer::Source::MonotonicRaw, 1000000000ull };
+#endif
+        }
+
+        // Chosen at the first use, every Timer has to count the same ticks
+        const TickSource& getTickSource()
+        {
+            static const TickSource source = selectTickSource();
+            return source;
+        }
+    }
+
+    Timer::Timer()
+    {
+        ticksPerSecond_ = getTickSource().ticksPerSecond;
+        secondsPerTick_ = 1.0 / static_cast<double>(ticksPerSecond_);
 
         reset();
     }
@@ -37,17 +133,35 @@ namespace muggle
         LARGE_INTEGER counter;
         QueryPerformanceCounter(&counter);
         return counter.QuadPart;
+#else
+#ifdef MUGGLE_TIMER_TSC
+        if (getTickSource().source == Source::Tsc)
+        {
+            // lets getTicksFast read the TSC directly from now on
+            if (!sTscSelected_.load(std::memory_order_relaxed))
+            {
+                sTscSelected_.store(true, std::memory_order_relaxed);
+            }
+            return __rdtsc();
+        }
+#endif
+        return getMonotonicNanoseconds();
 #endif
     }
 
     double Timer::getSeconds() const
     {
-        return (static_cast<double>(getTicks()) * secondsPerTick_) + startSceondsNegated_ ;
+        // relative to the start, as a double would lose the low bits of a TSC counting since boot
+        return static_cast<double>(getTicks() - startTicks_) * secondsPerTick_;
     }
 
     void Timer::reset()
     {
-        startSceondsNegated_ = 0;
-        startSceondsNegated_ = -getSeconds();
+        startTicks_ = getTicks();
+    }
+
+    Timer::Source Timer::getSource()
+    {
+        return getTickSource().source;
     }
-}
\ No newline at end of file
+}
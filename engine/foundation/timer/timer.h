@@ -1,25 +1,54 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)) && !defined(MUGGLE_TIMER_NO_TSC)
+#define MUGGLE_TIMER_TSC
+#include <x86intrin.h>
+#endif
+
 namespace muggle
 {
     class Timer
     {
         public:
+            // Where the ticks come from, chosen once for the whole process
+            enum class Source
+            {
+                QueryPerformanceCounter,
+                MonotonicRaw, // clock_gettime(CLOCK_MONOTONIC_RAW), ticks are nanoseconds
+                Tsc,          // rdtsc on an invariant TSC, calibrated against MonotonicRaw at first use
+            };
+
             Timer();
             virtual ~Timer();
 
             double getFrequency() const;
             static std::uint64_t getTicks();
+
+            // Same ticks as getTicks, inlined for hot paths such as profiler zones: once getTicks has seen that
+            // the source is the TSC, this is a bare rdtsc
+            static std::uint64_t getTicksFast()
+            {
+#ifdef MUGGLE_TIMER_TSC
+                if (sTscSelected_.load(std::memory_order_relaxed))
+                    return __rdtsc();
+#endif
+                return getTicks();
+            }
             double getSeconds() const;
 
             void reset();
 
+            static Source getSource();
+
         private:
             std::uint64_t ticksPerSecond_ { 0 };
             double secondsPerTick_ { 0.0 };
-            double startSceondsNegated_ {0.0};
+            std::uint64_t startTicks_ { 0 };
+
+            static inline std::atomic<bool> sTscSelected_ { false };
 
     };
-}
\ No newline at end of file
+}
@@ -641,14 +641,17 @@ glTF::glTF gltfLoadFile(const char* filename)
 {
     glTF::glTF gltfData {};
 
-    if (!gFileSystem->isFileExists(filename))
+    // readFile fails on missing files anyway, checking for them first would only add a lookup
+    auto fileBlob = gFileSystem->readFile(filename);
+    if (!fileBlob)
     {
         LOG_ERROR("Error: file {} not found", filename);
         return gltfData;
     }
 
-    auto           fileBlob = gFileSystem->readFile(filename);
-    nlohmann::json jsonData = nlohmann::json::parse((char*)fileBlob->data());
+    // blobs are not null terminated (mapped ones in particular), so parse by range
+    const char*    fileData = static_cast<const char*>(fileBlob->data());
+    nlohmann::json jsonData = nlohmann::json::parse(fileData, fileData + fileBlob->size());
 
     for (auto propertis : jsonData.items())
     {
@@ -788,6 +791,102 @@ void gltfFree(glTF::glTF& scene)
     }
 }
 
+uint32_t gltfCheckDependencies(const char* filename, const glTF::glTF& gltf)
+{
+    std::filesystem::path              directory = std::filesystem::path(filename).parent_path();
+    std::vector<std::filesystem::path> paths;
+
+    auto addUri = [&](const std::string& uri) {
+        if (!uri.empty() && uri.rfind("data:", 0) != 0)
+        {
+            paths.push_back(directory / uri);
+        }
+    };
+
+    for (uint32_t i = 0; i < gltf.buffersCount; ++i)
+    {
+        addUri(gltf.buffers[i].uri);
+    }
+
+    for (uint32_t i = 0; i < gltf.imagesCount; ++i)
+    {
+        addUri(gltf.images[i].uri);
+    }
+
+    uint32_t missingCount = 0;
+
+    std::vector<vfs::FileStat> stats = gFileSystem->getFileStats(paths);
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        if (!stats[i].isFile())
+        {
+            LOG_ERROR("Error: {} referenced by {} not found", paths[i].string(), filename);
+            ++missingCount;
+        }
+    }
+
+    return missingCount;
+}
+
+std::shared_ptr<vfs::IBlob> gltfLoadBufferData(const char* filename, const glTF::Buffer& buffer)
+{
+    if (buffer.uri.empty() || buffer.uri.rfind("data:", 0) == 0)
+    {
+        LOG_ERROR("Error: buffer {} of {} is not an external file", buffer.name, filename);
+        return nullptr;
+    }
+
+    std::filesystem::path bufferPath = std::filesystem::path(filename).parent_path() / buffer.uri;
+    return gFileSystem->readFile(bufferPath);
+}
+
+std::shared_ptr<vfs::IBlob> gltfGetBufferViewData(const glTF::BufferView&            bufferView,
+                                                  const std::shared_ptr<vfs::IBlob>& bufferData)
+{
+    size_t offset = bufferView.byteOffset == glTF::kInvalidIntValue ? 0 : bufferView.byteOffset;
+    return vfs::BlobView::slice(bufferData, offset, bufferView.byteLength);
+}
+
+static size_t getAccessorElementSize(const glTF::Accessor& accessor)
+{
+    size_t componentSize = 4;
+    switch (accessor.componentType)
+    {
+        case glTF::Accessor::ComponentType::BYTE:
+        case glTF::Accessor::ComponentType::UNSIGNED_BYTE:
+            componentSize = 1;
+            break;
+        case glTF::Accessor::ComponentType::SHORT:
+        case glTF::Accessor::ComponentType::UNSIGNED_SHORT:
+            componentSize = 2;
+            break;
+        default:
+            break;
+    }
+
+    static const size_t componentCounts[] = {1, 2, 3, 4, 4, 9, 16}; // indexed by glTF::Accessor::Type
+    return componentSize * componentCounts[static_cast<size_t>(accessor.type)];
+}
+
+std::shared_ptr<vfs::IBlob> gltfGetAccessorData(const glTF::Accessor&              accessor,
+                                                const glTF::BufferView&            bufferView,
+                                                const std::shared_ptr<vfs::IBlob>& bufferData)
+{
+    if (accessor.count <= 0)
+        return nullptr;
+
+    const size_t elementSize = getAccessorElementSize(accessor);
+    const bool   hasStride   = bufferView.byteStride != glTF::kInvalidIntValue && bufferView.byteStride > 0;
+    const size_t stride      = hasStride ? static_cast<size_t>(bufferView.byteStride) : elementSize;
+    const size_t size        = stride * (accessor.count - 1) + elementSize;
+
+    size_t offset = glTF::getDataOffset(accessor.byteOffset, bufferView.byteOffset);
+    if (offset + size > static_cast<size_t>(bufferView.byteLength) + glTF::getDataOffset(0, bufferView.byteOffset))
+        return nullptr;
+
+    return vfs::BlobView::slice(bufferData, offset, size);
+}
+
 int32_t gltfGetAttributeAccessorIndex(const glTF::MeshPrimitive::Attribute* attributes,
                                       uint32_t                              attributeCount,
                                       std::string                           attributeName)
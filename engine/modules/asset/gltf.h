@@ -3,10 +3,16 @@
 #include <cstdint>
 #include <cassert>
 #include <limits>
+#include <memory>
 #include <string>
 
 namespace muggle
 {
+namespace vfs
+{
+class IBlob;
+}
+
 namespace glTF
 {
     static const int32_t kInvalidIntValue = 0x7fffffff;
@@ -383,6 +389,22 @@ namespace glTF
     glTF::glTF gltfLoadFile(const char* filename);
     void gltfFree(glTF::glTF* gltf);
 
+    // Check that the external files of the buffers and images of 'gltf', loaded from 'filename', exist,
+    // with a single batch of stats. Returns the number of missing files, which are logged.
+    uint32_t gltfCheckDependencies(const char* filename, const glTF::glTF& gltf);
+
+    // Read the data of a buffer of the glTF file 'filename', with the VFS so that large files are mapped.
+    // Returns nullptr if it cannot be read; embedded data URIs are not supported.
+    std::shared_ptr<vfs::IBlob> gltfLoadBufferData(const char* filename, const glTF::Buffer& buffer);
+
+    // The bytes of a buffer view, or the bytes an accessor covers in its buffer view, as views into the
+    // buffer data: they never copy it and keep it alive. Returns nullptr if the range is out of bounds.
+    std::shared_ptr<vfs::IBlob> gltfGetBufferViewData(const glTF::BufferView&            bufferView,
+                                                      const std::shared_ptr<vfs::IBlob>& bufferData);
+    std::shared_ptr<vfs::IBlob> gltfGetAccessorData(const glTF::Accessor&              accessor,
+                                                    const glTF::BufferView&            bufferView,
+                                                    const std::shared_ptr<vfs::IBlob>& bufferData);
+
     int32_t gltfGetAttributeAccessorIndex(
         const glTF::MeshPrimitive::Attribute* attributes,
         uint32_t attributeCount,
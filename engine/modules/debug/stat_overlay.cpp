@@ -0,0 +1,72 @@
+#include "modules/debug/stat_overlay.h"
+#include "foundation/stats/stats.h"
+
+#include <imgui.h>
+
+#include <cfloat>
+
+namespace muggle
+{
+
+void drawStatOverlay(bool* open)
+{
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    if (!ImGui::Begin("Stats", open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing))
+    {
+        ImGui::End();
+        return;
+    }
+
+    constexpr ImGuiTableFlags kTableFlags =
+        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+
+    if (ImGui::BeginTable("stats", 8, kTableFlags))
+    {
+        ImGui::TableSetupColumn("Stat");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Mean");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("p99 per interval");
+        ImGui::TableHeadersRow();
+
+        float history[Stat::kWindowIntervals];
+        for (const Stat* stat : Stat::getStats())
+        {
+            const StatSummary summary = stat->getSummary();
+            const char*       format  = stat->getUnit() == StatUnit::Time ? "%.3f ms" : "%.0f";
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(stat->getName());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(summary.count));
+
+            for (double value : {summary.mean, summary.p50, summary.p95, summary.p99, summary.max})
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text(format, value);
+            }
+
+            const auto intervals = stat->getIntervalSummaries();
+            int        count     = 0;
+            for (const auto& interval : intervals)
+            {
+                history[count++] = static_cast<float>(interval.p99);
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::PushID(stat);
+            ImGui::PlotLines("", history, count, 0, nullptr, 0.0f, FLT_MAX, ImVec2(120.0f, ImGui::GetTextLineHeight()));
+            ImGui::PopID();
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+} // namespace muggle
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace muggle
+{
+
+// An ImGui window with the p50/p95/p99 of every stat over its window, and the p99 of each interval as a graph.
+// Call between ImGui::NewFrame and ImGui::Render; 'open', if given, gets a close button.
+void drawStatOverlay(bool* open = nullptr);
+
+} // namespace muggle
@@ -8,6 +8,7 @@
 #include <cstdlib>
 
 #include "muggle.h"
+#include "foundation/timer/frame_loop.h"
 
 static const char* shaderCodeVertex = R"(
 #version 460 core
@@ -134,16 +135,29 @@ int main(void)
     glEnable(GL_POLYGON_OFFSET_LINE);
     glPolygonOffset(-1.f, -1.f);
 
+    // the cube turns at a fixed step, and is drawn between its last two steps
+    muggle::FrameLoop frameLoop;
+    float             angle         = 0.f;
+    float             previousAngle = 0.f;
+
     while (!glfwWindowShouldClose(window))
     {
+        frameLoop.beginFrame();
+        while (frameLoop.step())
+        {
+            previousAngle = angle;
+            angle += static_cast<float>(frameLoop.getFixedStepSeconds());
+        }
+
         int width, height;
         glfwGetFramebufferSize(window, &width, &height);
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         const float     ratio = static_cast<float>(width) / static_cast<float>(height);
+        const float     turn  = glm::mix(previousAngle, angle, static_cast<float>(frameLoop.getInterpolation()));
         const glm::mat4 m     = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.f, 0.f, -3.5f)),
-                                        static_cast<float>(glfwGetTime()),
+                                        turn,
                                         glm::vec3(1.f, 1.f, 1.f));
         const glm::mat4 p     = glm::perspective(45.f, ratio, 0.1f, 1000.f);
 
@@ -164,6 +178,7 @@ int main(void)
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        frameLoop.endFrame();
     }
 
     glDeleteBuffers(1, &perFrameDataBuf);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// Wall clock stopwatch used by the benchmarks
+class Stopwatch {
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now())
+    {}
+
+    [[nodiscard]] double elapsedMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+void runAsyncReadBenchmark();
+void runMountBenchmark();
+void runEnumerateBenchmark();
+void runPatternBenchmark();
+void runHashBenchmark();
+void runCompressedBenchmark();
+void runLogBenchmark();
+void runTimerBenchmark();
+void runProfilerBenchmark();
+void runStatsBenchmark();
+void runFrameLoopBenchmark();
@@ -0,0 +1,91 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/compressed_file_system.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+void runCompressedBenchmark()
+{
+    constexpr size_t kFileSize   = 64 * 1024 * 1024;
+    constexpr size_t kRangeSize  = 64 * 1024;
+    constexpr int    kIterations = 5;
+
+    if (!muggle::compression::isCodecAvailable(muggle::compression::Codec::Zlib))
+    {
+        printf("zlib is not available\n");
+        return;
+    }
+
+    // smooth values with some noise, which compress to about half of their size like typical vertex data
+    std::vector<uint8_t> data(kFileSize);
+    uint32_t             noise = 1;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        noise   = noise * 1664525u + 1013904223u;
+        data[i] = static_cast<uint8_t>((i % 4096) / 16 + ((noise >> 29) & (noise >> 26) & 3));
+    }
+
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "muggle_compressed_benchmark";
+    std::filesystem::create_directories(root);
+
+    auto nativeFS =
+        std::make_shared<muggle::vfs::RelativeFileSystem>(std::make_shared<muggle::vfs::NativeFileSystem>(), root);
+    auto compressedFS =
+        std::make_shared<muggle::vfs::CompressedFileSystem>(nativeFS, muggle::compression::Codec::Zlib);
+
+    nativeFS->writeFile("plain.bin", data.data(), data.size());
+    compressedFS->writeFile("compressed.bin", data.data(), data.size());
+
+    // the same data as a single zlib stream, which can only be decompressed by one thread
+    std::vector<uint8_t> stream;
+    muggle::compression::compress(muggle::compression::Codec::Zlib, data.data(), data.size(), stream);
+
+    printf("%zu MB file, %zu MB compressed in chunks of %u KB\n",
+           kFileSize >> 20,
+           static_cast<size_t>(nativeFS->getFileStat("compressed.bin.mcz").size >> 20),
+           muggle::vfs::chunked::kDefaultChunkSize / 1024);
+
+    // every read gets a new buffer, as readFile does
+    Stopwatch plain;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[kFileSize]);
+        nativeFS->readFileInto("plain.bin", buffer.get(), kFileSize, 0);
+    }
+    const double plainMs = plain.elapsedMilliseconds() / kIterations;
+
+    Stopwatch single;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[kFileSize]);
+        muggle::compression::decompress(
+            muggle::compression::Codec::Zlib, stream.data(), stream.size(), buffer.get(), kFileSize);
+    }
+    const double singleMs = single.elapsedMilliseconds() / kIterations;
+
+    Stopwatch chunked;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        auto blob = compressedFS->readFile("compressed.bin");
+    }
+    const double chunkedMs = chunked.elapsedMilliseconds() / kIterations;
+
+    Stopwatch range;
+    for (int i = 0; i < kIterations * 100; ++i)
+    {
+        const uint64_t offset = (i * 7919 * kRangeSize) % (kFileSize - kRangeSize);
+        auto           blob   = compressedFS->readRange("compressed.bin", offset, kRangeSize);
+    }
+    const double rangeUs = range.elapsedMilliseconds() * 1000.0 / (kIterations * 100);
+
+    printf("uncompressed readFileInto (page cache):   %8.2f ms\n", plainMs);
+    printf("single zlib stream, one thread:           %8.2f ms\n", singleMs);
+    printf("chunked readFile, parallel decompression: %8.2f ms\n", chunkedMs);
+    printf("chunked readRange of %zu KB:               %8.2f us\n", kRangeSize / 1024, rangeUs);
+
+    std::filesystem::remove_all(root);
+}
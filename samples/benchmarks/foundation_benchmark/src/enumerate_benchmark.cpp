@@ -0,0 +1,128 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/vfs.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <glob.h>
+#endif
+
+namespace
+{
+
+const std::vector<std::string> kExtensions = {".png", ".gltf", ".bin", ".spv"};
+
+// 100 directories of 1000 files each, in two levels, spread over the extensions above and some others.
+// The tree is kept in the temp directory and reused by later runs.
+std::filesystem::path createContentTree()
+{
+    constexpr int kTopDirectories    = 10;
+    constexpr int kSubDirectories    = 10;
+    constexpr int kFilesPerDirectory = 1000;
+
+    const char* const extensions[] = {".png", ".gltf", ".bin", ".spv", ".txt", ".json"};
+
+    std::filesystem::path root   = std::filesystem::temp_directory_path() / "muggle_enumerate_benchmark";
+    std::filesystem::path marker = root / "complete";
+    if (std::filesystem::exists(marker))
+        return root;
+
+    printf("creating %d files in %s\n", kTopDirectories * kSubDirectories * kFilesPerDirectory, root.string().c_str());
+
+    for (int top = 0; top < kTopDirectories; ++top)
+    {
+        for (int sub = 0; sub < kSubDirectories; ++sub)
+        {
+            std::filesystem::path directory =
+                root / ("package_" + std::to_string(top)) / ("assets_" + std::to_string(sub));
+            std::filesystem::create_directories(directory);
+
+            for (int i = 0; i < kFilesPerDirectory; ++i)
+            {
+                std::ofstream(directory / ("file_" + std::to_string(i) + extensions[i % std::size(extensions)]));
+            }
+        }
+    }
+
+    std::ofstream(marker).put('\n');
+    return root;
+}
+
+#ifndef WIN32
+// Enumeration as NativeFileSystem did it before: one glob per extension, then a stat per match
+int enumerateWithGlob(const std::filesystem::path&    path,
+                      const std::vector<std::string>& extensions,
+                      std::vector<std::string>&       files)
+{
+    int numEntries = 0;
+
+    for (const auto& ext : extensions)
+    {
+        std::string pattern = (path / ("*" + ext)).generic_string();
+
+        glob64_t globMatches;
+        if (glob64(pattern.c_str(), 0, nullptr, &globMatches) == 0)
+        {
+            for (size_t i = 0; i < globMatches.gl_pathc; ++i)
+            {
+                std::error_code                  ec, ec2;
+                std::filesystem::directory_entry entry(globMatches.gl_pathv[i], ec);
+                if (!ec && !entry.is_directory(ec2) && !ec2)
+                {
+                    files.push_back(entry.path().filename().string());
+                    ++numEntries;
+                }
+            }
+            globfree64(&globMatches);
+        }
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(path))
+    {
+        if (entry.is_directory())
+        {
+            numEntries += enumerateWithGlob(entry.path(), extensions, files);
+        }
+    }
+
+    return numEntries;
+}
+#endif
+
+} // namespace
+
+// Find the files with a few extensions in a 100k file tree: the old glob based walk, the single pass
+// scanner walked one directory at a time, and the parallel recursive scan
+void runEnumerateBenchmark()
+{
+    std::filesystem::path root = createContentTree();
+
+    muggle::vfs::NativeFileSystem fs;
+
+#ifndef WIN32
+    std::vector<std::string> globFiles;
+    Stopwatch                glob;
+    int                      globCount = enumerateWithGlob(root, kExtensions, globFiles);
+    const double             globMs    = glob.elapsedMilliseconds();
+    printf("glob per extension:      %8.1f ms (%d files)\n", globMs, globCount);
+#endif
+
+    // the base class walks the tree one enumerateFiles call per directory
+    std::vector<std::string> sequentialFiles;
+    Stopwatch                sequential;
+    int                      sequentialCount =
+        fs.IFileSystem::enumerateFilesRecursive(root, kExtensions, muggle::vfs::enumerate_to_vector(sequentialFiles));
+    const double sequentialMs = sequential.elapsedMilliseconds();
+    printf("single pass, per folder: %8.1f ms (%d files)\n", sequentialMs, sequentialCount);
+
+    std::vector<std::string> parallelFiles;
+    Stopwatch                parallel;
+    int                      parallelCount =
+        fs.enumerateFilesRecursive(root, kExtensions, muggle::vfs::enumerate_to_vector(parallelFiles), false);
+    const double parallelMs = parallel.elapsedMilliseconds();
+    printf("parallel recursive:      %8.1f ms (%d files)\n", parallelMs, parallelCount);
+}
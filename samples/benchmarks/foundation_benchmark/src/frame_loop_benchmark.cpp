@@ -0,0 +1,86 @@
+#include "benchmark.h"
+
+#include "foundation/timer/frame_loop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr double kFrameRate = 240.0;
+constexpr int    kFrames    = 480;
+
+// Frames of a little work at kFrameRate, paced by 'waitFrame'; prints the jitter percentiles and the CPU time used
+template<typename FUNC>
+void measure(const char* name, const FUNC& waitFrame)
+{
+    std::vector<double> jitter;
+    jitter.reserve(kFrames);
+
+    const std::clock_t cpuStart = std::clock();
+    Stopwatch          stopwatch;
+    double             previous = 0.0;
+
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        waitFrame();
+
+        const double now = stopwatch.elapsedMilliseconds();
+        if (frame > 0)
+        {
+            jitter.push_back(std::abs(now - previous - 1000.0 / kFrameRate));
+        }
+        previous = now;
+
+        // the frame's work
+        const double workEnd = now + 1.0;
+        while (stopwatch.elapsedMilliseconds() < workEnd)
+        {
+        }
+    }
+
+    const double wallMs = stopwatch.elapsedMilliseconds();
+    const double cpuMs  = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    std::sort(jitter.begin(), jitter.end());
+    printf("%-14s jitter p50 %.3f ms, p99 %.3f ms, max %.3f ms, CPU %3.0f%%\n",
+           name,
+           jitter[jitter.size() / 2],
+           jitter[jitter.size() * 99 / 100],
+           jitter.back(),
+           100.0 * cpuMs / wallMs);
+}
+
+} // namespace
+
+void runFrameLoopBenchmark()
+{
+    printf("%d frames of 1 ms work at %.0f fps\n", kFrames, kFrameRate);
+
+    muggle::FrameLoop frameLoop;
+    frameLoop.setMaxFrameRate(kFrameRate);
+    measure("FrameLoop", [&frameLoop]() {
+        frameLoop.endFrame();
+        frameLoop.beginFrame();
+    });
+
+    const auto period   = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / kFrameRate));
+    auto       deadline = std::chrono::steady_clock::now();
+    measure("sleep_until", [&]() {
+        deadline += period;
+        std::this_thread::sleep_until(deadline);
+    });
+
+    deadline = std::chrono::steady_clock::now();
+    measure("spin", [&]() {
+        deadline += period;
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+        }
+    });
+}
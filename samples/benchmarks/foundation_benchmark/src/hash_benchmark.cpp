@@ -0,0 +1,132 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/content_store.h"
+#include "foundation/filesystem/memory_file_system.h"
+#include "foundation/hash/hash.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+void runThroughput()
+{
+    constexpr size_t kTotalBytes = size_t(1) << 30;
+
+    const size_t sizes[] = {64, 1024, 64 * 1024, 16 * 1024 * 1024};
+
+    std::vector<uint8_t> data(sizes[std::size(sizes) - 1]);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+    }
+
+    for (size_t size : sizes)
+    {
+        const size_t iterations = kTotalBytes / size;
+        uint64_t     sum        = 0;
+
+        Stopwatch stopwatch;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sum += muggle::hash::xxh3(data.data(), size, i);
+        }
+        const double ms = stopwatch.elapsedMilliseconds();
+
+        printf("xxh3 %9zu bytes: %7.2f GB/s, %8.1f ns/hash (%016llx)\n",
+               size,
+               static_cast<double>(kTotalBytes) / (ms * 1e6),
+               ms * 1e6 / static_cast<double>(iterations),
+               static_cast<unsigned long long>(sum));
+    }
+}
+
+// The same textures written under many names, as happens when assets are copied between packages
+void runDeduplication()
+{
+    constexpr int    kUniqueTextures = 8;
+    constexpr int    kCopies         = 16;
+    constexpr size_t kTextureSize    = 1024 * 1024;
+
+    std::vector<std::vector<uint8_t>> textures(kUniqueTextures, std::vector<uint8_t>(kTextureSize));
+    for (int t = 0; t < kUniqueTextures; ++t)
+    {
+        for (size_t i = 0; i < kTextureSize; ++i)
+        {
+            textures[t][i] = static_cast<uint8_t>((i + 1) * (t + 7) >> 3);
+        }
+    }
+
+    auto memoryFS = std::make_shared<muggle::vfs::MemoryFileSystem>();
+    auto objectFS = std::make_shared<muggle::vfs::MemoryFileSystem>();
+
+    muggle::vfs::ContentStore store(objectFS);
+
+    double plainMs = 0.0;
+    double storeMs = 0.0;
+
+    for (int copy = 0; copy < kCopies; ++copy)
+    {
+        for (int t = 0; t < kUniqueTextures; ++t)
+        {
+            std::string name = "package_" + std::to_string(copy) + "/texture_" + std::to_string(t) + ".ktx";
+
+            Stopwatch plain;
+            memoryFS->writeFile(name, textures[t].data(), kTextureSize);
+            plainMs += plain.elapsedMilliseconds();
+
+            Stopwatch stored;
+            store.writeFile(name, textures[t].data(), kTextureSize);
+            storeMs += stored.elapsedMilliseconds();
+        }
+    }
+
+    // read every copy back and keep them all, as a scene referencing each of them would
+    std::vector<std::shared_ptr<muggle::vfs::IBlob>> plainBlobs;
+    std::vector<std::shared_ptr<muggle::vfs::IBlob>> storeBlobs;
+    size_t                                           plainResident = 0;
+    size_t                                           storeResident = 0;
+
+    for (int copy = 0; copy < kCopies; ++copy)
+    {
+        for (int t = 0; t < kUniqueTextures; ++t)
+        {
+            std::string name = "package_" + std::to_string(copy) + "/texture_" + std::to_string(t) + ".ktx";
+
+            plainBlobs.push_back(memoryFS->readFile(name));
+            storeBlobs.push_back(store.readFile(name));
+        }
+    }
+
+    for (size_t i = 0; i < plainBlobs.size(); ++i)
+    {
+        plainResident += plainBlobs[i]->size();
+
+        bool shared = false;
+        for (size_t j = 0; j < i && !shared; ++j)
+        {
+            shared = storeBlobs[j].get() == storeBlobs[i].get();
+        }
+        storeResident += shared ? 0 : storeBlobs[i]->size();
+    }
+
+    const auto statistics = store.getStatistics();
+
+    printf("%d files, %d distinct contents of %zu KB\n", kCopies * kUniqueTextures, kUniqueTextures, kTextureSize / 1024);
+    printf("MemoryFileSystem: write %8.2f ms, %6zu KB in memory\n", plainMs, plainResident / 1024);
+    printf("ContentStore:     write %8.2f ms, %6zu KB in memory, %llu objects, %llu writes deduplicated\n",
+           storeMs,
+           storeResident / 1024,
+           static_cast<unsigned long long>(statistics.objects),
+           static_cast<unsigned long long>(statistics.dedupedFiles));
+}
+
+} // namespace
+
+void runHashBenchmark()
+{
+    runThroughput();
+    runDeduplication();
+}
@@ -0,0 +1,140 @@
+#include "benchmark.h"
+
+#include "foundation/log/binary_log_sink.h"
+#include "foundation/log/log_system.h"
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr int kCallsPerThread = 100000;
+
+// Average time of a log call, in nanoseconds, with 'threadCount' threads logging at once
+template<typename FUNC>
+double measure(int threadCount, const FUNC& logCall)
+{
+    std::vector<double>      elapsed(threadCount);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            const std::string name = "thread " + std::to_string(t);
+
+            Stopwatch stopwatch;
+            for (int i = 0; i < kCallsPerThread; ++i)
+            {
+                logCall(name, i);
+            }
+            elapsed[t] = stopwatch.elapsedMilliseconds();
+        });
+    }
+
+    double total = 0.0;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads[t].join();
+        total += elapsed[t];
+    }
+
+    return total * 1e6 / (double(threadCount) * kCallsPerThread);
+}
+
+// Time for the backend to write 'kBackendRecords' records with 'sinks', in nanoseconds per record
+double measureBackend(std::vector<spdlog::sink_ptr> sinks, std::shared_ptr<muggle::LogRecordSink> recordSink)
+{
+    constexpr int kBackendRecords = 200000;
+
+    muggle::LogSystem* engineLogger = muggle::gLoggerSystem;
+    muggle::gLoggerSystem           = new muggle::LogSystem(std::move(sinks), 64 * 1024 * 1024);
+    if (recordSink)
+    {
+        muggle::gLoggerSystem->addRecordSink(std::move(recordSink));
+    }
+
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBackendRecords; ++i)
+    {
+        LOG_INFO("frame {} took {:.2f} ms, {} draws of {}", i, i * 0.01, i % 1000, "opaque pass")
+    }
+    muggle::gLoggerSystem->flush();
+    const double elapsed = stopwatch.elapsedMilliseconds();
+
+    delete muggle::gLoggerSystem;
+    muggle::gLoggerSystem = engineLogger;
+
+    return elapsed * 1e6 / kBackendRecords;
+}
+
+} // namespace
+
+void runLogBenchmark()
+{
+    const int threadCounts[] = {1, 4, 8};
+
+    // every call is logged, and the arguments differ so no record is coalesced with the one before
+    muggle::LogCallSite::setRateLimit(0);
+
+    // log to a null sink, the sinks cost the same either way and only the logging threads are timed
+    muggle::LogSystem* engineLogger = muggle::gLoggerSystem;
+    muggle::gLoggerSystem =
+        new muggle::LogSystem({std::make_shared<spdlog::sinks::null_sink_mt>()}, 4 * 1024 * 1024);
+
+    // what LogSystem did before: spdlog's async logger formats on the calling thread
+    spdlog::init_thread_pool(8192, 1);
+    auto asyncLogger = std::make_shared<spdlog::async_logger>("log_benchmark",
+                                                              std::make_shared<spdlog::sinks::null_sink_mt>(),
+                                                              spdlog::thread_pool(),
+                                                              spdlog::async_overflow_policy::block);
+
+    printf("ns per call        deferred   spdlog async\n");
+
+    for (int threadCount : threadCounts)
+    {
+        const double deferredNs = measure(threadCount, [](const std::string& name, int i) {
+            LOG_INFO("{} frame {} took {:.2f} ms", name, i, i * 0.01)
+        });
+        muggle::gLoggerSystem->flush();
+
+        const double spdlogNs = measure(threadCount, [&](const std::string& name, int i) {
+            asyncLogger->info("{} frame {} took {:.2f} ms", name, i, i * 0.01);
+        });
+        asyncLogger->flush();
+
+        printf("%d thread(s)    %10.1f     %10.1f\n", threadCount, deferredNs, spdlogNs);
+    }
+
+    printf("dropped records: %llu\n", static_cast<unsigned long long>(muggle::gLoggerSystem->getDroppedCount()));
+
+    delete muggle::gLoggerSystem;
+    muggle::gLoggerSystem = engineLogger;
+
+    // formatting and writing text to a file, against copying the records to a binary file
+    const auto root = std::filesystem::temp_directory_path() / "muggle_log_benchmark";
+    std::filesystem::create_directories(root);
+
+    const double textNs = measureBackend(
+        {std::make_shared<spdlog::sinks::basic_file_sink_mt>((root / "text.log").string(), true)}, nullptr);
+    const double binaryNs = measureBackend({}, std::make_shared<muggle::BinaryLogSink>(root / "binary"));
+
+    printf("log and flush, ns per record: text file %.1f, binary file %.1f\n", textNs, binaryNs);
+
+    std::filesystem::remove_all(root);
+
+    // a call site spamming the log, past its first messages the calls are suppressed
+    muggle::LogCallSite::setRateLimit(muggle::LogCallSite::kDefaultRateLimit);
+
+    const double spamNs = measure(1, [](const std::string& name, int) {
+        LOG_ERROR("Read File: {} Failed!", name)
+    });
+    printf("rate limited call: %.1f ns\n", spamNs);
+}
@@ -0,0 +1,50 @@
+#include "benchmark.h"
+#include "muggle.h"
+
+#include <cstring>
+
+struct BenchmarkEntry
+{
+    const char* name;
+    void (*run)();
+};
+
+static const BenchmarkEntry benchmarks[] = {
+    {"async_read", runAsyncReadBenchmark},
+    {"mount", runMountBenchmark},
+    {"enumerate", runEnumerateBenchmark},
+    {"pattern", runPatternBenchmark},
+    {"hash", runHashBenchmark},
+    {"compressed", runCompressedBenchmark},
+    {"log", runLogBenchmark},
+    {"timer", runTimerBenchmark},
+    {"profiler", runProfilerBenchmark},
+    {"stats", runStatsBenchmark},
+    {"frame_loop", runFrameLoopBenchmark},
+};
+
+// Usage: foundation_benchmark [name...]
+// Runs every benchmark when no name is given
+int main(int argc, char** argv)
+{
+    muggle::init();
+
+    for (const auto& benchmark : benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+        {
+            selected |= strcmp(argv[i], benchmark.name) == 0;
+        }
+
+        if (selected)
+        {
+            printf("== %s\n", benchmark.name);
+            benchmark.run();
+        }
+    }
+
+    muggle::terminate();
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/memory_file_system.h"
+#include "foundation/filesystem/mount_table.h"
+#include "foundation/filesystem/pack_file_system.h"
+#include "foundation/filesystem/vfs.h"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Mount point resolution as VFileSystem did it before the mount table: normalize, then scan every mount
+static bool findMountPointLinear(const std::vector<std::pair<std::string, std::shared_ptr<muggle::vfs::IFileSystem>>>& mountPoints,
+                                 const std::filesystem::path&                                                         path,
+                                 std::filesystem::path* pRelativePath,
+                                 muggle::vfs::IFileSystem** ppFS)
+{
+    std::string spath = path.lexically_normal().generic_string();
+
+    for (auto mp : mountPoints)
+    {
+        if (spath.find(mp.first, 0) == 0 &&
+            ((spath.length() == mp.first.length()) || (spath[mp.first.length()] == '/')))
+        {
+            if (pRelativePath)
+            {
+                *pRelativePath = spath.substr(mp.first.size() + 1);
+            }
+            if (ppFS)
+            {
+                *ppFS = mp.second.get();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Find the file 'path' in 4 archives mounted at the same path, when only the bottom one has it: probing every
+// layer for each lookup against the VFS, which remembers the layer holding each file since archives never change.
+// Layers that may change behind the VFS's back, like the memory file systems, are probed by the VFS as well.
+static void runOverlayBenchmark()
+{
+    constexpr int kLayerCount = 4;
+    constexpr int kFileCount  = 1024;
+    constexpr int kIterations = 200000;
+
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "muggle_mount_benchmark";
+    std::filesystem::create_directories(root);
+
+    muggle::vfs::VFileSystem                                    vfs;
+    muggle::vfs::VFileSystem                                    mutableVFS;
+    std::vector<std::shared_ptr<muggle::vfs::IFileSystem>>      layers;
+    std::vector<std::shared_ptr<muggle::vfs::MemoryFileSystem>> mutableLayers;
+    std::vector<std::filesystem::path>                          paths;
+
+    for (int i = 0; i < kLayerCount; ++i)
+    {
+        const bool bottom = i == kLayerCount - 1;
+
+        muggle::vfs::PackBuilder builder;
+        mutableLayers.push_back(std::make_shared<muggle::vfs::MemoryFileSystem>());
+
+        for (int file = 0; file < (bottom ? kFileCount : 1); ++file)
+        {
+            std::string name = bottom ? "textures/albedo_" + std::to_string(file) + ".png"
+                                      : "patch_" + std::to_string(i) + ".txt";
+            auto        blob = std::make_shared<muggle::vfs::Blob>(calloc(1, 16), 16);
+
+            builder.addFile(name, blob);
+            mutableLayers.back()->addFile(name, blob);
+            if (bottom)
+            {
+                paths.emplace_back("/data/" + name);
+            }
+        }
+
+        const std::filesystem::path archivePath = root / ("layer_" + std::to_string(i) + ".mpak");
+
+        std::shared_ptr<muggle::vfs::PackFileSystem> archive;
+        if (builder.write(archivePath))
+        {
+            archive = muggle::vfs::PackFileSystem::open(archivePath);
+        }
+        if (!archive)
+        {
+            printf("cannot create %s, skipping the overlay benchmark\n", archivePath.string().c_str());
+            return;
+        }
+
+        layers.push_back(archive);
+        vfs.mount("/data", archive, kLayerCount - i);
+        mutableVFS.mount("/data", mutableLayers.back(), kLayerCount - i);
+    }
+
+    size_t found = 0;
+
+    Stopwatch probe;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        std::filesystem::path relativePath = paths[i % kFileCount].lexically_relative("/data");
+        for (const auto& layer : layers)
+        {
+            if (layer->isFileExists(relativePath))
+            {
+                ++found;
+                break;
+            }
+        }
+    }
+    const double probeMs = probe.elapsedMilliseconds();
+
+    Stopwatch resolved;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        found += vfs.isFileExists(paths[i % kFileCount]);
+    }
+    const double resolvedMs = resolved.elapsedMilliseconds();
+
+    Stopwatch probed;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        found += mutableVFS.isFileExists(paths[i % kFileCount]);
+    }
+    const double probedMs = probed.elapsedMilliseconds();
+
+    printf("%d layers, %d lookups (%zu found)\n", kLayerCount, kIterations, found);
+    printf("probe every layer:       %8.1f ns/lookup\n", probeMs * 1e6 / kIterations);
+    printf("resolved layer:          %8.1f ns/lookup\n", resolvedMs * 1e6 / kIterations);
+    printf("mutable layers, probed:  %8.1f ns/lookup\n", probedMs * 1e6 / kIterations);
+}
+
+// Resolve paths against 48 mount points, with and without building the relative path
+void runMountBenchmark()
+{
+    constexpr int kMountCount  = 48;
+    constexpr int kIterations  = 200000;
+
+    auto fs = std::make_shared<muggle::vfs::NativeFileSystem>();
+
+    std::vector<std::pair<std::string, std::shared_ptr<muggle::vfs::IFileSystem>>> mountPoints;
+    muggle::vfs::MountTable                                                        table;
+
+    for (int i = 0; i < kMountCount; ++i)
+    {
+        std::string mountPath = "/packages/package_" + std::to_string(i) + "/content";
+        mountPoints.emplace_back(mountPath, fs);
+        table.add(mountPath, fs);
+    }
+
+    std::vector<std::filesystem::path> paths;
+    for (int i = 0; i < kMountCount; ++i)
+    {
+        paths.emplace_back("/packages/package_" + std::to_string(i) + "/content/textures/albedo_" +
+                           std::to_string(i) + ".png");
+    }
+
+    size_t found = 0;
+
+    Stopwatch linear;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        std::filesystem::path     relativePath;
+        muggle::vfs::IFileSystem* result = nullptr;
+        found += findMountPointLinear(mountPoints, paths[i % kMountCount], &relativePath, &result);
+    }
+    const double linearMs = linear.elapsedMilliseconds();
+
+    Stopwatch trie;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        muggle::vfs::MountTable::Match match;
+        found += table.find(std::string_view(paths[i % kMountCount].native()), &match);
+    }
+    const double trieMs = trie.elapsedMilliseconds();
+
+    Stopwatch trieRelative;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        const auto&                    native = paths[i % kMountCount].native();
+        muggle::vfs::MountTable::Match match;
+        if (table.find(std::string_view(native), &match))
+        {
+            std::filesystem::path relativePath(std::string_view(native).substr(match.relativeOffset));
+            found += !relativePath.empty();
+        }
+    }
+    const double trieRelativeMs = trieRelative.elapsedMilliseconds();
+
+    printf("%d mounts, %d lookups (%zu found)\n", kMountCount, kIterations, found);
+    printf("linear scan:             %8.1f ns/lookup\n", linearMs * 1e6 / kIterations);
+    printf("mount table:             %8.1f ns/lookup\n", trieMs * 1e6 / kIterations);
+    printf("mount table + relative:  %8.1f ns/lookup\n", trieRelativeMs * 1e6 / kIterations);
+
+    runOverlayBenchmark();
+}
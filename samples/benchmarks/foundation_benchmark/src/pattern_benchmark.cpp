@@ -0,0 +1,113 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/file_pattern.h"
+
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// How file searches were expressed before FilePattern: a regex source built by getFileSearchRegex
+void appendPatternToRegex(const std::string& pattern, std::stringstream& regex)
+{
+    for (char c : pattern)
+    {
+        switch (c)
+        {
+            case '?':
+                regex << "[^/]?";
+                break;
+            case '*':
+                regex << "[^/]+";
+                break;
+            case '.':
+                regex << "\\.";
+                break;
+            default:
+                regex << c;
+        }
+    }
+}
+
+std::string getFileSearchRegex(const std::vector<std::string>& extensions)
+{
+    std::stringstream regex;
+    regex << "[^/]+";
+
+    regex << '(';
+    bool first = true;
+    for (const auto& ext : extensions)
+    {
+        if (!first)
+            regex << '|';
+        appendPatternToRegex(ext, regex);
+        first = false;
+    }
+    regex << ')';
+
+    return regex.str();
+}
+
+} // namespace
+
+// Match file names against a few extensions with std::regex and with FilePattern
+void runPatternBenchmark()
+{
+    constexpr int kNameCount  = 10000;
+    constexpr int kIterations = 20;
+
+    const std::vector<std::string> extensions = {".png", ".gltf", ".bin", ".sp?"};
+    const char* const              suffixes[] = {".png", ".gltf", ".bin", ".spv", ".txt", ".json", ".jpg", ".hdr"};
+
+    std::vector<std::string> names;
+    for (int i = 0; i < kNameCount; ++i)
+    {
+        names.push_back("asset_" + std::to_string(i) + "_albedo" + suffixes[i % std::size(suffixes)]);
+    }
+
+    size_t regexMatches = 0;
+
+    Stopwatch        regexCompile;
+    const std::regex regex(getFileSearchRegex(extensions));
+    const double     regexCompileUs = regexCompile.elapsedMilliseconds() * 1000.0;
+
+    Stopwatch regexMatch;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        for (const auto& name : names)
+        {
+            regexMatches += std::regex_match(name, regex);
+        }
+    }
+    const double regexMatchMs = regexMatch.elapsedMilliseconds();
+
+    size_t patternMatches = 0;
+
+    Stopwatch                      patternCompile;
+    const muggle::vfs::FilePattern pattern = muggle::vfs::FilePattern::fromExtensions(extensions);
+    const double                   patternCompileUs = patternCompile.elapsedMilliseconds() * 1000.0;
+
+    Stopwatch patternMatch;
+    for (int i = 0; i < kIterations; ++i)
+    {
+        for (const auto& name : names)
+        {
+            patternMatches += pattern.matches(name);
+        }
+    }
+    const double patternMatchMs = patternMatch.elapsedMilliseconds();
+
+    const int matchCount = kNameCount * kIterations;
+    printf("%d matches\n", matchCount);
+    printf("std::regex:   compile %8.1f us, %8.1f ns/match (%zu matched)\n",
+           regexCompileUs,
+           regexMatchMs * 1e6 / matchCount,
+           regexMatches);
+    printf("FilePattern:  compile %8.1f us, %8.1f ns/match (%zu matched)\n",
+           patternCompileUs,
+           patternMatchMs * 1e6 / matchCount,
+           patternMatches);
+}
@@ -0,0 +1,126 @@
+#include "benchmark.h"
+
+#include "foundation/profiler/profiler.h"
+#include "foundation/timer/timer.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace
+{
+
+constexpr int kFrames        = 100;
+constexpr int kZonesPerFrame = 10000;
+
+volatile uint64_t gSink = 0;
+
+void leafWork(int i)
+{
+    MUGGLE_PROFILE_ZONE("leaf")
+    gSink = gSink + static_cast<uint64_t>(i);
+}
+
+// Average cost of a zone in nanoseconds, from frames of 'kZonesPerFrame' zones
+double measureZones()
+{
+    Stopwatch stopwatch;
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        for (int i = 0; i < kZonesPerFrame; ++i)
+        {
+            leafWork(i);
+        }
+    }
+    return stopwatch.elapsedMilliseconds() * 1e6 / (double(kFrames) * kZonesPerFrame);
+}
+
+double measureBaseline()
+{
+    Stopwatch stopwatch;
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        for (int i = 0; i < kZonesPerFrame; ++i)
+        {
+            gSink = gSink + static_cast<uint64_t>(i);
+        }
+    }
+    return stopwatch.elapsedMilliseconds() * 1e6 / (double(kFrames) * kZonesPerFrame);
+}
+
+// The part of a zone that is reading the clock, twice
+double measureTickReads()
+{
+    Stopwatch stopwatch;
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        for (int i = 0; i < kZonesPerFrame; ++i)
+        {
+            gSink = gSink + muggle::Timer::getTicksFast();
+            gSink = gSink + muggle::Timer::getTicksFast();
+        }
+    }
+    return stopwatch.elapsedMilliseconds() * 1e6 / (double(kFrames) * kZonesPerFrame);
+}
+
+} // namespace
+
+void runProfilerBenchmark()
+{
+    const double baselineNs = measureBaseline();
+
+    muggle::Profiler::setEnabled(false);
+    const double disabledNs = measureZones() - baselineNs;
+
+    // a frame's worth of zones fits the thread's buffer, endFrame empties it
+    muggle::Profiler::setEnabled(true);
+    Stopwatch stopwatch;
+    double    endFrameMs = 0.0;
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        {
+            MUGGLE_PROFILE_ZONE("frame")
+            for (int i = 0; i < kZonesPerFrame; ++i)
+            {
+                leafWork(i);
+            }
+        }
+
+        Stopwatch endFrame;
+        muggle::Profiler::endFrame();
+        endFrameMs += endFrame.elapsedMilliseconds();
+    }
+    const double enabledNs =
+        (stopwatch.elapsedMilliseconds() - endFrameMs) * 1e6 / (double(kFrames) * kZonesPerFrame) - baselineNs;
+    muggle::Profiler::setEnabled(false);
+
+    const double tickReadsNs = measureTickReads() - baselineNs;
+
+    printf("zone overhead: disabled %.1f ns, enabled %.1f ns, of which %.1f ns reading the clock twice\n",
+           disabledNs,
+           enabledNs,
+           tickReadsNs);
+    printf("endFrame: %.3f ms for %d zones, %llu dropped\n",
+           endFrameMs / kFrames,
+           kZonesPerFrame,
+           static_cast<unsigned long long>(muggle::Profiler::getDroppedCount()));
+
+    for (const auto& stats : muggle::Profiler::getZoneStats(kFrames))
+    {
+        printf("  %-8s %8.0f calls %8.3f ms %8.3f ms self\n",
+               stats.site->name,
+               stats.callsPerFrame,
+               stats.milliseconds,
+               stats.selfMilliseconds);
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / "muggle_profiler_benchmark.json";
+
+    Stopwatch exportTime;
+    muggle::Profiler::exportChromeTrace(path);
+    printf("Chrome trace of %d frames: %.1f MB in %.1f ms\n",
+           kFrames,
+           static_cast<double>(std::filesystem::file_size(path)) / (1024 * 1024),
+           exportTime.elapsedMilliseconds());
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,102 @@
+#include "benchmark.h"
+
+#include "foundation/stats/stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr int kValuesPerThread = 1000000;
+
+MUGGLE_DEFINE_STAT(gBenchmarkStat)
+
+// Average time of a record, in nanoseconds, with 'threadCount' threads recording into the same stat at once
+double measureRecord(int threadCount)
+{
+    std::vector<double>      elapsed(threadCount);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            Stopwatch stopwatch;
+            for (int i = 0; i < kValuesPerThread; ++i)
+            {
+                gBenchmarkStat.record((static_cast<uint64_t>(i) * 2654435761u) & 0xfffff);
+            }
+            elapsed[t] = stopwatch.elapsedMilliseconds();
+        });
+    }
+
+    double total = 0.0;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads[t].join();
+        total += elapsed[t];
+    }
+
+    return total * 1e6 / (double(threadCount) * kValuesPerThread);
+}
+
+} // namespace
+
+void runStatsBenchmark()
+{
+    for (int threadCount : {1, 4, 8})
+    {
+        printf("record, %d thread(s): %.1f ns\n", threadCount, measureRecord(threadCount));
+    }
+
+    // percentiles of frame times with a long tail, against those of the sorted values
+    std::mt19937_64                     random(42);
+    std::lognormal_distribution<double> frameTicks(std::log(16.6e-3 * muggle::Timer().getFrequency()), 0.25);
+
+    std::vector<uint64_t> values(kValuesPerThread);
+    for (auto& value : values)
+    {
+        value = static_cast<uint64_t>(frameTicks(random));
+    }
+
+    // start the window afresh, with the values in its last interval
+    muggle::Stat::setIntervalSeconds(0.001);
+    for (size_t i = 0; i <= muggle::Stat::kWindowIntervals; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        muggle::Stat::update();
+    }
+    for (uint64_t value : values)
+    {
+        gBenchmarkStat.record(value);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    muggle::Stat::update();
+    muggle::Stat::setIntervalSeconds(muggle::Stat::kDefaultIntervalSeconds);
+
+    Stopwatch                 summaryTime;
+    const muggle::StatSummary summary = gBenchmarkStat.getSummary();
+    const double              summaryMs = summaryTime.elapsedMilliseconds();
+
+    std::sort(values.begin(), values.end());
+    const double millisecondsPerTick = 1000.0 / muggle::Timer().getFrequency();
+    auto         exact               = [&](double percentile) {
+        return static_cast<double>(values[static_cast<size_t>(std::ceil(percentile * values.size())) - 1]) *
+               millisecondsPerTick;
+    };
+
+    printf("p50 %.3f ms (exact %.3f), p95 %.3f ms (exact %.3f), p99 %.3f ms (exact %.3f)\n",
+           summary.p50,
+           exact(0.50),
+           summary.p95,
+           exact(0.95),
+           summary.p99,
+           exact(0.99));
+    printf("summary of %llu values over %zu intervals: %.3f ms\n",
+           static_cast<unsigned long long>(summary.count),
+           muggle::Stat::kWindowIntervals,
+           summaryMs);
+}
@@ -0,0 +1,90 @@
+#include "benchmark.h"
+
+#include "foundation/timer/timer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#ifndef _MSC_VER
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace
+{
+
+constexpr int kCalls = 10000000;
+
+// Average time of 'read', in nanoseconds. The values are summed so the calls are not optimized away.
+template<typename FUNC>
+double measure(const char* name, const FUNC& read)
+{
+    uint64_t  sum = 0;
+    Stopwatch stopwatch;
+    for (int i = 0; i < kCalls; ++i)
+    {
+        sum += static_cast<uint64_t>(read());
+    }
+    const double ns = stopwatch.elapsedMilliseconds() * 1e6 / kCalls;
+
+    printf("%-36s %6.1f ns  (%llu)\n", name, ns, static_cast<unsigned long long>(sum & 0xff));
+    return ns;
+}
+
+#ifndef _MSC_VER
+uint64_t readClock(clockid_t clock)
+{
+    timespec time;
+    clock_gettime(clock, &time);
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + static_cast<uint64_t>(time.tv_nsec);
+}
+#endif
+
+const char* getSourceName(muggle::Timer::Source source)
+{
+    switch (source)
+    {
+        case muggle::Timer::Source::QueryPerformanceCounter:
+            return "QueryPerformanceCounter";
+        case muggle::Timer::Source::MonotonicRaw:
+            return "CLOCK_MONOTONIC_RAW";
+        case muggle::Timer::Source::Tsc:
+            return "invariant TSC";
+        default:
+            return "unknown";
+    }
+}
+
+} // namespace
+
+void runTimerBenchmark()
+{
+    muggle::Timer timer;
+    printf("Timer source: %s, %.0f ticks per second\n",
+           getSourceName(muggle::Timer::getSource()),
+           timer.getFrequency());
+
+    // the calibration against a clock the Timer does not use
+    const auto start = std::chrono::steady_clock::now();
+    timer.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const double timerSeconds  = timer.getSeconds();
+    const double steadySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("200 ms sleep: Timer %.6f s, steady_clock %.6f s\n", timerSeconds, steadySeconds);
+
+    measure("Timer::getTicks", []() { return muggle::Timer::getTicks(); });
+    measure("Timer::getSeconds", [&timer]() { return timer.getSeconds() * 1e9; });
+    measure("std::chrono::steady_clock::now",
+            []() { return std::chrono::steady_clock::now().time_since_epoch().count(); });
+
+#ifndef _MSC_VER
+    measure("clock_gettime(CLOCK_MONOTONIC_RAW)", []() { return readClock(CLOCK_MONOTONIC_RAW); });
+    measure("clock_gettime(CLOCK_MONOTONIC)", []() { return readClock(CLOCK_MONOTONIC); });
+#if defined(__x86_64__) || defined(__i386__)
+    measure("rdtsc", []() { return __rdtsc(); });
+#endif
+#endif
+}
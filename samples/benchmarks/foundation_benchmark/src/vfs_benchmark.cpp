@@ -0,0 +1,69 @@
+#include "benchmark.h"
+
+#include "foundation/filesystem/vfs.h"
+
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+namespace muggle
+{
+extern vfs::VFileSystem* gFileSystem;
+}
+
+// Compare reading every file under content/ one by one against a single asynchronous batch.
+// Run it twice or drop the page cache in between to compare warm and cold reads.
+void runAsyncReadBenchmark()
+{
+    if (!muggle::gFileSystem->isFolderExists("/ROOT/content"))
+    {
+        printf("no content/ next to the executable, skipping the async read benchmark\n");
+        return;
+    }
+
+    const std::filesystem::path contentPath = muggle::gFileSystem->getFullPath("/ROOT/content");
+
+    // unreadable directories are skipped rather than ending the whole run
+    std::error_code                       ec;
+    std::vector<muggle::vfs::ReadRequest> requests;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(
+             contentPath, std::filesystem::directory_options::skip_permission_denied, ec))
+    {
+        if (entry.is_regular_file(ec))
+        {
+            std::filesystem::path relative = std::filesystem::relative(entry.path(), contentPath);
+            requests.push_back({std::filesystem::path("/ROOT/content") / relative});
+        }
+    }
+
+    size_t totalBytes = 0;
+
+    Stopwatch looped;
+    for (const auto& request : requests)
+    {
+        auto blob = muggle::gFileSystem->readFile(request.path);
+        if (blob)
+        {
+            totalBytes += blob->size();
+        }
+    }
+    const double loopedMs = looped.elapsedMilliseconds();
+
+    size_t asyncBytes = 0;
+
+    Stopwatch batched;
+    auto      futures = muggle::gFileSystem->readFilesAsync(requests);
+    for (auto& future : futures)
+    {
+        auto blob = future.get();
+        if (blob)
+        {
+            asyncBytes += blob->size();
+        }
+    }
+    const double batchedMs = batched.elapsedMilliseconds();
+
+    printf("%zu files, %zu bytes\n", requests.size(), totalBytes);
+    printf("looped readFile:  %8.3f ms\n", loopedMs);
+    printf("readFilesAsync:   %8.3f ms (%zu bytes)\n", batchedMs, asyncBytes);
+}
@@ -1,5 +1,6 @@
 #include "hello_triangle.h"
 #include "foundation/log/log_system.h"
+#include "foundation/timer/frame_loop.h"
 
 #include <algorithm>
 #include <optional>
@@ -907,9 +908,15 @@ void HelloTriangleApplication::createRenderPass()
 
 void HelloTriangleApplication::mainLoop()
 {
+    // nothing is presented yet to wait on, the cap keeps the loop from taking a whole core
+    muggle::FrameLoop frameLoop;
+    frameLoop.setMaxFrameRate(60.0);
+
     while (!glfwWindowShouldClose(window_))
     {
         glfwPollEvents();
+        frameLoop.beginFrame();
+        frameLoop.endFrame();
     }
 }
 
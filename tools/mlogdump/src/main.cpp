@@ -0,0 +1,216 @@
+#include "foundation/log/binary_log_sink.h"
+#include "muggle.h"
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void printUsage()
+{
+    printf("Usage: mlogdump [options] <file.mlog>...\n");
+    printf("Prints the messages of binary log files in time order.\n\n");
+    printf("Options:\n");
+    printf("  --json  print one JSON object per message, with the format string and the arguments\n");
+}
+
+static const char* getLevelName(muggle::LogSystem::LogLevel level)
+{
+    static const char* const names[] = {"debug", "info", "warning", "error", "critical"};
+
+    const size_t index = static_cast<size_t>(level);
+    return index < std::size(names) ? names[index] : "unknown";
+}
+
+static void appendJsonString(std::string& out, std::string_view text)
+{
+    out += '"';
+    for (char c : text)
+    {
+        switch (c)
+        {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                }
+                else
+                {
+                    out += c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+static std::string toJson(const muggle::binlog::Message& message)
+{
+    std::string json = "{\"time\":" + std::to_string(message.timestamp);
+    json += ",\"thread\":" + std::to_string(message.threadId);
+    json += ",\"level\":\"" + std::string(getLevelName(message.level)) + "\"";
+
+    json += ",\"category\":";
+    if (message.category.empty())
+    {
+        json += "null";
+    }
+    else
+    {
+        appendJsonString(json, message.category);
+    }
+
+    json += ",\"format\":";
+    appendJsonString(json, message.format);
+
+    json += ",\"args\":[";
+    bool first = true;
+    muggle::LogSystem::visitArgs(
+        message.argCount, message.args, message.args + message.argsSize, [&](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+
+            if (!first)
+            {
+                json += ',';
+            }
+            first = false;
+
+            if constexpr (std::is_same_v<T, bool>)
+                json += value ? "true" : "false";
+            else if constexpr (std::is_same_v<T, char>)
+                appendJsonString(json, std::string_view(&value, 1));
+            else if constexpr (std::is_same_v<T, std::string_view>)
+                appendJsonString(json, value);
+            else if constexpr (std::is_pointer_v<T>)
+                json += fmt::format("\"{}\"", value);
+            else if constexpr (std::is_floating_point_v<T>)
+                json += std::isfinite(value) ? fmt::format("{}", value) : "null";
+            else
+                json += std::to_string(value);
+        });
+    json += "],\"message\":";
+    appendJsonString(json, message.formatText());
+    json += '}';
+
+    return json;
+}
+
+static std::string toText(const muggle::binlog::Message& message)
+{
+    const time_t seconds = static_cast<time_t>(message.timestamp / 1000000000);
+
+    char time[32];
+    strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+
+    std::string text = fmt::format("[{}.{:09}] [{}] [thread {}] ",
+                                   time,
+                                   message.timestamp % 1000000000,
+                                   getLevelName(message.level),
+                                   message.threadId);
+    if (!message.category.empty())
+    {
+        text += fmt::format("[{}] ", message.category);
+    }
+    text += message.formatText();
+
+    return text;
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if (files.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // errors go to stderr, so that the output can be processed
+    muggle::gLoggerSystem = new muggle::LogSystem({std::make_shared<spdlog::sinks::stderr_color_sink_mt>()});
+
+    muggle::vfs::NativeFileSystem nativeFS;
+    int                           result = 0;
+
+    for (const char* file : files)
+    {
+        auto blob = nativeFS.readFile(file);
+        if (!blob)
+        {
+            result = 1;
+            continue;
+        }
+
+        muggle::binlog::Reader reader(blob->data(), blob->size());
+        if (!reader.isValid())
+        {
+            LOG_ERROR("{} is not a binary log file", file)
+            result = 1;
+            continue;
+        }
+
+        // the records of different threads are only in order per thread
+        std::vector<muggle::binlog::Message> messages;
+        muggle::binlog::Message              message;
+        while (reader.next(&message))
+        {
+            messages.push_back(message);
+        }
+
+        std::stable_sort(messages.begin(), messages.end(), [](const auto& a, const auto& b) {
+            return a.timestamp < b.timestamp;
+        });
+
+        for (const auto& each : messages)
+        {
+            const std::string line = json ? toJson(each) : toText(each);
+            printf("%s\n", line.c_str());
+        }
+
+        if (reader.isCorrupt())
+        {
+            LOG_ERROR("{} is corrupt after {} messages", file, messages.size())
+            result = 1;
+        }
+    }
+
+    delete muggle::gLoggerSystem;
+
+    return result;
+}
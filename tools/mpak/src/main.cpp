@@ -0,0 +1,86 @@
+#include "foundation/filesystem/pack_file_system.h"
+#include "muggle.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void printUsage()
+{
+    printf("Usage: mpak [options] <archive.mpak> <directory>\n");
+    printf("Packs every file under <directory> into <archive.mpak>.\n\n");
+    printf("Options:\n");
+    printf("  --zlib               compress entries that get smaller with zlib\n");
+    printf("  --alignment <bytes>  alignment of each entry in the archive (default %u)\n",
+           muggle::vfs::pack::kDefaultAlignment);
+}
+
+int main(int argc, char** argv)
+{
+    auto     codec     = muggle::compression::Codec::None;
+    uint32_t alignment = muggle::vfs::pack::kDefaultAlignment;
+
+    std::vector<const char*> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--zlib") == 0)
+        {
+            codec = muggle::compression::Codec::Zlib;
+        }
+        else if (strcmp(argv[i], "--alignment") == 0 && i + 1 < argc)
+        {
+            alignment = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    if (positional.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!muggle::compression::isCodecAvailable(codec))
+    {
+        printf("zlib support is not compiled in\n");
+        return 1;
+    }
+
+    muggle::init();
+
+    const std::filesystem::path archivePath = positional[0];
+    const std::filesystem::path sourcePath  = positional[1];
+
+    muggle::vfs::NativeFileSystem nativeFS;
+    muggle::vfs::PackBuilder      builder;
+    size_t                        fileCount = 0;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(sourcePath))
+    {
+        if (!entry.is_regular_file())
+            continue;
+
+        auto blob = nativeFS.readFile(entry.path());
+        if (!blob)
+        {
+            muggle::terminate();
+            return 1;
+        }
+
+        builder.addFile(std::filesystem::relative(entry.path(), sourcePath).generic_string(), std::move(blob), codec);
+        ++fileCount;
+    }
+
+    const bool succeeded = builder.write(archivePath, alignment);
+    if (succeeded)
+    {
+        LOG_INFO("Packed {} files into {}", fileCount, archivePath.string());
+    }
+
+    muggle::terminate();
+
+    return succeeded ? 0 : 1;
+}